@@ -155,45 +155,34 @@ void* TFT_eSprite::callocSprite(int16_t w, int16_t h, uint8_t frames)
   // Add one extra "off screen" pixel to point out-of-bounds setWindow() coordinates
   // this means push/writeColor functions do not need additional bounds checks and
   // hence will run faster in normal circumstances.
-  uint8_t* ptr8 = nullptr;
+  size_t bytes = 0;
+  bool psram = false;
 
   if (frames > 2) frames = 2; // Currently restricted to 2 frame buffers
   if (frames < 1) frames = 1;
 
+#if defined (ESP32) && defined (CONFIG_SPIRAM_SUPPORT)
+  psram = psramFound() && _psram_enable;
+#endif
+
   if (_bpp == 16)
   {
 #if defined (ESP32) && defined (CONFIG_SPIRAM_SUPPORT)
-    if ( psramFound() && _psram_enable && !_tft->DMA_Enabled)
-    {
-      ptr8 = ( uint8_t*) ps_calloc(frames * w * h + frames, sizeof(uint16_t));
-      //Serial.println("PSRAM");
-    }
-    else
+    if (_tft->DMA_Enabled) psram = false; // DMA needs Normal RAM
 #endif
-    {
-      ptr8 = ( uint8_t*) calloc(frames * w * h + frames, sizeof(uint16_t));
-      //Serial.println("Normal RAM");
-    }
+    bytes = (frames * w * h + frames) * sizeof(uint16_t);
   }
 
   else if (_bpp == 8)
   {
-#if defined (ESP32) && defined (CONFIG_SPIRAM_SUPPORT)
-    if ( psramFound() && _psram_enable ) ptr8 = ( uint8_t*) ps_calloc(frames * w * h + frames, sizeof(uint8_t));
-    else
-#endif
-    ptr8 = ( uint8_t*) calloc(frames * w * h + frames, sizeof(uint8_t));
+    bytes = frames * w * h + frames;
   }
 
   else if (_bpp == 4)
   {
     w = (w+1) & 0xFFFE; // width needs to be multiple of 2, with an extra "off screen" pixel
     _iwidth = w;
-#if defined (ESP32) && defined (CONFIG_SPIRAM_SUPPORT)
-    if ( psramFound() && _psram_enable ) ptr8 = ( uint8_t*) ps_calloc(((frames * w * h) >> 1) + frames, sizeof(uint8_t));
-    else
-#endif
-    ptr8 = ( uint8_t*) calloc(((frames * w * h) >> 1) + frames, sizeof(uint8_t));
+    bytes = ((frames * w * h) >> 1) + frames;
   }
 
   else // Must be 1 bpp
@@ -206,14 +195,55 @@ void* TFT_eSprite::callocSprite(int16_t w, int16_t h, uint8_t frames)
     _iwidth = w;         // _iwidth is rounded up to be multiple of 8, so might not be = _dwidth
     _bitwidth = w;       // _bitwidth will not be rotated whereas _iwidth may be
 
+    bytes = frames * (w>>3) * h + frames;
+  }
+
+  return callocMemory(bytes, psram);
+}
+
+
+/***************************************************************************************
+** Function name:           callocMemory
+** Description:             Allocate cleared memory, through the memory hooks if set
+***************************************************************************************/
+void* TFT_eSprite::callocMemory(size_t bytes, bool psram)
+{
+  if (_allocateHook)
+  {
+    void* ptr = _allocateHook(bytes, psram);
+    if (ptr) memset(ptr, 0, bytes);
+    return ptr;
+  }
+
 #if defined (ESP32) && defined (CONFIG_SPIRAM_SUPPORT)
-    if ( psramFound() && _psram_enable ) ptr8 = ( uint8_t*) ps_calloc(frames * (w>>3) * h + frames, sizeof(uint8_t));
-    else
+  if (psram) return ps_calloc(bytes, 1);
 #endif
-    ptr8 = ( uint8_t*) calloc(frames * (w>>3) * h + frames, sizeof(uint8_t));
-  }
+  return calloc(bytes, 1);
+}
 
-  return ptr8;
+
+/***************************************************************************************
+** Function name:           freeMemory
+** Description:             Free memory from callocMemory()
+***************************************************************************************/
+void TFT_eSprite::freeMemory(void* ptr)
+{
+  if (_releaseHook) _releaseHook(ptr);
+  else free(ptr);
+}
+
+
+/***************************************************************************************
+** Function name:           setMemoryHooks
+** Description:             Route the RAM of all Sprites through allocate and release
+***************************************************************************************/
+void* (*TFT_eSprite::_allocateHook)(size_t bytes, bool psram) = nullptr;
+void  (*TFT_eSprite::_releaseHook)(void* ptr) = nullptr;
+
+void TFT_eSprite::setMemoryHooks(void* (*allocate)(size_t bytes, bool psram), void (*release)(void* ptr))
+{
+  _allocateHook = allocate;
+  _releaseHook  = release;
 }
 
 
@@ -233,7 +263,7 @@ void TFT_eSprite::createPalette(uint16_t colorMap[], uint8_t colors)
   }
 
   // Allocate and clear memory for 16 color map
-  if (_colorMap == nullptr) _colorMap = (uint16_t *)calloc(16, sizeof(uint16_t));
+  if (_colorMap == nullptr) _colorMap = (uint16_t *)callocMemory(16 * sizeof(uint16_t), false);
 
   if (colors > 16) colors = 16;
 
@@ -260,7 +290,7 @@ void TFT_eSprite::createPalette(const uint16_t colorMap[], uint8_t colors)
   }
 
   // Allocate and clear memory for 16 color map
-  if (_colorMap == nullptr) _colorMap = (uint16_t *)calloc(16, sizeof(uint16_t));
+  if (_colorMap == nullptr) _colorMap = (uint16_t *)callocMemory(16 * sizeof(uint16_t), false);
 
   if (colors > 16) colors = 16;
 
@@ -374,13 +404,13 @@ void TFT_eSprite::deleteSprite(void)
 {
   if (_colorMap != nullptr)
   {
-    free(_colorMap);
+    freeMemory(_colorMap);
     _colorMap = nullptr;
   }
 
   if (_created)
   {
-    free(_img8_1);
+    freeMemory(_img8_1);
     _img8 = nullptr;
     _created = false;
     _vpOoB   = true;  // TFT_eSPI class write() uses this to check for valid sprite
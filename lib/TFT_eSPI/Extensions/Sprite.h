@@ -148,13 +148,27 @@ class TFT_eSprite : public TFT_eSPI {
            // Print indexed glyph to sprite using loaded font at x,y
   int16_t  printToSprite(int16_t x, int16_t y, uint16_t index);
 
+           // Route the RAM of all Sprites (frame buffers and 4-bit color maps) through allocate
+           // and release, e.g. to a memory pool, or back to calloc() and free() if both are nullptr.
+           // allocate gets the bytes needed and whether PSRAM would be used, the memory is cleared
+           // after. Set the hooks before creating Sprites, release also gets memory allocated before.
+  static void setMemoryHooks(void* (*allocate)(size_t bytes, bool psram), void (*release)(void* ptr));
+
  private:
 
   TFT_eSPI *_tft;
 
+           // Memory hooks shared by all Sprites
+  static void* (*_allocateHook)(size_t bytes, bool psram);
+  static void  (*_releaseHook)(void* ptr);
+
            // Reserve memory for the Sprite and return a pointer
   void*    callocSprite(int16_t width, int16_t height, uint8_t frames = 1);
 
+           // Allocate cleared memory and free it, through the memory hooks if set
+  void*    callocMemory(size_t bytes, bool psram);
+  void     freeMemory(void* ptr);
+
            // Override the non-inlined TFT_eSPI functions
   void     begin_nin_write(void) { ; }
   void     end_nin_write(void) { ; }
@@ -0,0 +1,154 @@
+/*
+
+	Example of use of the FFT library to switch the analysis at runtime
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, one STFT, WelchPSD and ArduinoFFT switch a test signal of
+  tones at 100, 50 and 2 Hz, sampled at 1000 Hz, between frame sizes of 256
+  to 2048 samples and two windows without being rebuilt, as the analyzer does
+  when the frame size or window is changed from the serial console. The
+  first frame after clearing the plans, which builds the plan and the window
+  factors, is timed against the switch itself with both prepared beforehand:
+  setFrameSize(), setHop() and setBins(). Then 10000 samples are streamed
+  at the new size and the time per frame is printed. The strongest bin of
+  the averaged spectrum must be within one bin of the 100 Hz tone.
+*/
+
+#include "arduinoFFT.h"
+#include "stft.h"
+#include "welchPSD.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //Largest frame size. This value MUST ALWAYS be a power of 2
+const float samplingFrequency = 1000;
+const uint16_t signalLength = 10000; // Samples streamed per frame size
+const float toneFrequency = 100; // Strongest tone of the signal
+
+/*
+These are the input and output vectors
+*/
+float vReal[samples];
+float vHistory[samples]; // STFT ring
+float vAccumulator[samples / 2 + 1];
+float vWindowFactors[samples]; // Half windows of the plan in use and of the next one
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>();
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  SwitchAnalysis();
+  while(1); /* Run Once */
+}
+
+void SwitchAnalysis()
+{
+  const uint16_t sizes[] = {2048, 256, 1024, 512};
+  const FFTWindow windows[] = {FFTWindow::Hann, FFTWindow::Hamming};
+  STFT<float> stft(vHistory, samples, samples, samples / 4);
+  WelchPSD<float> welch(vAccumulator, samples / 2 + 1, FFTAveraging::Exponential);
+  for (uint8_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++)
+  {
+    uint16_t size = sizes[k];
+    FFTWindow window = windows[k % 2];
+    float *factors = vWindowFactors + (k % 2) * (samples / 2);
+    /* From scratch: plan and window factors built with the first frame */
+    FFTPlan<float>::clear();
+    for (uint16_t i = 0; i < size; i++)
+    {
+      vReal[i] = SineSignal(i);
+    }
+    unsigned long start = micros();
+    FFT.prepare(vReal, size, window, 0, factors);
+    FFT.computeReal(vReal, size, true);
+    unsigned long cold = micros() - start;
+    /* Prepared: only counts change at the frame boundary */
+    start = micros();
+    stft.setFrameSize(size);
+    stft.setHop(size / 4);
+    stft.discard();
+    welch.setBins(size / 2 + 1);
+    unsigned long change = micros() - start;
+    float gain = ArduinoFFT<float>::coherentScale(window, size);
+    uint16_t count = 0;
+    float mean = 0;
+    unsigned long frames = 0;
+    for (uint16_t i = 0; i < signalLength; i++)
+    {
+      stft.push(SineSignal(i));
+      if (stft.frameReady())
+      {
+        start = micros();
+        stft.nextFrame(vReal, &mean);
+        FFT.prepare(vReal, size, FFTWindow::Precompiled, mean, factors);
+        FFT.computeReal(vReal, size, true);
+        welch.addReal(vReal);
+        frames += micros() - start;
+        count++;
+      }
+    }
+    welch.spectrum(vReal, FFTScale::Magnitude, gain);
+    uint16_t peak = 1;
+    for (uint16_t i = 2; i <= size / 2; i++)
+    {
+      if (vReal[i] > vReal[peak])
+      {
+        peak = i;
+      }
+    }
+    Serial.print(size);
+    Serial.print(" samples, ");
+    Serial.print(k % 2 ? "Hamming" : "Hann");
+    Serial.print(": first frame from scratch ");
+    Serial.print(cold);
+    Serial.print(" us, switch ");
+    Serial.print(change);
+    Serial.print(" us, then ");
+    Serial.print(float(frames) / count, 1);
+    Serial.print(" us per frame; strongest bin ");
+    Serial.print(peak * samplingFrequency / size, 2);
+    Serial.print(" Hz");
+    Serial.println(fabs(peak * samplingFrequency / size - toneFrequency) <= samplingFrequency / size ? " PASS" : " FAIL");
+  }
+}
@@ -0,0 +1,140 @@
+/*
+
+	Example of use of the FFT library with cached plans, benchmarked on a host
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, which runs on a Linux or other host rather than a board,
+  a sine of 50 Hz sampled at 1000 Hz is transformed repeatedly at sizes from
+  256 to 4096 points with each kernel, and the average time per transform is
+  printed. The Recurrence kernel derives its twiddle factors and bit reversal
+  on every call, as the library did before plans; the Radix2 kernel reads
+  them from a plan built once on first use, whose cost is printed separately,
+  and the Radix4 kernel merges pairs of radix-2 stages over the same plan. The
+  vector kernels are switched off, so only the setup differs. Every result is
+  compared with the transform in double precision: the plan kernels must
+  match it to float rounding, while the error of the recurrence grows with
+  the size. Build and run it with make in this folder.
+*/
+
+#include "arduinoFFT.h"
+#include "fftSIMD.h"
+#include <chrono>
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t minSamples = 256; //These values MUST ALWAYS be powers of 2
+const uint16_t maxSamples = 4096;
+const float signalFrequency = 50;
+const float samplingFrequency = 1000;
+const uint8_t amplitude = 100;
+const uint16_t runs = 200;
+const float tolerance = 1e-5; // Relative to the largest magnitude, for the plan kernels
+
+/*
+These are the input and output vectors
+Input vectors receive computed results from FFT
+*/
+float vReal[maxSamples];
+float vImag[maxSamples];
+double vRealExact[maxSamples];
+double vImagExact[maxSamples];
+
+/* Create FFT objects */
+ArduinoFFT<float> FFT = ArduinoFFT<float>();
+ArduinoFFT<double> exactFFT = ArduinoFFT<double>();
+
+/* Microseconds since the program started, as on the board */
+float micros()
+{
+  static const auto begin = std::chrono::steady_clock::now();
+  return std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void BuildData(uint16_t samples)
+{
+  float ratio = twoPi * signalFrequency / samplingFrequency; // Fraction of a complete cycle stored at each sample (in radians)
+  for (uint16_t i = 0; i < samples; i++)
+  {
+    vReal[i] = amplitude * sin(i * ratio) / 2.0;
+    vImag[i] = 0.0;
+  }
+}
+
+/* Largest difference to the double precision transform, relative to the
+largest magnitude */
+float CompareExact(uint16_t samples)
+{
+  double largest = 0;
+  double difference = 0;
+  for (uint16_t i = 0; i < samples; i++)
+  {
+    largest = fmax(largest, hypot(vRealExact[i], vImagExact[i]));
+    difference = fmax(difference, hypot(vReal[i] - vRealExact[i], vImag[i] - vImagExact[i]));
+  }
+  return difference / largest;
+}
+
+void Benchmark(const char *name, FFTKernel kernel, uint16_t samples)
+{
+  FFT.setKernel(kernel);
+  float total = 0;
+  for (uint16_t run = 0; run < runs; run++)
+  {
+    BuildData(samples);
+    float start = micros();
+    FFT.compute(vReal, vImag, samples, FFTDirection::Forward);
+    total += micros() - start;
+  }
+  float error = CompareExact(samples);
+  printf("  %-10s %8.2f us per transform, relative error %.2e", name, total / runs, error);
+  if (kernel == FFTKernel::Recurrence)
+  {
+    printf("\n");
+  }
+  else
+  {
+    printf(" %s\n", error <= tolerance ? "PASS" : "FAIL");
+  }
+}
+
+int main()
+{
+  simdSetInstructionSet(FFTInstructionSet::Scalar);
+  for (uint16_t samples = minSamples; samples <= maxSamples; samples <<= 1)
+  {
+    BuildData(samples);
+    for (uint16_t i = 0; i < samples; i++)
+    {
+      vRealExact[i] = vReal[i];
+      vImagExact[i] = 0.0;
+    }
+    exactFFT.compute(vRealExact, vImagExact, samples, FFTDirection::Forward);
+    /* The first call with a plan kernel builds the plan. Each size starts
+    from an empty cache, so its plan is kept like that of a fixed size. */
+    FFTPlan<float>::clear();
+    FFT.setKernel(FFTKernel::Radix2);
+    float start = micros();
+    FFT.compute(vReal, vImag, samples, FFTDirection::Forward);
+    printf("%u points, first call with the plan build %.2f us\n", samples, micros() - start);
+    Benchmark("Recurrence", FFTKernel::Recurrence, samples);
+    Benchmark("Radix2", FFTKernel::Radix2, samples);
+    Benchmark("Radix4", FFTKernel::Radix4, samples);
+  }
+  return 0;
+}
@@ -0,0 +1,148 @@
+/*
+
+	Example of use of the FFT library to follow single bins sample by sample
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, a BinTracker follows five bins of a 2048 point DFT through
+  five blocks of 2048 samples of a sine and an EKG like test signal, one
+  sample at a time. After the last sample its magnitudes are compared with the
+  same bins of a rectangular window FFT of the last block. The damping that
+  keeps the sliding DFT stable scales them down by about 0.1 %, so a deviation
+  of up to 1 % of the strongest tracked bin passes. Bins with hardly any
+  signal, such as the Nyquist bin of the tones, are thus held to the same
+  absolute limit as the others. The time per sample is printed.
+*/
+
+#include "arduinoFFT.h"
+#include "binTracker.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //This value MUST ALWAYS be a power of 2
+const float samplingFrequency = 1000;
+const uint16_t blocks = 5; // Of samples values each
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+const uint16_t trackedBins[] = {1, 60, 120, 511, 1024}; // DFT bins followed by the BinTracker
+const float tolerance = 0.01; // Relative to the strongest tracked bin of the FFT
+
+/*
+These are the input and output vectors
+Input vectors receive computed results from FFT
+*/
+float vReal[samples];
+float vImag[samples];
+float vHistory[samples];
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>(vReal, vImag, samples, samplingFrequency);
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  TrackBins("Sine test signal", SineSignal);
+  TrackBins("EKG test signal", EkgSignal);
+  while(1); /* Run Once */
+}
+
+void TrackBins(const char *name, float (*signal)(uint32_t n))
+{
+  BinTracker<float> tracker = BinTracker<float>(vHistory, samples, samplingFrequency);
+  for (uint8_t bin = 0; bin < sizeof(trackedBins) / sizeof(trackedBins[0]); bin++)
+  {
+    tracker.addBin(trackedBins[bin] * samplingFrequency / samples);
+  }
+  unsigned long duration = 0;
+  for (uint16_t block = 0; block < blocks; block++)
+  {
+    for (uint16_t i = 0; i < samples; i++)
+    {
+      vReal[i] = signal(uint32_t(block) * samples + i);
+    }
+    unsigned long start = micros();
+    for (uint16_t i = 0; i < samples; i++)
+    {
+      tracker.update(vReal[i]);
+    }
+    duration += micros() - start;
+  }
+  /* Reference: rectangular window FFT of the last block, still in vReal */
+  for (uint16_t i = 0; i < samples; i++)
+  {
+    vImag[i] = 0.0;
+  }
+  FFT.compute(FFTDirection::Forward);
+  FFT.complexToMagnitude();
+  float strongest = 0;
+  float worst = 0;
+  for (uint8_t bin = 0; bin < tracker.bins(); bin++)
+  {
+    strongest = max(strongest, vReal[trackedBins[bin]]);
+    worst = max(worst, (float)fabs(tracker.magnitude(bin) - vReal[trackedBins[bin]]));
+  }
+  worst /= strongest;
+  Serial.print(name);
+  Serial.print(": BinTracker ");
+  Serial.print(1000.0 * duration / (uint32_t(blocks) * samples), 1);
+  Serial.print(" ns per sample for ");
+  Serial.print(tracker.bins());
+  Serial.print(" bins, largest deviation from the FFT ");
+  Serial.print(100.0 * worst, 2);
+  Serial.print(" %");
+  Serial.println(worst <= tolerance ? " PASS" : " FAIL");
+}
@@ -0,0 +1,201 @@
+/*
+
+	Example of use of the FFT library to zoom into a narrow band
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, a ChirpZ evaluates the spectrum of 1024 samples of a sine
+  and an EKG like test signal at 420 points between the bins on either side
+  of the strongest one. The chirp-Z
+  transform costs two power of two transforms of the work size, here 2048
+  points, for any band and spacing. configure() keeps the chirp and filter
+  of recent bands, so switching back to one costs almost nothing: the time of
+  the first configuration and of one from the cache are printed. The time per
+  transform is compared with direct sums at the same frequencies, which the
+  chirp-Z result must match within 1e-4 of the strongest point.
+*/
+
+#include "arduinoFFT.h"
+#include "chirpZ.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; // Work size, at least length + points - 1
+const uint16_t length = 1024; // Samples of the frame, a power of 2
+const uint16_t points = 420; // Frequencies evaluated in the band
+const uint16_t runs = 20;
+const float tolerance = 1e-4; // Relative to the strongest point
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+
+/*
+These are the input and output vectors
+Input vectors receive computed results from FFT
+*/
+float vReal[samples];
+float vImag[samples];
+float vFrame[length]; // Test signal with its mean removed
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>();
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  ChirpZBand("Sine test signal", SineSignal, 1000);
+  ChirpZBand("EKG test signal", EkgSignal, 200);
+  while(1); /* Run Once */
+}
+
+void ChirpZBand(const char *name, float (*signal)(uint32_t n), float samplingFrequency)
+{
+  float binWidth = samplingFrequency / length;
+  float mean = 0;
+  for (uint16_t i = 0; i < length; i++)
+  {
+    vFrame[i] = signal(i);
+    mean += vFrame[i];
+  }
+  mean /= length;
+  /* Strongest bin of a plain transform of the frame */
+  for (uint16_t i = 0; i < length; i++)
+  {
+    vFrame[i] -= mean;
+    vReal[i] = vFrame[i];
+    vImag[i] = 0;
+  }
+  FFT.compute(vReal, vImag, length, FFTDirection::Forward);
+  FFT.complexToMagnitude(vReal, vImag, length);
+  uint16_t bin = 1;
+  for (uint16_t i = 2; i < length / 2 - 1; i++)
+  {
+    if (vReal[i] > vReal[bin])
+    {
+      bin = i;
+    }
+  }
+  float startFrequency = (bin - 1) * binWidth;
+  float endFrequency = (bin + 1) * binWidth;
+  /* First build, another band, then the first band again from the cache */
+  ChirpZ<float> chirpZ;
+  unsigned long start = micros();
+  if (!chirpZ.configure(length, points, startFrequency, endFrequency, samplingFrequency))
+  {
+    Serial.println("Chirp-Z: out of memory");
+    return;
+  }
+  unsigned long build = micros() - start;
+  chirpZ.configure(length, points, 0, samplingFrequency / 2, samplingFrequency);
+  start = micros();
+  chirpZ.configure(length, points, startFrequency, endFrequency, samplingFrequency);
+  unsigned long cached = micros() - start;
+  unsigned long transform = 0;
+  for (uint16_t run = 0; run < runs; run++)
+  {
+    for (uint16_t i = 0; i < chirpZ.workSize(); i++)
+    {
+      vReal[i] = (i < length) ? vFrame[i] : 0;
+      vImag[i] = 0;
+    }
+    start = micros();
+    chirpZ.compute(vReal, vImag);
+    transform += micros() - start;
+  }
+  /* Direct sums at the same frequencies */
+  float error = 0;
+  float largest = 0;
+  uint16_t strongest = 0;
+  start = micros();
+  for (uint16_t point = 0; point < points; point++)
+  {
+    float step = twoPi * chirpZ.frequency(point) / samplingFrequency;
+    float re = 0;
+    float im = 0;
+    for (uint16_t n = 0; n < length; n++)
+    {
+      re += vFrame[n] * cos(step * n);
+      im -= vFrame[n] * sin(step * n);
+    }
+    float magnitude = sqrt(sq(re) + sq(im));
+    error = max(error, float(sqrt(sq(vReal[point] - re) + sq(vImag[point] - im))));
+    if (magnitude > largest)
+    {
+      largest = magnitude;
+      strongest = point;
+    }
+  }
+  unsigned long direct = micros() - start;
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(startFrequency, 2);
+  Serial.print(" to ");
+  Serial.print(endFrequency, 2);
+  Serial.print(" Hz, configured in ");
+  Serial.print(build);
+  Serial.print(" us, from the cache in ");
+  Serial.print(cached);
+  Serial.print(" us; chirp-Z ");
+  Serial.print(float(transform) / runs, 1);
+  Serial.print(" us, direct ");
+  Serial.print(direct);
+  Serial.print(" us, difference ");
+  Serial.print(error / largest, 6);
+  Serial.print("; strongest point ");
+  Serial.print(chirpZ.frequency(strongest), 3);
+  Serial.print(" Hz");
+  Serial.println(error / largest <= tolerance ? " PASS" : " FAIL");
+}
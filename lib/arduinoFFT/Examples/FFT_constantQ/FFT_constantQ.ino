@@ -0,0 +1,196 @@
+/*
+
+	Example of use of the FFT library to compute a constant-Q spectrum
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, a ConstantQ stage maps the spectrum of 2048 samples of a
+  sine and an EKG like test signal to 12 bands per octave, from 4 Hz to a quarter of the sampling frequency.
+  Each band correlates the frame with a Hann windowed complex exponential of
+  the same number of cycles. configure() transforms these kernels once and
+  keeps only their larger values, so each frame costs one computeReal() and a
+  sparse product. The number of stored values and the build time are printed
+  with the time per frame, next to a direct correlation with every kernel.
+  Dropping the values below 1 % of the peak of their band bounds the
+  difference between the two; up to 2 % of the strongest band passes.
+*/
+
+#include "arduinoFFT.h"
+#include "constantQ.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //This value MUST ALWAYS be a power of 2
+const uint16_t runs = 20;
+const uint16_t maxBands = 128;
+const float tolerance = 0.02; // Relative to the strongest band
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+
+/*
+These are the input and output vectors
+*/
+float vReal[samples];
+float vFrame[samples]; // Test signal with its mean removed
+float vBandReal[maxBands];
+float vBandImag[maxBands];
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>();
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  ConstantQBands("Sine test signal", SineSignal, 1000);
+  ConstantQBands("EKG test signal", EkgSignal, 200);
+  while(1); /* Run Once */
+}
+
+void ConstantQBands(const char *name, float (*signal)(uint32_t n), float samplingFrequency)
+{
+  ConstantQ<float> constantQ;
+  unsigned long start = micros();
+  if (!constantQ.configure(samples, samplingFrequency, 4, samplingFrequency / 4, 12))
+  {
+    Serial.println("Constant-Q: out of memory");
+    return;
+  }
+  unsigned long build = micros() - start;
+  uint16_t bands = constantQ.bands();
+  /* Sparse product on the unwindowed spectrum of the frame */
+  float mean = 0;
+  for (uint16_t i = 0; i < samples; i++)
+  {
+    vFrame[i] = signal(i);
+    mean += vFrame[i];
+  }
+  mean /= samples;
+  for (uint16_t i = 0; i < samples; i++)
+  {
+    vFrame[i] -= mean;
+  }
+  unsigned long transform = 0;
+  unsigned long product = 0;
+  for (uint16_t run = 0; run < runs; run++)
+  {
+    for (uint16_t i = 0; i < samples; i++)
+    {
+      vReal[i] = vFrame[i];
+    }
+    start = micros();
+    FFT.computeReal(vReal, samples);
+    transform += micros() - start;
+    start = micros();
+    constantQ.transform(vReal, vBandReal, vBandImag);
+    product += micros() - start;
+  }
+  /* Direct correlation with the same Hann windowed kernels */
+  float error = 0;
+  float largest = 0;
+  uint16_t strongest = 0;
+  start = micros();
+  for (uint16_t band = 0; band < bands; band++)
+  {
+    float frequency = constantQ.frequency(band);
+    uint16_t length = ceil(constantQ.q() * samplingFrequency / frequency);
+    if (length > samples)
+    {
+      length = samples;
+    }
+    uint16_t offset = (samples - length) / 2;
+    float sum = 0;
+    float re = 0;
+    float im = 0;
+    for (uint16_t n = 0; n < length; n++)
+    {
+      float weight = 1.0 - cos(twoPi * (n + 0.5) / length);
+      float phase = twoPi * frequency * (offset + n) / samplingFrequency;
+      sum += weight / 2;
+      re += vFrame[offset + n] * weight * cos(phase);
+      im -= vFrame[offset + n] * weight * sin(phase);
+    }
+    float magnitude = sqrt(sq(re) + sq(im)) / sum;
+    float difference = sqrt(sq(vBandReal[band] - re / sum) + sq(vBandImag[band] - im / sum));
+    error = max(error, difference);
+    if (magnitude > largest)
+    {
+      largest = magnitude;
+      strongest = band;
+    }
+  }
+  unsigned long direct = micros() - start;
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(bands);
+  Serial.print(" bands, ");
+  Serial.print(constantQ.nonZeros());
+  Serial.print(" kernel values built in ");
+  Serial.print(build / 1000.0, 1);
+  Serial.print(" ms; FFT ");
+  Serial.print(float(transform) / runs, 1);
+  Serial.print(" us + sparse product ");
+  Serial.print(float(product) / runs, 1);
+  Serial.print(" us, direct ");
+  Serial.print(direct);
+  Serial.print(" us, difference ");
+  Serial.print(error / largest, 5);
+  Serial.print("; strongest band ");
+  Serial.print(constantQ.frequency(strongest), 2);
+  Serial.print(" Hz at ");
+  Serial.print(largest, 3);
+  Serial.println(error / largest <= tolerance ? " PASS" : " FAIL");
+}
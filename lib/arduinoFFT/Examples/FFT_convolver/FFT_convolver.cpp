@@ -0,0 +1,173 @@
+/*
+
+	Example of use of the FFT library to find where block FIR filtering pays off
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, which runs on a Linux or other host rather than a board,
+  a test signal of two tones in pseudo-random noise is filtered with Hamming
+  shaped low pass FIR filters of 8 to 512 taps, once by direct convolution and
+  once by the overlap-save Convolver, with transforms of about four times the
+  filter length. The time per output sample of both methods is printed, and
+  the crossover, the first tap count from which the Convolver stays faster,
+  is reported at the end. The outputs of both methods must match the direct
+  sums evaluated in double precision, relative to the input amplitude, since
+  the longest filters leave little of either tone. Build and run it with make
+  in this folder.
+*/
+
+#include "arduinoFFT.h"
+#include "convolver.h"
+#include <chrono>
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t minTaps = 8;
+const uint16_t maxTaps = 512;
+const uint16_t maxSamples = 2048; // Transform size for maxTaps
+const uint16_t outputs = 8192; // Output samples compared
+const uint16_t runs = 20;
+const float samplingFrequency = 1000;
+const float tolerance = 1e-5; // Relative to the largest input
+
+/*
+These are the input and output vectors
+*/
+float vInput[maxTaps + outputs + maxSamples]; // Whole blocks
+float vResponse[maxSamples];
+float vBuffer[maxSamples];
+float vHistory[maxSamples >> 1];
+float vDirect[outputs];
+double vExact[outputs];
+float vOutput[maxTaps + outputs + maxSamples];
+float coefficients[maxTaps];
+
+/* Microseconds since the program started, as on the board */
+float micros()
+{
+  static const auto begin = std::chrono::steady_clock::now();
+  return std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - begin).count();
+}
+
+float largest = 0;
+
+/* Tones at 5 and 150 Hz, the low pass filters keep the first one */
+void BuildData()
+{
+  srand(1);
+  for (uint32_t i = 0; i < sizeof(vInput) / sizeof(vInput[0]); i++)
+  {
+    float noise = float(rand()) / RAND_MAX - 0.5;
+    vInput[i] = sin(twoPi * 5 * i / samplingFrequency) + 0.5 * sin(twoPi * 150 * i / samplingFrequency) + 0.2 * noise;
+    largest = fmax(largest, fabs(vInput[i]));
+  }
+}
+
+/* Returns whether the Convolver was faster */
+bool ConvolveTaps(uint16_t taps)
+{
+  /* Transforms of about four times the filter length amortize best */
+  uint16_t size = 64;
+  while (size < 4 * taps)
+  {
+    size <<= 1;
+  }
+  for (uint16_t k = 0; k < taps; k++)
+  {
+    coefficients[k] = ArduinoFFT<float>::weighingFactor(FFTWindow::Hamming, k, taps) / taps;
+  }
+  /* Direct form, each output from the last taps inputs */
+  float start = micros();
+  for (uint16_t run = 0; run < runs; run++)
+  {
+    for (uint16_t n = taps; n < taps + outputs; n++)
+    {
+      float sum = 0;
+      for (uint16_t k = 0; k < taps; k++)
+      {
+        sum += coefficients[k] * vInput[n - k];
+      }
+      vDirect[n - taps] = sum;
+    }
+  }
+  float direct = (micros() - start) * 1000.0 / (runs * outputs);
+  for (uint16_t n = taps; n < taps + outputs; n++)
+  {
+    double sum = 0;
+    for (uint16_t k = 0; k < taps; k++)
+    {
+      sum += double(coefficients[k]) * vInput[n - k];
+    }
+    vExact[n - taps] = sum;
+  }
+  /* Overlap-save blocks, each run starting from an empty history */
+  Convolver<float> convolver = Convolver<float>(vResponse, vBuffer, vHistory, size);
+  convolver.setFilter(coefficients, taps);
+  uint16_t block = convolver.blockSize();
+  uint32_t produced = 0;
+  start = micros();
+  for (uint16_t run = 0; run < runs; run++)
+  {
+    convolver.reset();
+    produced = 0;
+    for (uint32_t n = 0; produced < uint32_t(taps + outputs); n += block)
+    {
+      convolver.process(&vInput[n], &vOutput[produced]);
+      produced += block;
+    }
+  }
+  float blocks = (micros() - start) * 1000.0 / (runs * produced);
+  double directError = 0;
+  double blockError = 0;
+  for (uint16_t n = 0; n < outputs; n++)
+  {
+    directError = fmax(directError, fabs(vDirect[n] - vExact[n]));
+    blockError = fmax(blockError, fabs(vOutput[taps + n] - vExact[n]));
+  }
+  float error = fmax(directError, blockError) / largest;
+  printf("FIR %3u taps: direct %6.1f ns, overlap-save (%4u points) %6.1f ns per output, relative error %.2e %s\n", taps,
+         direct, size, blocks, error, error <= tolerance ? "PASS" : "FAIL");
+  return blocks < direct;
+}
+
+int main()
+{
+  BuildData();
+  uint16_t crossover = 0;
+  for (uint16_t taps = minTaps; taps <= maxTaps; taps <<= 1)
+  {
+    bool faster = ConvolveTaps(taps);
+    if (faster and crossover == 0)
+    {
+      crossover = taps;
+    }
+    else if (!faster)
+    {
+      crossover = 0;
+    }
+  }
+  if (crossover)
+  {
+    printf("The Convolver is faster from %u taps on\n", crossover);
+  }
+  else
+  {
+    printf("The Convolver is not faster up to %u taps\n", maxTaps);
+  }
+  return 0;
+}
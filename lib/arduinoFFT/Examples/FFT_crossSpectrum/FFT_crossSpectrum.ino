@@ -0,0 +1,180 @@
+/*
+
+	Example of use of the FFT library to measure a transfer function
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, an EKG like test signal sampled at 200 Hz is the reference
+  of a simulated two channel measurement, and its two point moving average
+  the response. Both channels go into one complex frame of 512
+  points, whose single transform a CrossSpectrum splits into the two spectra
+  and averages over half overlapping frames. The moving average has the exact
+  response H(w) = cos(w / 2) exp(-j w / 2), so the H1 estimate must match
+  its magnitude and phase within 0.01 at a few bins, with a coherence close
+  to 1. The time per frame is printed next to that of windowing and
+  transforming the two channels one by one.
+*/
+
+#include "arduinoFFT.h"
+#include "crossSpectrum.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t pairs = 512; // Complex points per frame, a power of 2
+const uint16_t bins = pairs / 2 + 1;
+const uint16_t signalLength = 10000; // Samples of the measurement
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+const uint16_t checkedBins[] = {16, 64, 128};
+const float tolerance = 0.01; // Of the magnitude and of the phase in radians
+const float minCoherence = 0.99;
+
+/*
+These are the input and output vectors
+*/
+FFTComplex<float> vFrame[pairs];
+float vAccumulator[4 * bins];
+float vMagnitude[bins];
+float vPhase[bins];
+float vCoherence[bins];
+float vReal[2 * pairs]; // Both channels one after the other, for the separate transforms
+float vImag[2 * pairs];
+float vSignal[pairs + 1]; // Samples offset - 1 to offset + pairs - 1 of the test signal
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>();
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  CrossSpectra();
+  while(1); /* Run Once */
+}
+
+/* The samples of the frame starting at offset, after the one before it */
+void ReadSignal(uint16_t offset)
+{
+  for (uint16_t i = 0; i <= pairs; i++)
+  {
+    vSignal[i] = EkgSignal(offset - 1 + i);
+  }
+}
+
+void CrossSpectra()
+{
+  CrossSpectrum<float> cross = CrossSpectrum<float>(vAccumulator, bins, FFTAveraging::Linear, 64);
+  /* Reference x[n], response (x[n] + x[n - 1]) / 2, both in one complex frame */
+  float combined = 0;
+  uint8_t frames = 0;
+  for (uint16_t offset = 1; (offset + pairs) <= signalLength; offset += pairs / 2)
+  {
+    ReadSignal(offset);
+    for (uint16_t i = 0; i < pairs; i++)
+    {
+      vFrame[i].re = vSignal[i + 1];
+      vFrame[i].im = (vSignal[i + 1] + vSignal[i]) / 2;
+    }
+    unsigned long start = micros();
+    cross.add(vFrame);
+    combined += micros() - start;
+    frames++;
+  }
+  /* The same frames as two real signals, windowed and transformed one by one */
+  float separate = 0;
+  for (uint16_t offset = 1; (offset + pairs) <= signalLength; offset += pairs / 2)
+  {
+    ReadSignal(offset);
+    for (uint16_t i = 0; i < pairs; i++)
+    {
+      vReal[i] = vSignal[i + 1];
+      vReal[pairs + i] = (vSignal[i + 1] + vSignal[i]) / 2;
+      vImag[i] = 0.0;
+      vImag[pairs + i] = 0.0;
+    }
+    unsigned long start = micros();
+    for (uint8_t channel = 0; channel < 2; channel++)
+    {
+      FFT.windowing(&vReal[channel * pairs], pairs, FFTWindow::Hamming, FFTDirection::Forward);
+      FFT.compute(&vReal[channel * pairs], &vImag[channel * pairs], pairs, FFTDirection::Forward);
+    }
+    separate += micros() - start;
+  }
+  cross.transfer(vMagnitude, vPhase);
+  cross.coherence(vCoherence);
+  for (uint8_t i = 0; i < sizeof(checkedBins) / sizeof(checkedBins[0]); i++)
+  {
+    uint16_t k = checkedBins[i];
+    float omega = PI * k / (pairs / 2);
+    bool match = (fabs(vMagnitude[k] - cos(omega / 2)) <= tolerance) and
+                 (fabs(vPhase[k] + omega / 2) <= tolerance) and (vCoherence[k] >= minCoherence);
+    Serial.print("Bin ");
+    Serial.print(k);
+    Serial.print(": |H1| ");
+    Serial.print(vMagnitude[k], 4);
+    Serial.print(" (exact ");
+    Serial.print(cos(omega / 2), 4);
+    Serial.print("), phase ");
+    Serial.print(vPhase[k], 4);
+    Serial.print(" (exact ");
+    Serial.print(-omega / 2, 4);
+    Serial.print("), coherence ");
+    Serial.print(vCoherence[k], 3);
+    Serial.println(match ? " PASS" : " FAIL");
+  }
+  Serial.print("Cross spectrum of ");
+  Serial.print(frames);
+  Serial.print(" frames of ");
+  Serial.print(pairs);
+  Serial.print(" pairs: one transform ");
+  Serial.print(combined / frames, 1);
+  Serial.print(" us, two transforms ");
+  Serial.print(separate / frames, 1);
+  Serial.println(" us per frame");
+}
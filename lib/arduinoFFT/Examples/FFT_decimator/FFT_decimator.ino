@@ -0,0 +1,104 @@
+/*
+
+	Example of use of the FFT library to decimate an oversampled signal
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, a Decimator reduces simulated tones sampled at 16 times the
+  1000 Hz analysis rate to that rate, as when the ADC is oversampled. Two tones
+  lie in the passband, which reaches 0.4 times the output rate, and two would
+  alias onto them without the half band filters. The gain of each tone is
+  measured from the power of the output once the filters have filled: within
+  0.1 dB of unity in the passband, and at least 75 dB down for the aliases.
+  The time per input sample is printed.
+*/
+
+#include "arduinoFFT.h"
+#include "decimator.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; // Output samples measured
+const float samplingFrequency = 1000; // Output rate
+const uint8_t ratio = 16;
+const uint16_t settle = 100; // Output samples skipped while the filters fill
+const float passbandRipple = 0.1; // dB
+const float stopbandGain = -75; // dB
+
+/* Create the decimator */
+Decimator<float> decimator = Decimator<float>(ratio);
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  DecimateTone(50, true);
+  DecimateTone(350, true);
+  DecimateTone(samplingFrequency - 50, false); // Aliases onto 50 Hz
+  DecimateTone(2 * samplingFrequency - 350, false); // Aliases onto 350 Hz
+  while(1); /* Run Once */
+}
+
+void DecimateTone(float frequency, bool passband)
+{
+  decimator.reset();
+  float ratioFrequency = twoPi * frequency / (samplingFrequency * ratio);
+  float power = 0;
+  uint16_t outputs = 0;
+  unsigned long duration = 0;
+  for (uint32_t i = 0; outputs < settle + samples; i++)
+  {
+    float input = sin(i * ratioFrequency);
+    float output;
+    unsigned long start = micros();
+    bool ready = decimator.update(input, &output);
+    duration += micros() - start;
+    if (ready)
+    {
+      if (outputs >= settle)
+      {
+        power += sq(output);
+      }
+      outputs++;
+    }
+  }
+  /* A unit sine has a mean power of 1 / 2 */
+  float gain = 10.0 * log10(2.0 * power / samples);
+  Serial.print("Decimator x");
+  Serial.print(ratio);
+  Serial.print(", ");
+  Serial.print(frequency, 0);
+  Serial.print(" Hz tone: gain ");
+  Serial.print(gain, 2);
+  Serial.print(" dB, ");
+  Serial.print(1000.0 * duration / (outputs * ratio), 1);
+  Serial.print(" ns per input sample");
+  if (passband)
+  {
+    Serial.println(fabs(gain) <= passbandRipple ? " PASS" : " FAIL");
+  }
+  else
+  {
+    Serial.println(gain <= stopbandGain ? " PASS" : " FAIL");
+  }
+}
@@ -0,0 +1,144 @@
+/*
+
+	Example of use of the FFT library with Q15 fixed point samples
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, 2048 samples of a sine and an EKG like test signal are
+  quantized to Q15, using the full range, and transformed with the FixedFFT. Its stages halve the data only when it would
+  overflow and count the shifts in a block exponent, which complexToMagnitude()
+  returns. The magnitudes are scaled back with that exponent and compared with
+  the float transform of the same quantized samples as a signal to noise ratio.
+  The time of the fixed point transform is printed.
+*/
+
+#include "arduinoFFT.h"
+#include "fixedFFT.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //This value MUST ALWAYS be a power of 2
+const float samplingFrequency = 1000;
+const float minSNR = 50; // dB, of the fixed point magnitudes against the float ones
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+
+/*
+These are the input and output vectors
+Input vectors receive computed results from FFT
+*/
+float vReal[samples];
+float vImag[samples];
+int16_t vRealFixed[samples];
+int16_t vImagFixed[samples];
+
+/* Create FFT objects */
+ArduinoFFT<float> FFT = ArduinoFFT<float>(vReal, vImag, samples, samplingFrequency);
+FixedFFT FixedPointFFT = FixedFFT(vRealFixed, vImagFixed, samples);
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  CompareFixed("Sine test signal", SineSignal);
+  CompareFixed("EKG test signal", EkgSignal);
+  while(1); /* Run Once */
+}
+
+void CompareFixed(const char *name, float (*signal)(uint32_t n))
+{
+  /* Quantize the frame to Q15 using the full range */
+  float maxAbs = 0;
+  for (uint16_t i = 0; i < samples; i++)
+  {
+    vReal[i] = signal(i);
+    maxAbs = max(maxAbs, (float)fabs(vReal[i]));
+  }
+  float quantization = 32767.0 / maxAbs;
+  for (uint16_t i = 0; i < samples; i++)
+  {
+    vRealFixed[i] = lroundf(vReal[i] * quantization);
+    vImagFixed[i] = 0;
+    vReal[i] = vRealFixed[i] / quantization;
+    vImag[i] = 0.0;
+  }
+  FFT.compute(FFTDirection::Forward);
+  FFT.complexToMagnitude();
+  unsigned long start = micros();
+  FixedPointFFT.compute(FFTDirection::Forward);
+  int exponent = FixedPointFFT.complexToMagnitude();
+  unsigned long duration = micros() - start;
+  /* Magnitudes are unsigned and may use the full 16 bits */
+  uint16_t *vMagnitudeFixed = reinterpret_cast<uint16_t *>(vRealFixed);
+  float signalPower = 0;
+  float noisePower = 0;
+  for (uint16_t i = 0; i <= (samples >> 1); i++)
+  {
+    float magnitude = ldexp((float)vMagnitudeFixed[i], exponent) / quantization;
+    signalPower += sq(vReal[i]);
+    noisePower += sq(magnitude - vReal[i]);
+  }
+  float snr = 10.0 * log10(signalPower / noisePower);
+  Serial.print(name);
+  Serial.print(": FixedFFT ");
+  Serial.print(duration);
+  Serial.print(" us, exponent ");
+  Serial.print(exponent);
+  Serial.print(", SNR vs float ");
+  Serial.print(snr, 1);
+  Serial.print(" dB");
+  Serial.println(snr >= minSNR ? " PASS" : " FAIL");
+}
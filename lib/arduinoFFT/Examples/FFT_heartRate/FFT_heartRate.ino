@@ -0,0 +1,189 @@
+/*
+
+	Example of use of the FFT library to estimate a heart rate
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, the heart rate of an EKG like test signal sampled at 200
+  Hz, beating at about 52 BPM with the rate swinging by 10 %, is estimated
+  from the autocorrelation of overlapping 1024 sample frames. autocorrelate() zero-pads each frame to
+  2048 points, so the transform gives the same lags as the direct sum, which
+  is timed and compared on the first frame. A PeriodEstimator picks the
+  strongest lag between 30 and 220 BPM. Each rate must be within 10 % of the
+  mean rate of the beats the signal has in its frame. Frames whose peak is too
+  weak report no rate, but most frames have to.
+*/
+
+#include "arduinoFFT.h"
+#include "periodEstimator.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //This value MUST ALWAYS be a power of 2
+const uint16_t length = samples / 2; // Frame length, zero-padded to samples points
+const float samplingFrequency = 200;
+const uint16_t signalLength = 10000; // Samples of the test signal
+const uint16_t hop = 512; // Frame advance
+const float tolerance = 1e-5; // Of the transform, relative to lag 0
+const float rateTolerance = 0.1; // Relative to the rate of the beats in the frame
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+
+/*
+These are the input and output vectors
+*/
+float vReal[samples];
+float vDirect[length + 1];
+float vFrame[length]; // First frame, for the direct sum
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>();
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  EstimateHeartRate();
+  while(1); /* Run Once */
+}
+
+void EstimateHeartRate()
+{
+  PeriodEstimator<float> estimator = PeriodEstimator<float>(30 / 60.0, 220 / 60.0);
+  /* Direct sum over all lags, on the first frame */
+  float mean = 0;
+  for (uint16_t i = 0; i < length; i++)
+  {
+    vFrame[i] = EkgSignal(i);
+    mean += vFrame[i];
+  }
+  mean /= length;
+  unsigned long start = micros();
+  for (uint16_t lag = 0; lag <= length; lag++)
+  {
+    float sum = 0;
+    for (uint16_t i = 0; (i + lag) < length; i++)
+    {
+      sum += (vFrame[i] - mean) * (vFrame[i + lag] - mean);
+    }
+    vDirect[lag] = sum;
+  }
+  float direct = micros() - start;
+  float error = 0;
+  /* Through the transform, on every frame */
+  float transform = 0;
+  uint8_t frames = 0;
+  uint8_t checked = 0;
+  bool pass = true;
+  for (uint16_t offset = 0; (offset + length) <= signalLength; offset += hop)
+  {
+    for (uint16_t i = 0; i < length; i++)
+    {
+      vReal[i] = EkgSignal(offset + i);
+    }
+    start = micros();
+    FFT.autocorrelate(vReal, samples);
+    transform += micros() - start;
+    if (0 == offset)
+    {
+      for (uint16_t lag = 0; lag <= length; lag++)
+      {
+        error = max(error, (float)fabs(vReal[lag] - vDirect[lag]) / vDirect[0]);
+      }
+    }
+    frames++;
+    Serial.print("Heart rate frame ");
+    Serial.print(frames);
+    Serial.print(": ");
+    float reference = ReferenceHeartRate(offset, length, samplingFrequency);
+    if (estimator.estimate(vReal, length + 1, length, samplingFrequency))
+    {
+      float rate = 60 * estimator.frequency();
+      Serial.print(rate, 1);
+      Serial.print(" BPM, confidence ");
+      Serial.print(estimator.confidence(), 2);
+      bool match = fabs(rate - reference) <= rateTolerance * reference;
+      Serial.print(", beats ");
+      Serial.print(reference, 1);
+      Serial.println(match ? " BPM PASS" : " BPM FAIL");
+      pass = pass && match;
+      checked++;
+    }
+    else
+    {
+      Serial.print("no beat found, confidence ");
+      Serial.println(estimator.confidence(), 2);
+    }
+  }
+  Serial.print("Heart rate within ");
+  Serial.print(rateTolerance * 100, 0);
+  Serial.print("% of the beats in ");
+  Serial.print(checked);
+  Serial.print(" of ");
+  Serial.print(frames);
+  Serial.print(" frames");
+  /* Most frames have to report a rate */
+  Serial.println((pass && (2 * checked) > frames) ? " PASS" : " FAIL");
+  Serial.print("Autocorrelation of ");
+  Serial.print(length);
+  Serial.print(" samples: direct ");
+  Serial.print(direct, 0);
+  Serial.print(" us, transform ");
+  Serial.print(transform / frames, 0);
+  Serial.print(" us, relative difference ");
+  Serial.print(error, 8);
+  Serial.println(error <= tolerance ? " PASS" : " FAIL");
+}
+
+/* Mean rate of the beats of the test signal within length samples from
+offset, in BPM */
+float ReferenceHeartRate(uint16_t offset, uint16_t length, float frequency)
+{
+  return 60 * frequency * (EkgPhase((offset + length) / frequency) - EkgPhase(offset / frequency)) / length;
+}
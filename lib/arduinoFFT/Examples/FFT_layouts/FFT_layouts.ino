@@ -0,0 +1,175 @@
+/*
+
+	Example of use of the FFT library with split and interleaved buffers
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, a test signal of tones at 100, 50 and 2 Hz is transformed
+  at 2048 to 16384 points in both buffer layouts: the split one,
+  with separate vReal and vImag arrays, and the interleaved one, an array of
+  FFTComplex values. The buffer comes from PSRAM when the board has it. The
+  interleaved butterflies run block by block and the split ones twiddle by
+  twiddle, so the timings measure loop order and layout together. On an x86
+  host with a 48 kB L1 cache the two are level up to 4096 points, and the
+  interleaved layout is about four times faster at 8192 and 16384 points,
+  where the split loop strides across buffers larger than the cache.
+  A few bins of each result are checked against a direct DFT.
+*/
+
+#include "arduinoFFT.h"
+#include "fftSIMD.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //Smallest size. This value MUST ALWAYS be a power of 2
+const uint16_t maxSamples = 16384; //Largest size
+const float samplingFrequency = 1000;
+const uint16_t runs = 20;
+const uint8_t checkedBins = 8; // Bins compared with the direct DFT, spread over the spectrum
+const float tolerance = 1e-5; // Relative to the largest magnitude of the transform
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>();
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  /* Compare layouts with the same scalar butterflies */
+  simdSetInstructionSet(FFTInstructionSet::Scalar);
+  /* One allocation serves both layouts: two halves for the split layout,
+  maxSamples complex values for the interleaved one */
+  size_t bytes = 2 * maxSamples * sizeof(float);
+#if defined(ESP32) && defined(BOARD_HAS_PSRAM)
+  float *buffer = (float *)ps_malloc(bytes);
+  Serial.println("Buffers in PSRAM");
+#else
+  float *buffer = (float *)malloc(bytes);
+  Serial.println("Buffers in internal RAM");
+#endif
+  if (!buffer)
+  {
+    Serial.println("Not enough memory");
+    while(1);
+  }
+  FFTComplex<float> *vComplex = reinterpret_cast<FFTComplex<float> *>(buffer);
+  for (uint32_t n = samples; n <= maxSamples; n <<= 1)
+  {
+    float *vReal = buffer;
+    float *vImag = buffer + n;
+    unsigned long splitTotal = 0;
+    unsigned long interleavedTotal = 0;
+    float splitError = 0;
+    float interleavedError = 0;
+    /* Run 0 builds the plan of this size and is not counted */
+    for (uint16_t run = 0; run <= runs; run++)
+    {
+      for (uint32_t i = 0; i < n; i++)
+      {
+        vReal[i] = SineSignal(i);
+        vImag[i] = 0.0;
+      }
+      unsigned long start = micros();
+      FFT.compute(vReal, vImag, n, FFTDirection::Forward);
+      if (run > 0)
+      {
+        splitTotal += micros() - start;
+      }
+      else
+      {
+        splitError = CheckBins(vReal, vImag, 1, n);
+      }
+      for (uint32_t i = 0; i < n; i++)
+      {
+        vComplex[i].re = SineSignal(i);
+        vComplex[i].im = 0.0;
+      }
+      start = micros();
+      FFT.compute(vComplex, n, FFTDirection::Forward);
+      if (run > 0)
+      {
+        interleavedTotal += micros() - start;
+      }
+      else
+      {
+        interleavedError = CheckBins(&vComplex[0].re, &vComplex[0].im, 2, n);
+      }
+    }
+    Serial.print(n);
+    Serial.print(" points: split ");
+    Serial.print(splitTotal / runs);
+    Serial.print(" us, interleaved ");
+    Serial.print(interleavedTotal / runs);
+    Serial.print(" us per transform, relative error ");
+    Serial.print(max(splitError, interleavedError), 8);
+    Serial.println(max(splitError, interleavedError) <= tolerance ? " PASS" : " FAIL");
+  }
+  free(buffer);
+  while(1); /* Run Once */
+}
+
+/* Largest difference between a few bins of the transform and the direct DFT
+of the input, relative to the largest magnitude of the transform. The real and
+imaginary parts of bin k are at vReal[k * stride] and vImag[k * stride]. */
+float CheckBins(const float *vReal, const float *vImag, uint8_t stride, uint32_t n)
+{
+  float maxMagnitude = 0;
+  for (uint32_t k = 0; k < n; k++)
+  {
+    maxMagnitude = max(maxMagnitude, (float)sqrt(sq(vReal[k * stride]) + sq(vImag[k * stride])));
+  }
+  float maxError = 0;
+  for (uint8_t b = 0; b < checkedBins; b++)
+  {
+    uint32_t k = b * (n / checkedBins) + b + 1;
+    double re = 0;
+    double im = 0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+      /* k * i modulo n keeps the angle small and exact */
+      double angle = 6.28318530717958647692 * ((uint64_t)k * i % n) / n;
+      float sample = SineSignal(i);
+      re += sample * cos(angle);
+      im -= sample * sin(angle);
+    }
+    maxError = max(maxError, (float)sqrt(sq(vReal[k * stride] - re) + sq(vImag[k * stride] - im)));
+  }
+  return maxError / maxMagnitude;
+}
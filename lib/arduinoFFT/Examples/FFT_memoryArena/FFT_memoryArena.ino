@@ -0,0 +1,169 @@
+/*
+
+	Example of use of the FFT library with its tables in a MemoryArena
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, the tables the library allocates are routed to a
+  MemoryArena over one block of 112 kB through fftSetAllocator(): the plans,
+  a ChirpZ band, ConstantQ kernels and an 8 frame spectrogram of a sine test
+  signal. Every region is listed with the
+  high-water mark of the block, which is how large it has to be for this set
+  of transforms. All tables must fit and, once released, leave the block
+  empty. The time of an allocation and release pair is printed for the arena
+  and for malloc() and free().
+*/
+
+#include "arduinoFFT.h"
+#include "chirpZ.h"
+#include "constantQ.h"
+#include "memoryArena.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //This value MUST ALWAYS be a power of 2
+const float samplingFrequency = 1000;
+const uint16_t hop = 512; // Frame advance, halved for the spectrogram
+const size_t poolBytes = 112 * 1024;
+const uint16_t frames = 8; // Frames of the spectrogram
+
+/*
+This is the input vector, the frames of the spectrogram overlapping
+*/
+float vSignal[samples / 2 + (frames - 1) * hop / 2];
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>();
+
+MemoryArena *tableArena = nullptr; // Serves the library while ArenaTables() runs
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+  for (uint16_t i = 0; i < sizeof(vSignal) / sizeof(vSignal[0]); i++)
+  {
+    vSignal[i] = SineSignal(i);
+  }
+}
+
+void loop()
+{
+  ArenaTables();
+  while(1); /* Run Once */
+}
+
+void *ArenaAllocate(size_t bytes, const char *name)
+{
+  return tableArena->allocate(bytes, name);
+}
+
+void ArenaRelease(void *pointer)
+{
+  if (!tableArena->release(pointer))
+  {
+    free(pointer); // From before the arena was set
+  }
+}
+
+void ArenaTables()
+{
+  uint8_t *pool = (uint8_t *)malloc(poolBytes);
+  if (!pool)
+  {
+    Serial.println("Arena: out of memory");
+    return;
+  }
+  MemoryArena arena(pool, poolBytes);
+  tableArena = &arena;
+  FFTPlan<float>::clear(); // Rebuilt in the arena
+  fftSetAllocator(ArenaAllocate, ArenaRelease);
+  bool built;
+  {
+    ChirpZ<float> chirpZ;
+    ConstantQ<float> constantQ;
+    /* Long-lived blocks first, the build buffers of the tables leave gaps above them */
+    float *spectrogram = arena.allocate<float>((uint32_t)frames * (samples / 4 + 1), "Spectrogram");
+    built = chirpZ.configure(samples / 2, 420, 95, 105, samplingFrequency);
+    built = constantQ.configure(samples, samplingFrequency, 4, samplingFrequency / 4, 6) && built;
+    built = spectrogram && FFT.computeBatch(vSignal, samples / 2, hop / 2, frames, spectrogram, FFTWindow::Hamming, FFTScale::Decibel) && built;
+    Serial.print("Arena regions");
+    Serial.println(built ? ":" : " (some tables did not fit):");
+    for (uint8_t i = 0; i < arena.regions(); i++)
+    {
+      Serial.print("  ");
+      Serial.print(arena.region(i).name);
+      Serial.print(" ");
+      Serial.println(arena.region(i).bytes);
+    }
+    Serial.print("Arena used ");
+    Serial.print(arena.used(0));
+    Serial.print(" of ");
+    Serial.print(arena.capacity(0));
+    Serial.println(" bytes");
+    arena.release(spectrogram);
+  }
+  FFTPlan<float>::clear();
+  fftSetAllocator(nullptr, nullptr);
+  tableArena = nullptr;
+  /* Allocation and release pairs of a frame of floats */
+  const uint16_t pairs = 1000;
+  unsigned long start = micros();
+  for (uint16_t i = 0; i < pairs; i++)
+  {
+    arena.release(arena.allocate(samples * sizeof(float), "Frame"));
+  }
+  unsigned long arenaTime = micros() - start;
+  start = micros();
+  for (uint16_t i = 0; i < pairs; i++)
+  {
+    void *volatile block = malloc(samples * sizeof(float));
+    free(block);
+  }
+  unsigned long heapTime = micros() - start;
+  Serial.print("Arena high-water ");
+  Serial.print(arena.highWater(0));
+  Serial.print(" bytes, ");
+  Serial.print(arena.used(0));
+  Serial.print(" in use after release; allocation pair ");
+  Serial.print(float(arenaTime) / pairs, 2);
+  Serial.print(" us, malloc() pair ");
+  Serial.print(float(heapTime) / pairs, 2);
+  Serial.print(" us");
+  /* Every table has to fit, and every region has to be returned */
+  Serial.println((built and 0 == arena.used(0) and 0 == arena.failures()) ? " PASS" : " FAIL");
+  free(pool);
+}
@@ -0,0 +1,148 @@
+/*
+
+	Example of use of the FFT library at sizes other than powers of two
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, the first samples of a sine test signal of three tones
+  are transformed at sizes other than powers of two: 1000 points, which give
+  exact 1 Hz bins at 1000 Hz, and 600 points, both with the mixed radix plan,
+  and the prime 1009 points with Bluestein's algorithm. The time per transform
+  is printed next to 1024 points. Every bin is compared
+  with a direct DFT of the same samples, relative to the strongest bin, and
+  the frequency of the strongest bin is printed. compute() returns false for
+  a size it has no plan for, which only happens here if memory runs out.
+*/
+
+#include "arduinoFFT.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t maxSamples = 1024; // Largest size
+const float samplingFrequency = 1000;
+const uint16_t runs = 20;
+const float tolerance = 1e-5; // Relative to the strongest bin
+
+/*
+These are the input and output vectors
+Input vectors receive computed results from FFT
+*/
+float vSignal[maxSamples];
+float vReal[maxSamples];
+float vImag[maxSamples];
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>();
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+  for (uint16_t i = 0; i < maxSamples; i++)
+  {
+    vSignal[i] = SineSignal(i);
+  }
+}
+
+void loop()
+{
+  OddSizes(1000);
+  OddSizes(600);
+  OddSizes(1009); // Prime
+  OddSizes(1024);
+  while(1); /* Run Once */
+}
+
+void OddSizes(uint16_t size)
+{
+  /* Timing */
+  unsigned long elapsed = 0;
+  for (uint16_t run = 0; run < runs; run++)
+  {
+    for (uint16_t i = 0; i < size; i++)
+    {
+      vReal[i] = vSignal[i];
+      vImag[i] = 0.0;
+    }
+    unsigned long start = micros();
+    if (!FFT.compute(vReal, vImag, size, FFTDirection::Forward))
+    {
+      Serial.print(size);
+      Serial.println(" points: no plan, out of memory FAIL");
+      return;
+    }
+    elapsed += micros() - start;
+  }
+  /* Accuracy against the direct DFT of the same samples */
+  float error = 0.0;
+  float largest = 0.0;
+  uint16_t strongest = 0;
+  for (uint16_t k = 0; k < size; k++)
+  {
+    double real = 0.0;
+    double imag = 0.0;
+    for (uint16_t n = 0; n < size; n++)
+    {
+      double angle = 2.0 * PI * ((uint32_t(k) * n) % size) / size;
+      real += vSignal[n] * cos(angle);
+      imag -= vSignal[n] * sin(angle);
+    }
+    float magnitude = sqrt(real * real + imag * imag);
+    float difference = sqrt(sq(vReal[k] - real) + sq(vImag[k] - imag));
+    if (difference > error)
+    {
+      error = difference;
+    }
+    if ((k > 0) && (k <= size / 2) && (magnitude > largest))
+    {
+      largest = magnitude;
+      strongest = k;
+    }
+  }
+  const FFTPlan<float> *plan = FFTPlan<float>::get(size, FFTDirection::Forward);
+  Serial.print(size);
+  Serial.print(" points (");
+  Serial.print((plan->algorithm() == FFTAlgorithm::Radix2) ? "Radix2" :
+               (plan->algorithm() == FFTAlgorithm::MixedRadix) ? "MixedRadix" : "Bluestein");
+  Serial.print("): ");
+  Serial.print(float(elapsed) / runs, 1);
+  Serial.print(" us, error ");
+  Serial.print(error / largest, 8);
+  Serial.print(", strongest bin at ");
+  Serial.print(strongest * samplingFrequency / size, 2);
+  Serial.print(" Hz");
+  Serial.println(error / largest <= tolerance ? " PASS" : " FAIL");
+}
@@ -0,0 +1,165 @@
+/*
+
+	Example of use of the FFT library to find the strongest tones of a spectrum
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, 2048 samples of a sine test signal of five tones and of an
+  EKG like test signal are transformed with a rectangular window, as the
+  Quinn and Jain estimators assume. A PeakFinder then picks the five strongest
+  tones with each of its estimators and the frequencies and the time per
+  search are printed. The strongest tone must be within one bin of
+  majorPeak(), and the tones of the sine signal, at 100, 50, 2, 30 and
+  14.4 Hz, within half a bin of their true frequencies.
+*/
+
+#include "arduinoFFT.h"
+#include "peakFinder.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //This value MUST ALWAYS be a power of 2
+const float samplingFrequency = 1000; // Of the sine signal
+const float ekgSamplingFrequency = 200;
+const uint16_t runs = 20;
+const float sineTones[] = {100, 50, 2, 30, 14.4}; // Strongest first
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+
+/*
+These are the input and output vectors
+Input vectors receive computed results from FFT
+*/
+float vReal[samples];
+float vImag[samples];
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>(vReal, vImag, samples, samplingFrequency);
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: five tones, the strongest first, over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.6 * sin(twoPi * 30 * t) +
+         0.4 * sin(twoPi * 14.4 * t) + 0.1 * Noise(n);
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  FindPeaks("Sine test signal", SineSignal, samplingFrequency, sineTones);
+  FindPeaks("EKG test signal", EkgSignal, ekgSamplingFrequency, nullptr);
+  while(1); /* Run Once */
+}
+
+/* tones, if given, holds the true frequencies of the five strongest tones */
+void FindPeaks(const char *name, float (*signal)(uint32_t n), float frequency, const float *tones)
+{
+  const char *names[] = {"Parabolic", "Quinn", "Jain"};
+  const FFTPeakEstimator estimators[] = {FFTPeakEstimator::Parabolic, FFTPeakEstimator::Quinn, FFTPeakEstimator::Jain};
+  float binWidth = frequency / samples;
+  for (uint16_t i = 0; i < samples; i++)
+  {
+    vReal[i] = signal(i);
+    vImag[i] = 0.0;
+  }
+  FFT.dcRemoval(vReal, samples);
+  FFT.compute(vReal, vImag, samples, FFTDirection::Forward);
+  /* The magnitudes overwrite vReal, so they go to the end of the search */
+  PeakFinder<float> finder = PeakFinder<float>(5);
+  float strongest[3];
+  Serial.println(name);
+  for (uint8_t e = 0; e < 3; e++)
+  {
+    finder.setEstimator(estimators[e]);
+    unsigned long start = micros();
+    for (uint16_t run = 0; run < runs; run++)
+    {
+      finder.find(vReal, vImag, samples / 2 + 1, binWidth);
+    }
+    float duration = (micros() - start) / float(runs);
+    strongest[e] = finder.peak(0).frequency;
+    Serial.print("  ");
+    Serial.print(names[e]);
+    Serial.print(":");
+    bool found = true;
+    for (uint8_t i = 0; i < finder.peaks(); i++)
+    {
+      Serial.print(" ");
+      Serial.print(finder.peak(i).frequency, 2);
+      if (tones)
+      {
+        found = found and (fabs(finder.peak(i).frequency - tones[i]) <= binWidth / 2);
+      }
+    }
+    Serial.print(" Hz, ");
+    Serial.print(duration, 1);
+    Serial.print(" us");
+    if (tones)
+    {
+      Serial.println((finder.peaks() == 5 and found) ? " PASS" : " FAIL");
+    }
+    else
+    {
+      Serial.println();
+    }
+  }
+  FFT.complexToMagnitude(vReal, vImag, samples);
+  float majorPeak = FFT.majorPeak(vReal, samples, frequency);
+  bool match = true;
+  for (uint8_t e = 0; e < 3; e++)
+  {
+    match = match and (fabs(strongest[e] - majorPeak) <= binWidth);
+  }
+  Serial.print("  majorPeak: ");
+  Serial.print(majorPeak, 2);
+  Serial.print(" Hz");
+  Serial.println(match ? " PASS" : " FAIL");
+}
@@ -0,0 +1,187 @@
+/*
+
+	Example of use of the FFT library in a two stage acquisition pipeline
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, which runs on a Linux or other host with threads rather
+  than a board, an EKG like test signal is streamed through a two stage
+  pipeline, as the sampling task and the display loop of the analyzer run on
+  the two cores. A thread paced like a sampling task pushes hops of samples
+  into an STFT, cuts 2048 sample frames and hands them over through a PingPong
+  frame pair, while the main thread transforms them. With a hop interval
+  longer than a transform every frame is processed; with a shorter one the
+  acquisition keeps going and the frames the transform could not take are
+  counted as dropped. Every frame the STFT cut has to be published, and every
+  published frame either processed or dropped. Build and run it with make in
+  this folder.
+*/
+
+#include "arduinoFFT.h"
+#include "pingPong.h"
+#include "stft.h"
+#include <chrono>
+#include <string.h>
+#include <thread>
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //This value MUST ALWAYS be a power of 2
+const uint16_t runs = 20;
+const uint16_t signalLength = 10000;
+const uint16_t hop = 512; // Frame advance
+const uint16_t hops = 100; // Pushed per pipeline run, wrapping around the signal
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+
+/*
+These are the input and output vectors
+*/
+float vSignal[signalLength]; // EKG test signal
+float vHistory[samples]; // STFT ring
+
+/* Frames handed from the acquisition thread to the transform */
+struct Frame
+{
+  float data[samples];
+  float mean;
+};
+Frame frames[2];
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>();
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+/* Microseconds since the program started, as on the board */
+unsigned long micros()
+{
+  static const auto begin = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void TransformFrame(Frame *frame)
+{
+  FFT.prepare(frame->data, samples, FFTWindow::Hamming, frame->mean);
+  FFT.computeReal(frame->data, samples, true);
+  FFT.realToSpectrum(frame->data, samples, FFTScale::Decibel);
+}
+
+void PipelineFrames(float load)
+{
+  /* Time of the transform stage alone */
+  float mean = 0;
+  for (uint16_t i = 0; i < samples; i++)
+  {
+    mean += vSignal[i];
+  }
+  mean /= samples;
+  unsigned long start = micros();
+  for (uint16_t run = 0; run < runs; run++)
+  {
+    memcpy(frames[0].data, vSignal, sizeof(frames[0].data));
+    frames[0].mean = mean;
+    TransformFrame(&frames[0]);
+  }
+  float transform = float(micros() - start) / runs;
+  /* The acquisition thread pushes one hop of samples per interval */
+  float interval = transform / load;
+  PingPong<Frame> pipeline = PingPong<Frame>(&frames[0], &frames[1]);
+  STFT<float> stream = STFT<float>(vHistory, samples, samples, hop);
+  uint32_t cut = 0;
+  bool done = false;
+  std::thread producer([&]()
+  {
+    unsigned long begin = micros();
+    for (uint16_t n = 0; n < hops; n++)
+    {
+      while (micros() - begin < n * interval)
+      {
+        std::this_thread::yield();
+      }
+      stream.push(&vSignal[(n * hop) % (signalLength - hop)], hop);
+      if (stream.frameReady())
+      {
+        Frame *frame = pipeline.acquire();
+        stream.nextFrame(frame->data, &frame->mean);
+        pipeline.publish(frame);
+        cut++;
+      }
+    }
+    __atomic_store_n(&done, true, __ATOMIC_RELEASE);
+  });
+  /* This thread transforms whatever frame is newest */
+  uint32_t processed = 0;
+  start = micros();
+  while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE) || pipeline.ready())
+  {
+    Frame *frame = pipeline.take();
+    if (frame)
+    {
+      TransformFrame(frame);
+      pipeline.release(frame);
+      processed++;
+    }
+    else
+    {
+      std::this_thread::yield();
+    }
+  }
+  unsigned long elapsed = micros() - start;
+  producer.join();
+  bool pass = (pipeline.published() == cut) and (pipeline.published() == processed + pipeline.dropped());
+  printf("Pipeline at %.1f us per transform, %.1f us per hop: %u frames published, %u processed, %u dropped, "
+         "%.1f frames/s %s\n",
+         transform, interval, (unsigned)pipeline.published(), (unsigned)processed, (unsigned)pipeline.dropped(),
+         processed / (elapsed / 1.0e6), pass ? "PASS" : "FAIL");
+}
+
+int main()
+{
+  for (uint16_t i = 0; i < signalLength; i++)
+  {
+    vSignal[i] = EkgSignal(i);
+  }
+  PipelineFrames(0.5); // Transform takes half a hop interval
+  PipelineFrames(2.0); // Transform takes two hop intervals
+  return 0;
+}
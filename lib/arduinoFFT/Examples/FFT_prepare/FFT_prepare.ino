@@ -0,0 +1,149 @@
+/*
+
+	Example of use of the FFT library with the fused prepare() pass
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, overlapping 2048 sample frames of a sine and an EKG like
+  test signal are prepared for computeReal() in two ways. The first runs
+  separate dcRemoval() and windowing() passes and leaves the bit reversal to
+  computeReal(). The second removes the mean, applies the window and bit
+  reverses the frame in one prepare() pass, with the mean taken while the
+  samples are copied in, as an acquisition loop would. Both spectra must
+  match; the frames per second of each are printed.
+*/
+
+#include "arduinoFFT.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //This value MUST ALWAYS be a power of 2
+const float samplingFrequency = 1000;
+const uint16_t signalLength = 10000;
+const uint16_t hop = 512; // Frame advance
+const float tolerance = 1e-5; // Relative to the largest value of a frame
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+
+/*
+These are the input and output vectors
+Input vectors receive computed results from FFT
+*/
+float vReal[samples];
+float vPrepared[samples];
+float vWindow[samples >> 1]; // First half of the symmetric window
+
+/* Precompiled window factors for both, so only the passes differ */
+ArduinoFFT<float> FFT = ArduinoFFT<float>(vReal, nullptr, samples, samplingFrequency, true);
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  for (uint16_t i = 0; i < (samples >> 1); i++)
+  {
+    vWindow[i] = ArduinoFFT<float>::weighingFactor(FFTWindow::Hamming, i, samples);
+  }
+  PrepareFrames("Sine test signal", SineSignal);
+  PrepareFrames("EKG test signal", EkgSignal);
+  while(1); /* Run Once */
+}
+
+void PrepareFrames(const char *name, float (*signal)(uint32_t n))
+{
+  uint32_t frames = 0;
+  unsigned long separate = 0;
+  unsigned long fused = 0;
+  float error = 0;
+  for (uint16_t offset = 0; offset + samples <= signalLength; offset += hop)
+  {
+    float mean = 0;
+    for (uint16_t i = 0; i < samples; i++)
+    {
+      float sample = signal(offset + i);
+      vReal[i] = sample;
+      vPrepared[i] = sample;
+      mean += sample;
+    }
+    mean /= samples;
+    unsigned long start = micros();
+    FFT.dcRemoval();
+    FFT.windowing(FFTWindow::Hamming, FFTDirection::Forward);
+    FFT.computeReal();
+    separate += micros() - start;
+    start = micros();
+    FFT.prepare(vPrepared, samples, FFTWindow::Precompiled, mean, vWindow);
+    FFT.computeReal(vPrepared, samples, true);
+    fused += micros() - start;
+    float largest = 0;
+    float difference = 0;
+    for (uint16_t i = 0; i < samples; i++)
+    {
+      largest = max(largest, abs(vReal[i]));
+      difference = max(difference, abs(vReal[i] - vPrepared[i]));
+    }
+    error = max(error, difference / largest);
+    frames++;
+  }
+  Serial.print(name);
+  Serial.print(": separate passes ");
+  Serial.print(frames / (separate / 1.0e6), 1);
+  Serial.print(" frames/s, fused prepare ");
+  Serial.print(frames / (fused / 1.0e6), 1);
+  Serial.print(" frames/s, relative difference ");
+  Serial.print(error, 8);
+  Serial.println(error <= tolerance ? " PASS" : " FAIL");
+}
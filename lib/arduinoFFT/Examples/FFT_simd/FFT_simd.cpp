@@ -0,0 +1,179 @@
+/*
+
+	Example of use of the FFT library with the x86 vector kernels
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, which runs on a Linux or other x86 host rather than a
+  board, 10000 samples of a sine and of an EKG like test signal are processed
+  as overlapping 2048 sample frames (window, FFT, magnitude) with every
+  instruction set the CPU supports: Scalar, SSE2 and AVX2. The frames per
+  second of each set are printed, and every magnitude is checked against the
+  Scalar result of the same frame. On other CPUs only Scalar is built. Build
+  and run it with make in this folder.
+*/
+
+#include "arduinoFFT.h"
+#include "fftSIMD.h"
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //This value MUST ALWAYS be a power of 2
+const float samplingFrequency = 1000;
+const uint16_t runs = 20;
+const uint16_t signalLength = 10000;
+const uint16_t hop = 512; // Frame advance
+const float tolerance = 1e-5; // Relative to the largest magnitude of a frame
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+
+/*
+These are the input and output vectors
+Input vectors receive computed results from FFT
+*/
+float vReal[samples];
+float vImag[samples];
+float vSignals[2][signalLength]; // Sine and EKG test signals
+/* Scalar magnitudes of every frame, the reference of the vector kernels */
+const uint16_t frameCount = (signalLength - samples) / hop + 1;
+float vMagnitudes[2][frameCount][samples >> 1];
+
+/* Precompiled window factors, as a continuous analysis would use */
+ArduinoFFT<float> FFT = ArduinoFFT<float>(vReal, vImag, samples, samplingFrequency, true);
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+void ProcessFrame(const float *data, uint16_t offset)
+{
+  for (uint16_t i = 0; i < samples; i++)
+  {
+    vReal[i] = data[offset + i];
+    vImag[i] = 0.0;
+  }
+  FFT.windowing(FFTWindow::Hamming, FFTDirection::Forward);
+  FFT.compute(FFTDirection::Forward);
+  FFT.complexToMagnitude();
+}
+
+/* Largest difference to the Scalar magnitudes over all frames, relative to
+the largest magnitude of each frame */
+float CompareFrames()
+{
+  float worst = 0;
+  for (uint8_t signal = 0; signal < 2; signal++)
+  {
+    for (uint16_t frame = 0; frame < frameCount; frame++)
+    {
+      ProcessFrame(vSignals[signal], frame * hop);
+      const float *reference = vMagnitudes[signal][frame];
+      float maxMagnitude = 0;
+      float maxError = 0;
+      for (uint16_t i = 0; i < (samples >> 1); i++)
+      {
+        maxMagnitude = std::max(maxMagnitude, reference[i]);
+        maxError = std::max(maxError, fabsf(vReal[i] - reference[i]));
+      }
+      worst = std::max(worst, maxError / maxMagnitude);
+    }
+  }
+  return worst;
+}
+
+void BenchmarkFrames(const char *name, FFTInstructionSet instructionSet)
+{
+  if (!simdSetInstructionSet(instructionSet))
+  {
+    printf("%s: not supported\n", name);
+    return;
+  }
+  uint32_t frames = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint16_t run = 0; run < runs; run++)
+  {
+    for (uint8_t signal = 0; signal < 2; signal++)
+    {
+      for (uint16_t frame = 0; frame < frameCount; frame++)
+      {
+        ProcessFrame(vSignals[signal], frame * hop);
+        frames++;
+      }
+    }
+  }
+  std::chrono::duration<float> seconds = std::chrono::steady_clock::now() - start;
+  float worst = CompareFrames();
+  printf("%s: %.1f frames/s, relative error vs Scalar %.8f %s\n", name, frames / seconds.count(), worst,
+         worst <= tolerance ? "PASS" : "FAIL");
+}
+
+int main()
+{
+  for (uint16_t i = 0; i < signalLength; i++)
+  {
+    vSignals[0][i] = SineSignal(i);
+    vSignals[1][i] = EkgSignal(i);
+  }
+  /* Record the Scalar magnitudes first */
+  simdSetInstructionSet(FFTInstructionSet::Scalar);
+  for (uint8_t signal = 0; signal < 2; signal++)
+  {
+    for (uint16_t frame = 0; frame < frameCount; frame++)
+    {
+      ProcessFrame(vSignals[signal], frame * hop);
+      memcpy(vMagnitudes[signal][frame], vReal, sizeof(vMagnitudes[signal][frame]));
+    }
+  }
+
+  BenchmarkFrames("Scalar", FFTInstructionSet::Scalar);
+  BenchmarkFrames("SSE2", FFTInstructionSet::SSE2);
+  BenchmarkFrames("AVX2", FFTInstructionSet::AVX2);
+  return 0;
+}
@@ -0,0 +1,155 @@
+/*
+
+	Example of use of the FFT library to compute a spectrogram
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, a spectrogram of 10000 samples of a sine and of an EKG like
+  test signal, 1024 sample frames every 256 samples, is computed in one
+  computeBatch() call and, for comparison, frame by frame with dcRemoval(),
+  windowing(), computeReal() and realToSpectrum(). The batch copies each frame
+  with the mean removed, the window applied and the samples in bit reversed
+  order in one pass, and looks up the window factors and the plan once for all
+  frames. Both must agree within 0.01 dB; the time per frame of each is
+  printed. Build with FFT_BATCH_THREADS set to 2 to share the frames of the
+  batch between the cores.
+*/
+
+#include "arduinoFFT.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 1024; //This value MUST ALWAYS be a power of 2
+const uint16_t bins = samples / 2 + 1;
+const uint16_t hop = 256; // Frame advance
+const uint16_t signalLength = 10000;
+const float tolerance = 0.01; // dB
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+
+/*
+These are the input and output vectors
+*/
+float vReal[samples];
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>();
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  Spectrogram("Sine test signal", SineSignal);
+  Spectrogram("EKG test signal", EkgSignal);
+  while(1); /* Run Once */
+}
+
+void Spectrogram(const char *name, float (*signal)(uint32_t n))
+{
+  uint16_t count = (signalLength - samples) / hop + 1;
+  float *data = new float[signalLength];
+  float *spectrogram = new float[(uint32_t)count * bins];
+  if (data == nullptr or spectrogram == nullptr)
+  {
+    Serial.println("Spectrogram: out of memory");
+    delete[] data;
+    delete[] spectrogram;
+    return;
+  }
+  for (uint16_t i = 0; i < signalLength; i++)
+  {
+    data[i] = signal(i);
+  }
+  /* One batch for all frames */
+  unsigned long start = micros();
+  FFT.computeBatch(data, samples, hop, count, spectrogram, FFTWindow::Hamming, FFTScale::Decibel);
+  unsigned long batch = micros() - start;
+  /* Frame by frame, compared row by row */
+  float error = 0;
+  unsigned long single = 0;
+  for (uint16_t frame = 0; frame < count; frame++)
+  {
+    for (uint16_t i = 0; i < samples; i++)
+    {
+      vReal[i] = data[frame * hop + i];
+    }
+    start = micros();
+    FFT.dcRemoval(vReal, samples);
+    FFT.windowing(vReal, samples, FFTWindow::Hamming, FFTDirection::Forward);
+    FFT.computeReal(vReal, samples);
+    FFT.realToSpectrum(vReal, samples, FFTScale::Decibel);
+    single += micros() - start;
+    for (uint16_t i = 0; i < bins; i++)
+    {
+      error = max(error, float(fabs(vReal[i] - spectrogram[(uint32_t)frame * bins + i])));
+    }
+  }
+  delete[] data;
+  delete[] spectrogram;
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(count);
+  Serial.print(" frames of ");
+  Serial.print(samples);
+  Serial.print(" samples; frame by frame ");
+  Serial.print(float(single) / count, 1);
+  Serial.print(" us, batch ");
+  Serial.print(float(batch) / count, 1);
+  Serial.print(" us per frame; difference ");
+  Serial.print(error, 5);
+  Serial.print(" dB");
+  Serial.println(error <= tolerance ? " PASS" : " FAIL");
+}
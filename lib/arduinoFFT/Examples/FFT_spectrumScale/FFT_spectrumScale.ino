@@ -0,0 +1,166 @@
+/*
+
+	Example of use of the FFT library with the half spectrum output stage
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, 2048 samples of a sine test signal of three tones are
+  windowed and transformed once. The time to turn the transform into
+  magnitudes of all bins, as complexToMagnitude() does, is compared with
+  complexToSpectrum(), which only writes the bins up to Nyquist, on each of
+  its scales. The gain is the coherent scale of the window, so a bin holding a
+  whole sine reads its amplitude. Each scale is checked against the magnitudes
+  times that gain: squared for Power and as 20 * log10 for Decibel, which
+  comes from a fast logarithm approximation. The level of the strongest bin is
+  printed in dB.
+*/
+
+#include "arduinoFFT.h"
+#include "fftSIMD.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //This value MUST ALWAYS be a power of 2
+const float samplingFrequency = 1000;
+const uint16_t runs = 20;
+const float tolerance = 1e-5; // Relative to the largest bin, for Power and Magnitude
+const float decibelTolerance = 0.01; // dB
+
+/*
+These are the input and output vectors
+Input vectors receive computed results from FFT
+*/
+float vReal[samples];
+float vImag[samples];
+float vRealTransform[samples];
+float vImagTransform[samples];
+float vMagnitude[samples];
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>(vReal, vImag, samples, samplingFrequency);
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  const char *names[] = {"Power", "Magnitude", "Decibel"};
+  const FFTScale scales[] = {FFTScale::Power, FFTScale::Magnitude, FFTScale::Decibel};
+  float gain = ArduinoFFT<float>::coherentScale(FFTWindow::Hamming, samples);
+  simdSetInstructionSet(FFTInstructionSet::Scalar); // Neither stage has SIMD paths to favour it
+  for (uint16_t i = 0; i < samples; i++)
+  {
+    vRealTransform[i] = SineSignal(i);
+    vImagTransform[i] = 0.0;
+  }
+  FFT.windowing(vRealTransform, samples, FFTWindow::Hamming, FFTDirection::Forward);
+  FFT.compute(vRealTransform, vImagTransform, samples, FFTDirection::Forward);
+  unsigned long duration = 0;
+  for (uint16_t run = 0; run < runs; run++)
+  {
+    memcpy(vMagnitude, vRealTransform, sizeof(vMagnitude));
+    memcpy(vImag, vImagTransform, sizeof(vImag));
+    unsigned long start = micros();
+    FFT.complexToMagnitude(vMagnitude, vImag, samples);
+    duration += micros() - start;
+  }
+  Serial.print("All bins magnitude: ");
+  Serial.print(duration / float(runs), 1);
+  Serial.println(" us");
+  float largest = 0;
+  for (uint16_t i = 0; i <= (samples >> 1); i++)
+  {
+    largest = max(largest, vMagnitude[i] * gain);
+  }
+  for (uint8_t s = 0; s < 3; s++)
+  {
+    duration = 0;
+    for (uint16_t run = 0; run < runs; run++)
+    {
+      memcpy(vReal, vRealTransform, sizeof(vReal));
+      memcpy(vImag, vImagTransform, sizeof(vImag));
+      unsigned long start = micros();
+      FFT.complexToSpectrum(vReal, vImag, samples, scales[s], gain);
+      duration += micros() - start;
+    }
+    float error = 0;
+    for (uint16_t i = 0; i <= (samples >> 1); i++)
+    {
+      float magnitude = vMagnitude[i] * gain;
+      if (FFTScale::Power == scales[s])
+      {
+        error = max(error, (float)fabs(vReal[i] - sq(magnitude)) / sq(largest));
+      }
+      else if (FFTScale::Magnitude == scales[s])
+      {
+        error = max(error, (float)fabs(vReal[i] - magnitude) / largest);
+      }
+      else if (magnitude > 0)
+      {
+        error = max(error, (float)fabs(vReal[i] - 20.0 * log10(magnitude)));
+      }
+    }
+    Serial.print("Half spectrum ");
+    Serial.print(names[s]);
+    Serial.print(": ");
+    Serial.print(duration / float(runs), 1);
+    if (FFTScale::Decibel == scales[s])
+    {
+      Serial.print(" us, largest difference ");
+      Serial.print(error, 4);
+      Serial.print(" dB");
+      Serial.println(error <= decibelTolerance ? " PASS" : " FAIL");
+    }
+    else
+    {
+      Serial.print(" us, relative difference ");
+      Serial.print(error, 8);
+      Serial.println(error <= tolerance ? " PASS" : " FAIL");
+    }
+  }
+  float peak = vReal[1];
+  for (uint16_t i = 2; i <= (samples >> 1); i++)
+  {
+    peak = max(peak, vReal[i]);
+  }
+  Serial.print("Strongest bin: ");
+  Serial.print(peak, 2);
+  Serial.println(" dB");
+  while(1); /* Run Once */
+}
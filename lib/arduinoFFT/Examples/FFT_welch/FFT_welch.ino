@@ -0,0 +1,186 @@
+/*
+
+	Example of use of the FFT library to average power spectra with WelchPSD
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+  In this example, 10000 samples of a sine and of an EKG like test signal are
+  cut into overlapping 2048 sample frames, every 512 samples. Each frame is
+  windowed and transformed with computeReal(), and its power spectrum is added
+  to a WelchPSD running average. The average must equal the mean of the frame
+  powers summed here bin by bin. The relative spread of the upper half of the
+  spectrum is printed for the first frame and for the average. Where that band
+  holds mostly noise, as in the sine signal, averaging n frames divides the
+  spread by about the square root of n; overlapping frames are not
+  independent, so up to twice that passes.
+*/
+
+#include "arduinoFFT.h"
+#include "welchPSD.h"
+
+/*
+These values can be changed in order to evaluate the functions
+*/
+const uint16_t samples = 2048; //This value MUST ALWAYS be a power of 2
+const float samplingFrequency = 1000;
+const uint16_t signalLength = 10000;
+const uint16_t hop = 512; // Frame advance
+const uint16_t bins = (samples >> 1) + 1;
+const float tolerance = 1e-4; // Relative to the largest bin of the average, kept as a float running mean
+const float ekgRate = 52.0 / 60; // Mean beats per second of the EKG test signal
+
+/*
+These are the input and output vectors
+Input vectors receive computed results from FFT
+*/
+float vReal[samples];
+float vAverage[bins]; // WelchPSD accumulator
+float vFirst[bins]; // Power of the first frame
+float vSum[bins]; // Sum of the frame powers
+
+/* Create FFT object */
+ArduinoFFT<float> FFT = ArduinoFFT<float>(vReal, nullptr, samples, samplingFrequency);
+
+/* Noise from -0.5 to 0.5, the same for sample n on every run */
+float Noise(uint32_t n)
+{
+  n = (n ^ 0x9e3779b9) * 0x85ebca6b;
+  n ^= n >> 13;
+  n *= 0xc2b2ae35;
+  n ^= n >> 16;
+  return n / 4294967296.0 - 0.5;
+}
+
+/* Sine test signal at 1000 Hz: tones at 100, 50 and 2 Hz over a little noise */
+float SineSignal(uint32_t n)
+{
+  float t = n / 1000.0;
+  return 3.0 * sin(twoPi * 100 * t) + 1.8 * sin(twoPi * 50 * t) + sin(twoPi * 2 * t) + 0.1 * Noise(n);
+}
+
+/* EKG test signal at 200 Hz: beats of a P wave, a QRS complex and a T wave
+at about 52 BPM, the rate swinging by 10 % over 20 s, on a wandering baseline
+with some 50 Hz mains hum and a little noise */
+float EkgPhase(float t)
+{
+  return ekgRate * t + 0.1 * ekgRate * 20 / twoPi * sin(twoPi * t / 20); // Beat k at phase k
+}
+float EkgSignal(uint32_t n)
+{
+  float t = n / 200.0;
+  float phase = EkgPhase(t);
+  float d = (phase - round(phase)) / ekgRate; // Seconds from the nearest R wave
+  return 0.12 * exp(-sq((d + 0.2) / 0.025)) - 0.1 * exp(-sq((d + 0.03) / 0.01)) + exp(-sq(d / 0.012)) -
+         0.2 * exp(-sq((d - 0.03) / 0.012)) + 0.3 * exp(-sq((d - 0.3) / 0.05)) + 0.05 * sin(twoPi * 0.15 * t) +
+         0.02 * sin(twoPi * 50 * t) + 0.02 * Noise(n);
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  while(!Serial);
+  Serial.println("Ready");
+}
+
+void loop()
+{
+  AverageSpectra("Sine test signal", SineSignal, true);
+  AverageSpectra("EKG test signal", EkgSignal, false);
+  while(1); /* Run Once */
+}
+
+/* Relative standard deviation of the upper half of a half spectrum */
+float UpperBandSpread(const float *vData)
+{
+  uint16_t first = samples >> 2;
+  uint16_t count = (samples >> 1) - first;
+  float mean = 0;
+  for (uint16_t i = first; i < (samples >> 1); i++)
+  {
+    mean += vData[i];
+  }
+  mean /= count;
+  float variance = 0;
+  for (uint16_t i = first; i < (samples >> 1); i++)
+  {
+    variance += sq(vData[i] - mean);
+  }
+  return sqrt(variance / count) / mean;
+}
+
+/* The spread is only checked when the upper band of the signal is noise */
+void AverageSpectra(const char *name, float (*signal)(uint32_t n), bool noiseBand)
+{
+  WelchPSD<float> welch = WelchPSD<float>(vAverage, bins, FFTAveraging::Linear, UINT16_MAX);
+  for (uint16_t i = 0; i < bins; i++)
+  {
+    vSum[i] = 0.0;
+  }
+  for (uint16_t offset = 0; offset + samples <= signalLength; offset += hop)
+  {
+    for (uint16_t i = 0; i < samples; i++)
+    {
+      vReal[i] = signal(offset + i);
+    }
+    FFT.dcRemoval(vReal, samples);
+    FFT.windowing(vReal, samples, FFTWindow::Hamming, FFTDirection::Forward);
+    FFT.computeReal(vReal, samples);
+    welch.addReal(vReal);
+    /* computeReal() packs the real parts of bins 0 to samples / 2 and the
+    imaginary parts of bins 1 to samples / 2 - 1 after them */
+    for (uint16_t i = 0; i < bins; i++)
+    {
+      float imag = (i > 0 && i < (samples >> 1)) ? vReal[(samples >> 1) + i] : 0.0;
+      vSum[i] += sq(vReal[i]) + sq(imag);
+    }
+    if (offset == 0)
+    {
+      for (uint16_t i = 0; i < bins; i++)
+      {
+        vFirst[i] = vAverage[i];
+      }
+    }
+  }
+  float maxPower = 0;
+  float maxError = 0;
+  for (uint16_t i = 0; i < bins; i++)
+  {
+    maxPower = max(maxPower, vAverage[i]);
+    maxError = max(maxError, (float)fabs(vAverage[i] - vSum[i] / welch.frames()));
+  }
+  Serial.print(name);
+  Serial.print(": Welch average of ");
+  Serial.print(welch.frames());
+  Serial.print(" frames, relative error vs mean power ");
+  Serial.print(maxError / maxPower, 8);
+  Serial.println(maxError / maxPower <= tolerance ? " PASS" : " FAIL");
+  float single = UpperBandSpread(vFirst);
+  float averaged = UpperBandSpread(vAverage);
+  Serial.print(name);
+  Serial.print(": upper band spread, 1 frame ");
+  Serial.print(single, 3);
+  Serial.print(", average ");
+  Serial.print(averaged, 3);
+  if (noiseBand)
+  {
+    Serial.println(averaged <= 2.0 * single / sqrt(welch.frames()) ? " PASS" : " FAIL");
+  }
+  else
+  {
+    Serial.println();
+  }
+}
@@ -20,6 +20,32 @@
 */
 
 #include "arduinoFFT.h"
+#include "fftSIMD.h"
+#if FFT_BATCH_THREADS > 1
+#include <thread>
+#endif
+
+static FFTAllocateFunction _fftAllocate = nullptr;
+static FFTReleaseFunction _fftRelease = nullptr;
+
+void *fftAllocateBytes(size_t bytes, const char *name) {
+  return _fftAllocate ? _fftAllocate(bytes, name) : malloc(bytes);
+}
+
+void fftRelease(void *pointer) {
+  if (_fftRelease) {
+    _fftRelease(pointer);
+  } else {
+    free(pointer);
+  }
+}
+
+// Routes the memory of the library through allocate and release, or back to
+// malloc() and free() when both are nullptr
+void fftSetAllocator(FFTAllocateFunction allocate, FFTReleaseFunction release) {
+  _fftAllocate = allocate;
+  _fftRelease = release;
+}
 
 template <typename T> ArduinoFFT<T>::ArduinoFFT() {}
 
@@ -29,7 +55,7 @@ ArduinoFFT<T>::ArduinoFFT(T *vReal, T *vImag, uint_fast16_t samples,
     : _samples(samples), _samplingFrequency(samplingFrequency), _vImag(vImag),
       _vReal(vReal) {
   if (windowingFactors) {
-    _precompiledWindowingFactors = new T[samples / 2];
+    _precompiledWindowingFactors = fftAllocate<T>(samples / 2, "FFT window");
   }
   _power = exponent(samples);
 #ifdef FFT_SPEED_OVER_PRECISION
@@ -40,8 +66,62 @@ ArduinoFFT<T>::ArduinoFFT(T *vReal, T *vImag, uint_fast16_t samples,
 template <typename T> ArduinoFFT<T>::~ArduinoFFT(void) {
   // Destructor
   if (_precompiledWindowingFactors) {
-    delete [] _precompiledWindowingFactors;
+    fftRelease(_precompiledWindowingFactors);
+  }
+}
+
+// Autocorrelation of the samples / 2 values at the start of vData, after
+// removing their mean, through a transform zero-padded to samples points. On
+// return vData[l] holds lag l for 0 <= l <= samples / 2, not normalized. The
+// power spectrum is real and even, so its inverse transform equals its
+// forward transform divided by samples, and computeReal() serves both ways.
+template <typename T>
+void ArduinoFFT<T>::autocorrelate(T *vData, uint_fast16_t samples) const {
+  uint_fast16_t half = samples >> 1;
+  T mean = 0;
+  for (uint_fast16_t i = 0; i < half; i++) {
+    mean += vData[i];
+  }
+  mean /= half;
+  for (uint_fast16_t i = 0; i < half; i++) {
+    vData[i] -= mean;
+    vData[half + i] = 0.0;
+  }
+  computeReal(vData, samples);
+  // Spread the power of bin k to positions k and samples - k, the latter
+  // holding the imaginary part of bin half - k until now
+  T scale = 1.0 / samples;
+  vData[0] = sq(vData[0]) * scale;
+  vData[half] = sq(vData[half]) * scale;
+  uint_fast16_t k = 1;
+  for (; (k << 1) < half; k++) {
+    uint_fast16_t m = half - k;
+    T powerK = (sq(vData[k]) + sq(vData[half + k])) * scale;
+    T powerM = (sq(vData[m]) + sq(vData[half + m])) * scale;
+    vData[k] = powerK;
+    vData[half + m] = powerK;
+    vData[m] = powerM;
+    vData[half + k] = powerM;
+  }
+  if ((k << 1) == half) {
+    T power = (sq(vData[k]) + sq(vData[half + k])) * scale;
+    vData[k] = power;
+    vData[half + k] = power;
   }
+  computeReal(vData, samples);
+}
+
+// Amplitude scale of a spectrum computed with the given window: a sinusoid of
+// amplitude A shows up as A in a Magnitude spectrum scaled by this gain (A^2 in
+// Power). Folds the one-sided factor 2, the 1 / samples of the transform and
+// the coherent gain of the window into one factor.
+template <typename T>
+T ArduinoFFT<T>::coherentScale(FFTWindow windowType, uint_fast16_t samples) {
+  if (windowType >= FFTWindow::Precompiled) {
+    windowType = FFTWindow::Rectangle;
+  }
+  return _WindowCompensationFactors[static_cast<uint_fast8_t>(windowType)] /
+         samples;
 }
 
 template <typename T> void ArduinoFFT<T>::complexToMagnitude(void) const {
@@ -52,84 +132,68 @@ template <typename T>
 void ArduinoFFT<T>::complexToMagnitude(T *vReal, T *vImag,
                                        uint_fast16_t samples) const {
   // vM is half the size of vReal and vImag
+  if (simdComplexToMagnitude(vReal, vImag, samples)) {
+    return;
+  }
   for (uint_fast16_t i = 0; i < samples; i++) {
     vReal[i] = sqrt_internal(sq(vReal[i]) + sq(vImag[i]));
   }
 }
 
-template <typename T> void ArduinoFFT<T>::compute(FFTDirection dir) const {
-  compute(this->_vReal, this->_vImag, this->_samples, exponent(this->_samples),
+// Magnitudes of an interleaved buffer are stored in the real parts
+template <typename T>
+void ArduinoFFT<T>::complexToMagnitude(FFTComplex<T> *vData,
+                                       uint_fast16_t samples) const {
+  for (uint_fast16_t i = 0; i < samples; i++) {
+    vData[i].re = sqrt_internal(sq(vData[i].re) + sq(vData[i].im));
+  }
+}
+
+// Writes the samples / 2 + 1 bins up to Nyquist of a spectrum of real input to
+// vReal, on the given scale and multiplied by gain (see coherentScale()). The
+// upper half of the spectrum, mirroring the lower half, is skipped.
+template <typename T>
+void ArduinoFFT<T>::complexToSpectrum(T *vReal, T *vImag,
+                                      uint_fast16_t samples, FFTScale scale,
+                                      T gain) const {
+  for (uint_fast16_t i = 0; i <= (samples >> 1); i++) {
+    vReal[i] = sq(vReal[i]) + sq(vImag[i]);
+  }
+  powerToSpectrum(vReal, vReal, (samples >> 1) + 1, scale, gain);
+}
+
+template <typename T> bool ArduinoFFT<T>::compute(FFTDirection dir) const {
+  return compute(this->_vReal, this->_vImag, this->_samples, exponent(this->_samples),
           dir);
 }
 
 template <typename T>
-void ArduinoFFT<T>::compute(T *vReal, T *vImag, uint_fast16_t samples,
+bool ArduinoFFT<T>::compute(T *vReal, T *vImag, uint_fast16_t samples,
                             FFTDirection dir) const {
-  compute(vReal, vImag, samples, exponent(samples), dir);
+  return compute(vReal, vImag, samples, exponent(samples), dir);
 }
 
-// Computes in-place complex-to-complex FFT
+// Computes in-place complex-to-complex FFT. Any size works: sizes other than
+// powers of two use a mixed radix or Bluestein plan whatever the kernel, and
+// power is ignored for them. Returns false, leaving the data unchanged, if
+// such a size gets no plan: memory ran out, or a Bluestein size is above
+// 32768. Powers of two always transform.
 template <typename T>
-void ArduinoFFT<T>::compute(T *vReal, T *vImag, uint_fast16_t samples,
+bool ArduinoFFT<T>::compute(T *vReal, T *vImag, uint_fast16_t samples,
                             uint_fast8_t power, FFTDirection dir) const {
+  if ((samples & (samples - 1)) != 0) {
+    return computeGeneral(vReal, vImag, 1, samples, dir);
+  }
 #ifdef FFT_SPEED_OVER_PRECISION
   T oneOverSamples = this->_oneOverSamples;
   if (!this->_oneOverSamples)
     oneOverSamples = 1.0 / samples;
 #endif
+  const FFTPlan<T> *plan = this->plan(samples, dir);
   // Reverse bits
-  uint_fast16_t j = 0;
-  for (uint_fast16_t i = 0; i < (samples - 1); i++) {
-    if (i < j) {
-      swap(&vReal[i], &vReal[j]);
-      if (dir == FFTDirection::Reverse)
-        swap(&vImag[i], &vImag[j]);
-    }
-    uint_fast16_t k = (samples >> 1);
-
-    while (k <= j) {
-      j -= k;
-      k >>= 1;
-    }
-    j += k;
-  }
+  bitReverse(vReal, vImag, samples, plan);
   // Compute the FFT
-  T c1 = -1.0;
-  T c2 = 0.0;
-  uint_fast16_t l2 = 1;
-  for (uint_fast8_t l = 0; (l < power); l++) {
-    uint_fast16_t l1 = l2;
-    l2 <<= 1;
-    T u1 = 1.0;
-    T u2 = 0.0;
-    for (j = 0; j < l1; j++) {
-      for (uint_fast16_t i = j; i < samples; i += l2) {
-        uint_fast16_t i1 = i + l1;
-        T t1 = u1 * vReal[i1] - u2 * vImag[i1];
-        T t2 = u1 * vImag[i1] + u2 * vReal[i1];
-        vReal[i1] = vReal[i] - t1;
-        vImag[i1] = vImag[i] - t2;
-        vReal[i] += t1;
-        vImag[i] += t2;
-      }
-      T z = ((u1 * c1) - (u2 * c2));
-      u2 = ((u1 * c2) + (u2 * c1));
-      u1 = z;
-    }
-
-#if defined(__AVR__) && defined(USE_AVR_PROGMEM)
-    c2 = pgm_read_float_near(&(_c2[l]));
-    c1 = pgm_read_float_near(&(_c1[l]));
-#else
-    T cTemp = 0.5 * c1;
-    c2 = sqrt_internal(0.5 - cTemp);
-    c1 = sqrt_internal(0.5 + cTemp);
-#endif
-
-    if (dir == FFTDirection::Forward) {
-      c2 = -c2;
-    }
-  }
+  butterflies(vReal, vImag, samples, power, dir, plan);
   // Scaling for reverse transform
   if (dir == FFTDirection::Reverse) {
     for (uint_fast16_t i = 0; i < samples; i++) {
@@ -142,6 +206,225 @@ void ArduinoFFT<T>::compute(T *vReal, T *vImag, uint_fast16_t samples,
 #endif
     }
   }
+  return true;
+}
+
+// Computes in-place complex-to-complex FFT of an interleaved buffer. The
+// butterflies are radix-2; the Radix4 kernel setting uses the radix-2 plan
+// kernel here. Other sizes than powers of two, and the return value, as above.
+template <typename T>
+bool ArduinoFFT<T>::compute(FFTComplex<T> *vData, uint_fast16_t samples,
+                            FFTDirection dir) const {
+  if ((samples & (samples - 1)) != 0) {
+    return computeGeneral(&vData[0].re, &vData[0].im, 2, samples, dir);
+  }
+#ifdef FFT_SPEED_OVER_PRECISION
+  T oneOverSamples = this->_oneOverSamples;
+  if (!this->_oneOverSamples)
+    oneOverSamples = 1.0 / samples;
+#endif
+  const FFTPlan<T> *plan = this->plan(samples, dir);
+  // Reverse bits
+  bitReverse(vData, samples, plan);
+  // Compute the FFT
+  butterflies(vData, samples, exponent(samples), dir, plan);
+  // Scaling for reverse transform
+  if (dir == FFTDirection::Reverse) {
+    for (uint_fast16_t i = 0; i < samples; i++) {
+#ifdef FFT_SPEED_OVER_PRECISION
+      vData[i].re *= oneOverSamples;
+      vData[i].im *= oneOverSamples;
+#else
+      vData[i].re /= samples;
+      vData[i].im /= samples;
+#endif
+    }
+  }
+  return true;
+}
+
+// Spectra of count frames of samples values (a power of two), frame f
+// starting at vData[f * hop], written to the rows of vOut: samples / 2 + 1
+// values per row on the given scale, multiplied by gain (see
+// realToSpectrum()). Each frame is summed for its mean, then copied to the
+// work space with the mean removed, the window applied and the samples in bit
+// reversed order in one pass. The window factors and the plan are looked up
+// once for all frames. With FFT_BATCH_THREADS above 1 the frames are shared
+// among that many threads. Returns false, leaving vOut unchanged, if samples is not a power
+// of two or the work buffers cannot be allocated.
+template <typename T>
+bool ArduinoFFT<T>::computeBatch(const T *vData, uint_fast16_t samples,
+                                 uint_fast16_t hop, uint_fast16_t count,
+                                 T *vOut, FFTWindow windowType, FFTScale scale,
+                                 T gain) const {
+  if (samples < 4 || (samples & (samples - 1)) != 0) {
+    return false;
+  }
+  // One frame of work space per thread, then half a window of factors
+  T *work =
+      fftAllocate<T>(FFT_BATCH_THREADS * samples + (samples >> 1), "FFT batch");
+  if (work == nullptr) {
+    return false;
+  }
+  T *windowingFactors = work + FFT_BATCH_THREADS * samples;
+  for (uint_fast16_t i = 0; i < (samples >> 1); i++) {
+    windowingFactors[i] = weighingFactor(windowType, i, samples);
+  }
+  // Looked up here, so the threads do not touch the plan cache
+  const FFTPlan<T> *plan = this->plan(samples, FFTDirection::Forward);
+#if FFT_BATCH_THREADS > 1
+  std::thread threads[FFT_BATCH_THREADS - 1];
+  for (uint_fast16_t t = 1; t < FFT_BATCH_THREADS; t++) {
+    threads[t - 1] = std::thread(&ArduinoFFT<T>::batchFrames, this, vData,
+                                 samples, hop, count, vOut, scale, gain,
+                                 windowingFactors, plan, work + t * samples, t);
+  }
+#endif
+  batchFrames(vData, samples, hop, count, vOut, scale, gain, windowingFactors,
+              plan, work, 0);
+#if FFT_BATCH_THREADS > 1
+  for (uint_fast16_t t = 1; t < FFT_BATCH_THREADS; t++) {
+    threads[t - 1].join();
+  }
+#endif
+  fftRelease(work);
+  return true;
+}
+
+template <typename T> void ArduinoFFT<T>::computeReal(bool prepared) const {
+  computeReal(this->_vReal, this->_samples, prepared);
+}
+
+// Computes the forward FFT of samples real values in-place, using a complex
+// FFT of half the size. On return vData holds the samples / 2 + 1 useful bins:
+// vData[k] is the real and vData[samples / 2 + k] the imaginary part of bin k
+// for 0 < k < samples / 2, vData[0] is the DC bin and vData[samples / 2] the
+// Nyquist bin (both purely real). No imaginary array is needed. If prepared is
+// set, vData is already in bit reversed order, see prepare(). Powers of two
+// only; other sizes need the complex compute().
+template <typename T>
+void ArduinoFFT<T>::computeReal(T *vData, uint_fast16_t samples,
+                                bool prepared) const {
+  const FFTPlan<T> *plan = this->plan(samples, FFTDirection::Forward);
+  if (!prepared) {
+    bitReverse(vData, nullptr, samples, plan);
+  }
+  computeRealPrepared(vData, samples, plan);
+}
+
+// computeReal() of bit reversed data, with the forward plan of samples points
+// or a null pointer for the recurrence
+template <typename T>
+void ArduinoFFT<T>::computeRealPrepared(T *vData, uint_fast16_t samples,
+                                        const FFTPlan<T> *plan) const {
+  uint_fast16_t half = samples >> 1;
+  T *vImag = vData + half;
+  // Even samples become the real and odd samples the imaginary part of a
+  // half-size complex sequence. A full-size bit reversal moves the even samples
+  // to the first half and the odd ones to the second half, both already in
+  // half-size bit reversed order, so the butterflies can run right away. The
+  // full-size plan serves the half-size butterflies at twice the stride.
+  butterflies(vData, vImag, half, exponent(half), FFTDirection::Forward, plan);
+  // Split the interleaved spectrum into the spectrum of the real input
+  T zr = vData[0];
+  T zi = vImag[0];
+  vData[0] = zr + zi;
+  vImag[0] = zr - zi;
+  T c = 1.0;
+  T s = 0.0;
+  if (!plan) {
+    c = cos(twoPi / samples);
+    s = -sin(twoPi / samples);
+  }
+  T wr = c;
+  T wi = s;
+  uint_fast16_t k = 1;
+  for (; (k << 1) < half; k++) {
+    if (plan) {
+      wr = plan->cosTable()[k];
+      wi = plan->sinTable()[k];
+    }
+    uint_fast16_t m = half - k;
+    T er = 0.5 * (vData[k] + vData[m]);
+    T ei = 0.5 * (vImag[k] - vImag[m]);
+    T or_ = 0.5 * (vImag[k] + vImag[m]);
+    T oi = 0.5 * (vData[m] - vData[k]);
+    T tr = wr * or_ - wi * oi;
+    T ti = wr * oi + wi * or_;
+    vData[k] = er + tr;
+    vImag[k] = ei + ti;
+    vData[m] = er - tr;
+    vImag[m] = ti - ei;
+    if (!plan) {
+      T z = wr * c - wi * s;
+      wi = wr * s + wi * c;
+      wr = z;
+    }
+  }
+  // Bin samples / 4 pairs with itself and is the conjugate of the complex bin
+  if ((k << 1) == half) {
+    vImag[k] = -vImag[k];
+  }
+}
+
+// Inverse of computeReal(): turns the samples / 2 + 1 bins in the packed
+// layout of computeReal() back into samples real values, in-place. The
+// spectrum is merged into the half-size spectrum of z[n] = x[2n] + i x[2n+1],
+// transformed back with a half-size complex FFT, and the even and odd samples
+// are then interleaved by two bit reversal passes.
+template <typename T>
+void ArduinoFFT<T>::computeRealInverse(T *vData, uint_fast16_t samples) const {
+  uint_fast16_t half = samples >> 1;
+  T *vImag = vData + half;
+  const FFTPlan<T> *plan = this->plan(samples, FFTDirection::Reverse);
+  // The halving of the even and odd parts and the 1 / half of the inverse
+  // transform are both folded in here
+  T scale = 1.0 / samples;
+  T dc = vData[0];
+  T nyquist = vImag[0];
+  vData[0] = (dc + nyquist) * scale;
+  vImag[0] = (dc - nyquist) * scale;
+  T c = 1.0;
+  T s = 0.0;
+  if (!plan) {
+    c = cos(twoPi / samples);
+    s = sin(twoPi / samples);
+  }
+  T wr = c;
+  T wi = s;
+  uint_fast16_t k = 1;
+  for (; (k << 1) < half; k++) {
+    if (plan) {
+      wr = plan->cosTable()[k];
+      wi = plan->sinTable()[k];
+    }
+    uint_fast16_t m = half - k;
+    T er = vData[k] + vData[m];
+    T ei = vImag[k] - vImag[m];
+    T dr = vData[k] - vData[m];
+    T di = vImag[k] + vImag[m];
+    T or_ = dr * wr - di * wi;
+    T oi = dr * wi + di * wr;
+    vData[k] = (er - oi) * scale;
+    vImag[k] = (ei + or_) * scale;
+    vData[m] = (er + oi) * scale;
+    vImag[m] = (or_ - ei) * scale;
+    if (!plan) {
+      T z = wr * c - wi * s;
+      wi = wr * s + wi * c;
+      wr = z;
+    }
+  }
+  if ((k << 1) == half) {
+    vData[k] *= 2.0 * scale;
+    vImag[k] *= -2.0 * scale;
+  }
+  bitReverse(vData, vImag, half, plan);
+  butterflies(vData, vImag, half, exponent(half), FFTDirection::Reverse, plan);
+  // vData[n] holds x[2n] and vImag[n] holds x[2n + 1]
+  bitReverse(vData, nullptr, half, plan);
+  bitReverse(vImag, nullptr, half, plan);
+  bitReverse(vData, nullptr, samples, plan);
 }
 
 template <typename T> void ArduinoFFT<T>::dcRemoval(void) const {
@@ -162,6 +445,25 @@ void ArduinoFFT<T>::dcRemoval(T *vData, uint_fast16_t samples) const {
   }
 }
 
+// Base 2 logarithm from the float exponent and a cubic fit of the mantissa in
+// [1, 2). The absolute error is below 6.5e-4, or 0.002 dB in 10 * log10(),
+// for all positive normal values; 0 yields about -127 instead of -inf. Double
+// arguments are rounded to float first.
+template <typename T> T ArduinoFFT<T>::fastLog2(T x) {
+  union // get bits for floating point value
+  {
+    float x;
+    int32_t i;
+  } u;
+  u.x = x;
+  T exponent = T(((u.i >> 23) & 0xff) - 127);
+  u.i = (u.i & 0x007fffff) | 0x3f800000; // Mantissa in [1, 2)
+  T m = T(u.x) - 1.0;
+  return exponent +
+         (0.000637121 + m * (1.418880136 + m * (-0.577128707 +
+                                                 m * 0.158248561)));
+}
+
 template <typename T> T ArduinoFFT<T>::majorPeak(void) const {
   return majorPeak(this->_vReal, this->_samples, this->_samplingFrequency);
 }
@@ -185,24 +487,46 @@ void ArduinoFFT<T>::majorPeak(T *vData, uint_fast16_t samples,
   T maxY = 0;
   uint_fast16_t IndexOfMaxY = 0;
   findMaxY(vData, (samples >> 1) + 1, &maxY, &IndexOfMaxY);
+  // No local maximum, so no neighbours to interpolate from
+  if (IndexOfMaxY == 0) {
+    *frequency = 0;
+    if (magnitude != nullptr) {
+      *magnitude = maxY;
+    }
+    return;
+  }
+  interpolatePeak(vData[IndexOfMaxY - 1], vData[IndexOfMaxY],
+                  vData[IndexOfMaxY + 1], IndexOfMaxY, samples,
+                  samplingFrequency, frequency, magnitude);
+}
 
-  T delta = 0.5 * ((vData[IndexOfMaxY - 1] - vData[IndexOfMaxY + 1]) /
-                   (vData[IndexOfMaxY - 1] - (2.0 * vData[IndexOfMaxY]) +
-                    vData[IndexOfMaxY + 1]));
-  T interpolatedX = ((IndexOfMaxY + delta) * samplingFrequency) / (samples - 1);
-  if (IndexOfMaxY == (samples >> 1)) // To improve calculation on edge values
-    interpolatedX = ((IndexOfMaxY + delta) * samplingFrequency) / (samples);
-  // returned value: interpolated frequency peak apex
-  *frequency = interpolatedX;
-  if (magnitude != nullptr) {
-#if defined(ESP8266) || defined(ESP32)
-    *magnitude = fabs(vData[IndexOfMaxY - 1] - (2.0 * vData[IndexOfMaxY]) +
-                      vData[IndexOfMaxY + 1]);
-#else
-    *magnitude = abs(vData[IndexOfMaxY - 1] - (2.0 * vData[IndexOfMaxY]) +
-                     vData[IndexOfMaxY + 1]);
-#endif
+template <typename T>
+T ArduinoFFT<T>::majorPeak(FFTComplex<T> *vData, uint_fast16_t samples,
+                           T samplingFrequency) const {
+  T frequency;
+  majorPeak(vData, samples, samplingFrequency, &frequency, nullptr);
+  return frequency;
+}
+
+// Peak of the magnitudes held in the real parts of an interleaved buffer
+template <typename T>
+void ArduinoFFT<T>::majorPeak(FFTComplex<T> *vData, uint_fast16_t samples,
+                              T samplingFrequency, T *frequency,
+                              T *magnitude) const {
+  T maxY = 0;
+  uint_fast16_t IndexOfMaxY = 0;
+  findMaxY(vData, (samples >> 1) + 1, &maxY, &IndexOfMaxY);
+  // No local maximum, so no neighbours to interpolate from
+  if (IndexOfMaxY == 0) {
+    *frequency = 0;
+    if (magnitude != nullptr) {
+      *magnitude = maxY;
+    }
+    return;
   }
+  interpolatePeak(vData[IndexOfMaxY - 1].re, vData[IndexOfMaxY].re,
+                  vData[IndexOfMaxY + 1].re, IndexOfMaxY, samples,
+                  samplingFrequency, frequency, magnitude);
 }
 
 template <typename T> T ArduinoFFT<T>::majorPeakParabola(void) const {
@@ -255,6 +579,135 @@ void ArduinoFFT<T>::majorPeakParabola(T *vData, uint_fast16_t samples,
   }
 }
 
+template <typename T> void ArduinoFFT<T>::realToMagnitude(void) const {
+  realToMagnitude(this->_vReal, this->_samples);
+}
+
+// Converts the output of computeReal to magnitudes, stored in
+// vData[0] ... vData[samples / 2]
+template <typename T>
+void ArduinoFFT<T>::realToMagnitude(T *vData, uint_fast16_t samples) const {
+  uint_fast16_t half = samples >> 1;
+  T nyquist = vData[half];
+  vData[0] = sqrt_internal(sq(vData[0]));
+  if (!simdComplexToMagnitude(vData + 1, vData + half + 1, half - 1)) {
+    for (uint_fast16_t i = 1; i < half; i++) {
+      vData[i] = sqrt_internal(sq(vData[i]) + sq(vData[half + i]));
+    }
+  }
+  vData[half] = sqrt_internal(sq(nyquist));
+}
+
+// Same as complexToSpectrum() for the packed output of computeReal(): the
+// samples / 2 + 1 bins replace vData[0] to vData[samples / 2].
+template <typename T>
+void ArduinoFFT<T>::realToSpectrum(T *vData, uint_fast16_t samples,
+                                   FFTScale scale, T gain) const {
+  uint_fast16_t half = samples >> 1;
+  T nyquist = vData[half];
+  vData[0] = sq(vData[0]);
+  for (uint_fast16_t i = 1; i < half; i++) {
+    vData[i] = sq(vData[i]) + sq(vData[half + i]);
+  }
+  vData[half] = sq(nyquist);
+  powerToSpectrum(vData, vData, half + 1, scale, gain);
+}
+
+// Converts bins power values (squared magnitudes) from vPower to the given
+// scale in vData, multiplied by gain. vPower and vData may be the same array.
+template <typename T>
+void ArduinoFFT<T>::powerToSpectrum(const T *vPower, T *vData,
+                                    uint_fast16_t bins, FFTScale scale,
+                                    T gain) {
+  // One loop per scale, so each can be unrolled or vectorized
+  switch (scale) {
+  case FFTScale::Power: {
+    T gainSquared = gain * gain;
+    for (uint_fast16_t i = 0; i < bins; i++) {
+      vData[i] = vPower[i] * gainSquared;
+    }
+    break;
+  }
+  case FFTScale::Magnitude:
+    for (uint_fast16_t i = 0; i < bins; i++) {
+      vData[i] = sqrt(vPower[i]) * gain;
+    }
+    break;
+  default: {
+    T offset = 20.0 * log10(gain);
+    for (uint_fast16_t i = 0; i < bins; i++) {
+      vData[i] = 3.0102999566 * fastLog2(vPower[i]) + offset; // 10 * log10(2)
+    }
+    break;
+  }
+  }
+}
+
+template <typename T>
+void ArduinoFFT<T>::prepare(FFTWindow windowType, T mean) {
+  // Same use of the precompiled factors as windowing(), without compensation
+  if (this->_precompiledWindowingFactors && this->_isPrecompiled &&
+      this->_windowFunction == windowType &&
+      !this->_precompiledWithCompensation) {
+    prepare(this->_vReal, this->_samples, FFTWindow::Precompiled, mean,
+            this->_precompiledWindowingFactors);
+  } else if (this->_precompiledWindowingFactors) {
+    prepare(this->_vReal, this->_samples, windowType, mean,
+            this->_precompiledWindowingFactors);
+    this->_isPrecompiled = true;
+    this->_precompiledWithCompensation = false;
+    this->_windowFunction = windowType;
+  } else {
+    prepare(this->_vReal, this->_samples, windowType, mean);
+  }
+}
+
+// Subtracts mean, applies the forward window and moves every sample to its bit
+// reversed position in a single pass over vData, replacing dcRemoval(),
+// windowing() and the bit reversal at the start of computeReal(vData, samples,
+// true). The mean is best accumulated while the frame is acquired or copied,
+// see STFT<T>::nextFrame(). Given windowingFactors, they are filled first
+// unless windowType is FFTWindow::Precompiled.
+template <typename T>
+void ArduinoFFT<T>::prepare(T *vData, uint_fast16_t samples,
+                            FFTWindow windowType, T mean,
+                            T *windowingFactors) const {
+  uint_fast16_t half = samples >> 1;
+  uint_fast16_t last = samples - 1;
+  if (windowingFactors && windowType != FFTWindow::Precompiled) {
+    for (uint_fast16_t i = 0; i < half; i++) {
+      windowingFactors[i] = weighingFactor(windowType, i, samples);
+    }
+  }
+  const FFTPlan<T> *plan = this->plan(samples, FFTDirection::Forward);
+  uint_fast16_t j = 0;
+  for (uint_fast16_t i = 0; i < samples; i++) {
+    if (plan) {
+      j = plan->bitReverse()[i];
+    }
+    // Each pair is visited once, from its lower index
+    if (i <= j) {
+      uint_fast16_t wi = i < half ? i : last - i;
+      uint_fast16_t wj = j < half ? j : last - j;
+      T factorI = windowingFactors ? windowingFactors[wi]
+                                   : weighingFactor(windowType, wi, samples);
+      T factorJ = windowingFactors ? windowingFactors[wj]
+                                   : weighingFactor(windowType, wj, samples);
+      T value = vData[i];
+      vData[i] = (vData[j] - mean) * factorJ;
+      vData[j] = (value - mean) * factorI;
+    }
+    if (!plan && i < last) {
+      uint_fast16_t k = half;
+      while (k <= j) {
+        j -= k;
+        k >>= 1;
+      }
+      j += k;
+    }
+  }
+}
+
 template <typename T> uint8_t ArduinoFFT<T>::revision(void) {
   return (FFT_LIB_REV);
 }
@@ -270,12 +723,17 @@ void ArduinoFFT<T>::setArrays(T *vReal, T *vImag, uint_fast16_t samples) {
     _oneOverSamples = 1.0 / samples;
 #endif
     if (_precompiledWindowingFactors) {
-      delete [] _precompiledWindowingFactors;
+      fftRelease(_precompiledWindowingFactors);
     }
-    _precompiledWindowingFactors = new T[samples / 2];
+    _precompiledWindowingFactors = fftAllocate<T>(samples / 2, "FFT window");
   }
 }
 
+// Selects how compute() and computeReal() evaluate the butterflies
+template <typename T> void ArduinoFFT<T>::setKernel(FFTKernel kernel) {
+  _kernel = kernel;
+}
+
 template <typename T>
 void ArduinoFFT<T>::windowing(FFTWindow windowType, FFTDirection dir,
                               bool withCompensation) {
@@ -308,6 +766,10 @@ void ArduinoFFT<T>::windowing(T *vData, uint_fast16_t samples,
   // Weighing factors are computed once before multiple use of FFT
   // The weighing function is symmetric; half the weighs are recorded
   if (windowingFactors != nullptr && windowType == FFTWindow::Precompiled) {
+    if (dir == FFTDirection::Forward &&
+        simdWindowing(vData, samples, windowingFactors)) {
+      return;
+    }
     for (uint_fast16_t i = 0; i < (samples >> 1); i++) {
       if (dir == FFTDirection::Forward) {
         vData[i] *= windowingFactors[i];
@@ -324,67 +786,13 @@ void ArduinoFFT<T>::windowing(T *vData, uint_fast16_t samples,
       }
     }
   } else {
-    T samplesMinusOne = (T(samples) - 1.0);
     T compensationFactor;
     if (withCompensation) {
       compensationFactor =
           _WindowCompensationFactors[static_cast<uint_fast8_t>(windowType)];
     }
     for (uint_fast16_t i = 0; i < (samples >> 1); i++) {
-      T indexMinusOne = T(i);
-      T ratio = (indexMinusOne / samplesMinusOne);
-      T weighingFactor = 1.0;
-      // Compute and record weighting factor
-      switch (windowType) {
-      case FFTWindow::Hamming: // hamming
-        weighingFactor = 0.54 - (0.46 * cos(twoPi * ratio));
-        break;
-      case FFTWindow::Hann: // hann
-        weighingFactor = 0.54 * (1.0 - cos(twoPi * ratio));
-        break;
-      case FFTWindow::Triangle: // triangle (Bartlett)
-#if defined(ESP8266) || defined(ESP32)
-        weighingFactor =
-            1.0 - ((2.0 * fabs(indexMinusOne - (samplesMinusOne / 2.0))) /
-                   samplesMinusOne);
-#else
-        weighingFactor =
-            1.0 - ((2.0 * abs(indexMinusOne - (samplesMinusOne / 2.0))) /
-                   samplesMinusOne);
-#endif
-        break;
-      case FFTWindow::Nuttall: // nuttall
-        weighingFactor = 0.355768 - (0.487396 * (cos(twoPi * ratio))) +
-                         (0.144232 * (cos(fourPi * ratio))) -
-                         (0.012604 * (cos(sixPi * ratio)));
-        break;
-      case FFTWindow::Blackman: // blackman
-        weighingFactor = 0.42323 - (0.49755 * (cos(twoPi * ratio))) +
-                         (0.07922 * (cos(fourPi * ratio)));
-        break;
-      case FFTWindow::Blackman_Nuttall: // blackman nuttall
-        weighingFactor = 0.3635819 - (0.4891775 * (cos(twoPi * ratio))) +
-                         (0.1365995 * (cos(fourPi * ratio))) -
-                         (0.0106411 * (cos(sixPi * ratio)));
-        break;
-      case FFTWindow::Blackman_Harris: // blackman harris
-        weighingFactor = 0.35875 - (0.48829 * (cos(twoPi * ratio))) +
-                         (0.14128 * (cos(fourPi * ratio))) -
-                         (0.01168 * (cos(sixPi * ratio)));
-        break;
-      case FFTWindow::Flat_top: // flat top
-        weighingFactor = 0.2810639 - (0.5208972 * cos(twoPi * ratio)) +
-                         (0.1980399 * cos(fourPi * ratio));
-        break;
-      case FFTWindow::Welch: // welch
-        weighingFactor = 1.0 - sq((indexMinusOne - samplesMinusOne / 2.0) /
-                                  (samplesMinusOne / 2.0));
-        break;
-      default:
-        // This is Rectangle windowing which doesn't do anything
-        // and Precompiled which shouldn't be selected
-        break;
-      }
+      T weighingFactor = ArduinoFFT<T>::weighingFactor(windowType, i, samples);
       if (withCompensation) {
         weighingFactor *= compensationFactor;
       }
@@ -408,8 +816,317 @@ void ArduinoFFT<T>::windowing(T *vData, uint_fast16_t samples,
   }
 }
 
+// Weighing factor of sample i of a window of the given size
+template <typename T>
+T ArduinoFFT<T>::weighingFactor(FFTWindow windowType, uint_fast16_t i,
+                                uint_fast16_t samples) {
+  T samplesMinusOne = (T(samples) - 1.0);
+  T indexMinusOne = T(i);
+  T ratio = (indexMinusOne / samplesMinusOne);
+  T weighingFactor = 1.0;
+  // Compute weighting factor
+  switch (windowType) {
+  case FFTWindow::Hamming: // hamming
+    weighingFactor = 0.54 - (0.46 * cos(twoPi * ratio));
+    break;
+  case FFTWindow::Hann: // hann
+    weighingFactor = 0.54 * (1.0 - cos(twoPi * ratio));
+    break;
+  case FFTWindow::Triangle: // triangle (Bartlett)
+#if defined(ESP8266) || defined(ESP32)
+    weighingFactor =
+        1.0 - ((2.0 * fabs(indexMinusOne - (samplesMinusOne / 2.0))) /
+               samplesMinusOne);
+#else
+    weighingFactor =
+        1.0 - ((2.0 * abs(indexMinusOne - (samplesMinusOne / 2.0))) /
+               samplesMinusOne);
+#endif
+    break;
+  case FFTWindow::Nuttall: // nuttall
+    weighingFactor = 0.355768 - (0.487396 * (cos(twoPi * ratio))) +
+                     (0.144232 * (cos(fourPi * ratio))) -
+                     (0.012604 * (cos(sixPi * ratio)));
+    break;
+  case FFTWindow::Blackman: // blackman
+    weighingFactor = 0.42323 - (0.49755 * (cos(twoPi * ratio))) +
+                     (0.07922 * (cos(fourPi * ratio)));
+    break;
+  case FFTWindow::Blackman_Nuttall: // blackman nuttall
+    weighingFactor = 0.3635819 - (0.4891775 * (cos(twoPi * ratio))) +
+                     (0.1365995 * (cos(fourPi * ratio))) -
+                     (0.0106411 * (cos(sixPi * ratio)));
+    break;
+  case FFTWindow::Blackman_Harris: // blackman harris
+    weighingFactor = 0.35875 - (0.48829 * (cos(twoPi * ratio))) +
+                     (0.14128 * (cos(fourPi * ratio))) -
+                     (0.01168 * (cos(sixPi * ratio)));
+    break;
+  case FFTWindow::Flat_top: // flat top
+    weighingFactor = 0.2810639 - (0.5208972 * cos(twoPi * ratio)) +
+                     (0.1980399 * cos(fourPi * ratio));
+    break;
+  case FFTWindow::Welch: // welch
+    weighingFactor = 1.0 - sq((indexMinusOne - samplesMinusOne / 2.0) /
+                              (samplesMinusOne / 2.0));
+    break;
+  default:
+    // This is Rectangle windowing which doesn't do anything
+    // and Precompiled which shouldn't be selected
+    break;
+  }
+  return weighingFactor;
+}
+
 // Private functions
 
+// Frames first, first + FFT_BATCH_THREADS, ... of computeBatch(), through one
+// frame of work space. Each frame is read twice: once for its mean, and once
+// to fill work in bit reversed order as prepare() would, with position i
+// taking sample j.
+template <typename T>
+void ArduinoFFT<T>::batchFrames(const T *vData, uint_fast16_t samples,
+                                uint_fast16_t hop, uint_fast16_t count,
+                                T *vOut, FFTScale scale, T gain,
+                                const T *windowingFactors,
+                                const FFTPlan<T> *plan, T *work,
+                                uint_fast16_t first) const {
+  uint_fast16_t half = samples >> 1;
+  uint_fast16_t last = samples - 1;
+  uint_fast16_t bins = half + 1;
+  const uint16_t *reverse = plan ? plan->bitReverse() : nullptr;
+  for (uint_fast16_t f = first; f < count; f += FFT_BATCH_THREADS) {
+    const T *frame = vData + (size_t)f * hop;
+    T mean = 0;
+    for (uint_fast16_t i = 0; i < samples; i++) {
+      mean += frame[i];
+    }
+    mean /= samples;
+    uint_fast16_t j = 0;
+    for (uint_fast16_t i = 0; i < samples; i++) {
+      if (reverse) {
+        j = reverse[i];
+      }
+      work[i] = (frame[j] - mean) * windowingFactors[j < half ? j : last - j];
+      if (!reverse && i < last) {
+        uint_fast16_t k = half;
+        while (k <= j) {
+          j -= k;
+          k >>= 1;
+        }
+        j += k;
+      }
+    }
+    computeRealPrepared(work, samples, plan);
+    realToSpectrum(work, samples, scale, gain);
+    T *row = vOut + (size_t)f * bins;
+    for (uint_fast16_t i = 0; i < bins; i++) {
+      row[i] = work[i];
+    }
+  }
+}
+
+template <typename T>
+void ArduinoFFT<T>::bitReverse(T *vReal, T *vImag, uint_fast16_t samples,
+                               const FFTPlan<T> *plan) const {
+  // vImag may be a null pointer if the imaginary part is known to be zero. A
+  // plan of a larger size serves as well: for indices below samples, its
+  // reversed indices are the wanted ones shifted left.
+  if (plan) {
+    const uint16_t *reverse = plan->bitReverse();
+    uint_fast8_t shift = exponent(plan->samples() / samples);
+    for (uint_fast16_t i = 1; i < (samples - 1); i++) {
+      uint_fast16_t j = reverse[i] >> shift;
+      if (i < j) {
+        swap(&vReal[i], &vReal[j]);
+        if (vImag)
+          swap(&vImag[i], &vImag[j]);
+      }
+    }
+    return;
+  }
+  uint_fast16_t j = 0;
+  for (uint_fast16_t i = 0; i < (samples - 1); i++) {
+    if (i < j) {
+      swap(&vReal[i], &vReal[j]);
+      if (vImag)
+        swap(&vImag[i], &vImag[j]);
+    }
+    uint_fast16_t k = (samples >> 1);
+
+    while (k <= j) {
+      j -= k;
+      k >>= 1;
+    }
+    j += k;
+  }
+}
+
+template <typename T>
+void ArduinoFFT<T>::bitReverse(FFTComplex<T> *vData, uint_fast16_t samples,
+                               const FFTPlan<T> *plan) const {
+  uint_fast16_t j = 0;
+  for (uint_fast16_t i = 1; i < (samples - 1); i++) {
+    if (plan) {
+      j = plan->bitReverse()[i];
+    } else {
+      uint_fast16_t k = (samples >> 1);
+      while (k & j) {
+        j ^= k;
+        k >>= 1;
+      }
+      j |= k;
+    }
+    if (i < j) {
+      FFTComplex<T> temp = vData[i];
+      vData[i] = vData[j];
+      vData[j] = temp;
+    }
+  }
+}
+
+// Radix-2 decimation in time butterflies on bit reversed input. The plan may
+// be for a multiple of samples, its tables are then read with a stride.
+template <typename T>
+void ArduinoFFT<T>::butterflies(T *vReal, T *vImag, uint_fast16_t samples,
+                                uint_fast8_t power, FFTDirection dir,
+                                const FFTPlan<T> *plan) const {
+  if (plan && _kernel == FFTKernel::Radix4) {
+    butterfliesRadix4(vReal, vImag, samples, power, plan);
+    return;
+  }
+  if (plan && simdButterflies(vReal, vImag, samples, plan)) {
+    return;
+  }
+  if (plan) {
+    const T *cosTable = plan->cosTable();
+    const T *sinTable = plan->sinTable();
+    for (uint_fast16_t l1 = 1; l1 < samples; l1 <<= 1) {
+      uint_fast16_t l2 = l1 << 1;
+      uint_fast16_t step = plan->samples() / l2;
+      for (uint_fast16_t j = 0; j < l1; j++) {
+        T u1 = cosTable[j * step];
+        T u2 = sinTable[j * step];
+        for (uint_fast16_t i = j; i < samples; i += l2) {
+          uint_fast16_t i1 = i + l1;
+          T t1 = u1 * vReal[i1] - u2 * vImag[i1];
+          T t2 = u1 * vImag[i1] + u2 * vReal[i1];
+          vReal[i1] = vReal[i] - t1;
+          vImag[i1] = vImag[i] - t2;
+          vReal[i] += t1;
+          vImag[i] += t2;
+        }
+      }
+    }
+    return;
+  }
+  T c1 = -1.0;
+  T c2 = 0.0;
+  uint_fast16_t l2 = 1;
+  for (uint_fast8_t l = 0; (l < power); l++) {
+    uint_fast16_t l1 = l2;
+    l2 <<= 1;
+    T u1 = 1.0;
+    T u2 = 0.0;
+    for (uint_fast16_t j = 0; j < l1; j++) {
+      for (uint_fast16_t i = j; i < samples; i += l2) {
+        uint_fast16_t i1 = i + l1;
+        T t1 = u1 * vReal[i1] - u2 * vImag[i1];
+        T t2 = u1 * vImag[i1] + u2 * vReal[i1];
+        vReal[i1] = vReal[i] - t1;
+        vImag[i1] = vImag[i] - t2;
+        vReal[i] += t1;
+        vImag[i] += t2;
+      }
+      T z = ((u1 * c1) - (u2 * c2));
+      u2 = ((u1 * c2) + (u2 * c1));
+      u1 = z;
+    }
+
+#if defined(__AVR__) && defined(USE_AVR_PROGMEM)
+    c2 = pgm_read_float_near(&(_c2[l]));
+    c1 = pgm_read_float_near(&(_c1[l]));
+#else
+    T cTemp = 0.5 * c1;
+    c2 = sqrt_internal(0.5 - cTemp);
+    c1 = sqrt_internal(0.5 + cTemp);
+#endif
+
+    if (dir == FFTDirection::Forward) {
+      c2 = -c2;
+    }
+  }
+}
+
+// Radix-2 butterflies on an interleaved buffer, as above. With a plan the
+// blocks are the outer loop and each block's pairs are read in order. Running
+// over j first strides across the whole buffer l1 times per stage, which
+// misses the cache on every pair once the buffer no longer fits.
+template <typename T>
+void ArduinoFFT<T>::butterflies(FFTComplex<T> *vData, uint_fast16_t samples,
+                                uint_fast8_t power, FFTDirection dir,
+                                const FFTPlan<T> *plan) const {
+  if (plan) {
+    const T *cosTable = plan->cosTable();
+    const T *sinTable = plan->sinTable();
+    for (uint_fast16_t l1 = 1; l1 < samples; l1 <<= 1) {
+      uint_fast16_t l2 = l1 << 1;
+      uint_fast16_t step = plan->samples() / l2;
+      for (uint_fast16_t i = 0; i < samples; i += l2) {
+        FFTComplex<T> *a = &vData[i];
+        FFTComplex<T> *b = &vData[i + l1];
+        for (uint_fast16_t j = 0; j < l1; j++) {
+          T u1 = cosTable[j * step];
+          T u2 = sinTable[j * step];
+          T t1 = u1 * b[j].re - u2 * b[j].im;
+          T t2 = u1 * b[j].im + u2 * b[j].re;
+          b[j].re = a[j].re - t1;
+          b[j].im = a[j].im - t2;
+          a[j].re += t1;
+          a[j].im += t2;
+        }
+      }
+    }
+    return;
+  }
+  T c1 = -1.0;
+  T c2 = 0.0;
+  uint_fast16_t l2 = 1;
+  for (uint_fast8_t l = 0; (l < power); l++) {
+    uint_fast16_t l1 = l2;
+    l2 <<= 1;
+    T u1 = 1.0;
+    T u2 = 0.0;
+    for (uint_fast16_t j = 0; j < l1; j++) {
+      for (uint_fast16_t i = j; i < samples; i += l2) {
+        FFTComplex<T> *a = &vData[i];
+        FFTComplex<T> *b = &vData[i + l1];
+        T t1 = u1 * b->re - u2 * b->im;
+        T t2 = u1 * b->im + u2 * b->re;
+        b->re = a->re - t1;
+        b->im = a->im - t2;
+        a->re += t1;
+        a->im += t2;
+      }
+      T z = ((u1 * c1) - (u2 * c2));
+      u2 = ((u1 * c2) + (u2 * c1));
+      u1 = z;
+    }
+#if defined(__AVR__) && defined(USE_AVR_PROGMEM)
+    c2 = pgm_read_float_near(&(_c2[l]));
+    c1 = pgm_read_float_near(&(_c1[l]));
+#else
+    T cTemp = 0.5 * c1;
+    c2 = sqrt_internal(0.5 - cTemp);
+    c1 = sqrt_internal(0.5 + cTemp);
+#endif
+
+    if (dir == FFTDirection::Forward) {
+      c2 = -c2;
+    }
+  }
+}
+
 template <typename T>
 uint_fast8_t ArduinoFFT<T>::exponent(uint_fast16_t value) const {
   // Calculates the base 2 logarithm of a value
@@ -419,14 +1136,323 @@ uint_fast8_t ArduinoFFT<T>::exponent(uint_fast16_t value) const {
   return result;
 }
 
+// Mixed radix decimation in time butterflies on input permuted by permute().
+// Stage s combines radix(s) transforms of span points into one of
+// span * radix(s) points. Element i is at vReal[i * stride] and
+// vImag[i * stride], so interleaved buffers work with a stride of 2.
+template <typename T>
+void ArduinoFFT<T>::butterfliesMixed(T *vReal, T *vImag, uint_fast8_t stride,
+                                     uint_fast16_t samples,
+                                     const FFTPlan<T> *plan) const {
+  const T *cosTable = plan->cosTable();
+  const T *sinTable = plan->sinTable();
+  // Sign of the imaginary unit in the roots of unity of the direction
+  T sign = (plan->direction() == FFTDirection::Forward) ? -1.0 : 1.0;
+  const T sin60 = sign * 0.86602540378443864676;
+  const T cos72 = 0.30901699437494742410;
+  const T cos144 = -0.80901699437494742410;
+  const T sin72 = sign * 0.95105651629515357212;
+  const T sin144 = sign * 0.58778525229247312917;
+  uint_fast16_t span = 1;
+  for (uint_fast8_t s = 0; s < plan->stages(); s++) {
+    uint_fast8_t radix = plan->radix(s);
+    uint_fast16_t size = span * radix;
+    uint_fast16_t step = samples / size;
+    for (uint_fast16_t j = 0; j < span; j++) {
+      T wr[FFT_MAX_RADIX];
+      T wi[FFT_MAX_RADIX];
+      for (uint_fast8_t q = 1; q < radix; q++) {
+        wr[q] = cosTable[j * q * step];
+        wi[q] = sinTable[j * q * step];
+      }
+      for (uint_fast16_t i = j; i < samples; i += size) {
+        T xr[FFT_MAX_RADIX];
+        T xi[FFT_MAX_RADIX];
+        xr[0] = vReal[i * stride];
+        xi[0] = vImag[i * stride];
+        for (uint_fast8_t q = 1; q < radix; q++) {
+          uint_fast16_t k = (i + q * span) * stride;
+          xr[q] = wr[q] * vReal[k] - wi[q] * vImag[k];
+          xi[q] = wr[q] * vImag[k] + wi[q] * vReal[k];
+        }
+        switch (radix) {
+        case 2: {
+          T tr = xr[1];
+          T ti = xi[1];
+          xr[1] = xr[0] - tr;
+          xi[1] = xi[0] - ti;
+          xr[0] += tr;
+          xi[0] += ti;
+          break;
+        }
+        case 3: {
+          T sr = xr[1] + xr[2];
+          T si = xi[1] + xi[2];
+          T dr = sin60 * (xr[1] - xr[2]);
+          T di = sin60 * (xi[1] - xi[2]);
+          T mr = xr[0] - 0.5 * sr;
+          T mi = xi[0] - 0.5 * si;
+          xr[0] += sr;
+          xi[0] += si;
+          // X1 = m + i * d and X2 = m - i * d
+          xr[1] = mr - di;
+          xi[1] = mi + dr;
+          xr[2] = mr + di;
+          xi[2] = mi - dr;
+          break;
+        }
+        case 4: {
+          T s0r = xr[0] + xr[2];
+          T s0i = xi[0] + xi[2];
+          T d0r = xr[0] - xr[2];
+          T d0i = xi[0] - xi[2];
+          T s1r = xr[1] + xr[3];
+          T s1i = xi[1] + xi[3];
+          // d1 is rotated by the imaginary unit of the direction
+          T d1r = -sign * (xi[1] - xi[3]);
+          T d1i = sign * (xr[1] - xr[3]);
+          xr[0] = s0r + s1r;
+          xi[0] = s0i + s1i;
+          xr[1] = d0r + d1r;
+          xi[1] = d0i + d1i;
+          xr[2] = s0r - s1r;
+          xi[2] = s0i - s1i;
+          xr[3] = d0r - d1r;
+          xi[3] = d0i - d1i;
+          break;
+        }
+        default: {
+          // Radix 5 from the sums and differences of mirrored inputs
+          T s14r = xr[1] + xr[4];
+          T s14i = xi[1] + xi[4];
+          T d14r = xr[1] - xr[4];
+          T d14i = xi[1] - xi[4];
+          T s23r = xr[2] + xr[3];
+          T s23i = xi[2] + xi[3];
+          T d23r = xr[2] - xr[3];
+          T d23i = xi[2] - xi[3];
+          T m1r = xr[0] + cos72 * s14r + cos144 * s23r;
+          T m1i = xi[0] + cos72 * s14i + cos144 * s23i;
+          T m2r = xr[0] + cos144 * s14r + cos72 * s23r;
+          T m2i = xi[0] + cos144 * s14i + cos72 * s23i;
+          T n1r = sin72 * d14r + sin144 * d23r;
+          T n1i = sin72 * d14i + sin144 * d23i;
+          T n2r = sin144 * d14r - sin72 * d23r;
+          T n2i = sin144 * d14i - sin72 * d23i;
+          xr[0] += s14r + s23r;
+          xi[0] += s14i + s23i;
+          // X1 = m1 + i * n1, X4 = m1 - i * n1, X2 = m2 + i * n2, X3 = m2 - i * n2
+          xr[1] = m1r - n1i;
+          xi[1] = m1i + n1r;
+          xr[4] = m1r + n1i;
+          xi[4] = m1i - n1r;
+          xr[2] = m2r - n2i;
+          xi[2] = m2i + n2r;
+          xr[3] = m2r + n2i;
+          xi[3] = m2i - n2r;
+          break;
+        }
+        }
+        for (uint_fast8_t q = 0; q < radix; q++) {
+          uint_fast16_t k = (i + q * span) * stride;
+          vReal[k] = xr[q];
+          vImag[k] = xi[q];
+        }
+      }
+    }
+    span = size;
+  }
+}
+
+// Bluestein's algorithm: the transform as a convolution with a chirp, which
+// is computed with power of two transforms of the plan's work size. With the
+// chirp c[n], X[k] = c[k] * sum(x[n] * c[n] * conj(c[k - n])). The inverse
+// transform of the product runs as a forward one on its conjugate.
+template <typename T>
+void ArduinoFFT<T>::bluestein(T *vReal, T *vImag, uint_fast8_t stride,
+                              uint_fast16_t samples,
+                              const FFTPlan<T> *plan) const {
+  const FFTPlan<T> *inner = plan->inner();
+  uint_fast16_t size = inner->samples();
+  const T *chirpReal = plan->cosTable();
+  const T *chirpImag = plan->sinTable();
+  const T *filterReal = plan->filterReal();
+  const T *filterImag = plan->filterImag();
+  T *workReal = plan->workReal();
+  T *workImag = plan->workImag();
+  for (uint_fast16_t n = 0; n < samples; n++) {
+    T xr = vReal[n * stride];
+    T xi = vImag[n * stride];
+    workReal[n] = xr * chirpReal[n] - xi * chirpImag[n];
+    workImag[n] = xr * chirpImag[n] + xi * chirpReal[n];
+  }
+  for (uint_fast16_t n = samples; n < size; n++) {
+    workReal[n] = 0.0;
+    workImag[n] = 0.0;
+  }
+  bitReverse(workReal, workImag, size, inner);
+  butterflies(workReal, workImag, size, inner->power(), FFTDirection::Forward,
+              inner);
+  for (uint_fast16_t k = 0; k < size; k++) {
+    T wr = workReal[k];
+    T wi = workImag[k];
+    workReal[k] = wr * filterReal[k] - wi * filterImag[k];
+    workImag[k] = -(wr * filterImag[k] + wi * filterReal[k]);
+  }
+  bitReverse(workReal, workImag, size, inner);
+  butterflies(workReal, workImag, size, inner->power(), FFTDirection::Forward,
+              inner);
+  for (uint_fast16_t k = 0; k < samples; k++) {
+    T wr = workReal[k];
+    T wi = -workImag[k];
+    vReal[k * stride] = wr * chirpReal[k] - wi * chirpImag[k];
+    vImag[k * stride] = wr * chirpImag[k] + wi * chirpReal[k];
+  }
+}
+
+// Transforms sizes other than powers of two, with a stride as in
+// butterfliesMixed(). Returns false, leaving the data unchanged, if there is
+// no plan.
+template <typename T>
+bool ArduinoFFT<T>::computeGeneral(T *vReal, T *vImag, uint_fast8_t stride,
+                                   uint_fast16_t samples,
+                                   FFTDirection dir) const {
+  const FFTPlan<T> *plan = FFTPlan<T>::get(samples, dir);
+  if (!plan) {
+    return false;
+  }
+  if (plan->algorithm() == FFTAlgorithm::MixedRadix) {
+    permute(vReal, vImag, stride, plan);
+    butterfliesMixed(vReal, vImag, stride, samples, plan);
+  } else {
+    bluestein(vReal, vImag, stride, samples, plan);
+  }
+  if (dir == FFTDirection::Reverse) {
+    T scale = 1.0 / samples;
+    for (uint_fast16_t i = 0; i < samples; i++) {
+      vReal[i * stride] *= scale;
+      vImag[i * stride] *= scale;
+    }
+  }
+  return true;
+}
+
+// Moves sample bitReverse()[p] of the plan to position p, one permutation
+// cycle at a time
+template <typename T>
+void ArduinoFFT<T>::permute(T *vReal, T *vImag, uint_fast8_t stride,
+                            const FFTPlan<T> *plan) const {
+  const uint16_t *source = plan->bitReverse();
+  const uint16_t *starts = plan->cycleStarts();
+  for (uint_fast16_t c = 0; c < plan->cycles(); c++) {
+    uint_fast16_t start = starts[c];
+    T tr = vReal[start * stride];
+    T ti = vImag[start * stride];
+    uint_fast16_t p = start;
+    for (uint_fast16_t q = source[p]; q != start; q = source[q]) {
+      vReal[p * stride] = vReal[q * stride];
+      vImag[p * stride] = vImag[q * stride];
+      p = q;
+    }
+    vReal[p * stride] = tr;
+    vImag[p * stride] = ti;
+  }
+}
+
+// Radix-4 decimation in time butterflies on (radix-2) bit reversed input.
+// Each pass merges two radix-2 stages, so it touches the data half as often
+// and needs three instead of four complex multiplications per four points.
+template <typename T>
+void ArduinoFFT<T>::butterfliesRadix4(T *vReal, T *vImag,
+                                      uint_fast16_t samples, uint_fast8_t power,
+                                      const FFTPlan<T> *plan) const {
+  const T *cosTable = plan->cosTable();
+  const T *sinTable = plan->sinTable();
+  uint_fast16_t planHalf = plan->samples() >> 1;
+  bool forward = (plan->direction() == FFTDirection::Forward);
+  uint_fast16_t l1 = 1;
+  // Odd powers start with a radix-2 stage, its twiddle factor is always 1
+  if (power & 1) {
+    for (uint_fast16_t i = 0; i < samples; i += 2) {
+      T tr = vReal[i + 1];
+      T ti = vImag[i + 1];
+      vReal[i + 1] = vReal[i] - tr;
+      vImag[i + 1] = vImag[i] - ti;
+      vReal[i] += tr;
+      vImag[i] += ti;
+    }
+    l1 = 2;
+  }
+  for (; l1 < samples; l1 <<= 2) {
+    uint_fast16_t l4 = l1 << 2;
+    uint_fast16_t step = plan->samples() / l4;
+    for (uint_fast16_t j = 0; j < l1; j++) {
+      // w2 = W^(j * step), w1 = w2^2 and w3 = w2^3. The tables hold half a
+      // turn, W^(k + samples / 2) = -W^k covers the rest.
+      uint_fast16_t k = j * step;
+      T w2r = cosTable[k];
+      T w2i = sinTable[k];
+      T w1r = cosTable[k << 1];
+      T w1i = sinTable[k << 1];
+      T w3r, w3i;
+      if (3 * k < planHalf) {
+        w3r = cosTable[3 * k];
+        w3i = sinTable[3 * k];
+      } else {
+        w3r = -cosTable[3 * k - planHalf];
+        w3i = -sinTable[3 * k - planHalf];
+      }
+      for (uint_fast16_t i = j; i < samples; i += l4) {
+        uint_fast16_t i1 = i + l1;
+        uint_fast16_t i2 = i1 + l1;
+        uint_fast16_t i3 = i2 + l1;
+        T t1r = w1r * vReal[i1] - w1i * vImag[i1];
+        T t1i = w1r * vImag[i1] + w1i * vReal[i1];
+        T t2r = w2r * vReal[i2] - w2i * vImag[i2];
+        T t2i = w2r * vImag[i2] + w2i * vReal[i2];
+        T t3r = w3r * vReal[i3] - w3i * vImag[i3];
+        T t3i = w3r * vImag[i3] + w3i * vReal[i3];
+        T s0r = vReal[i] + t1r;
+        T s0i = vImag[i] + t1i;
+        T d0r = vReal[i] - t1r;
+        T d0i = vImag[i] - t1i;
+        T s1r = t2r + t3r;
+        T s1i = t2i + t3i;
+        // d1 is rotated by -i for forward and +i for reverse transforms
+        T d1r = forward ? (t2i - t3i) : (t3i - t2i);
+        T d1i = forward ? (t3r - t2r) : (t2r - t3r);
+        vReal[i] = s0r + s1r;
+        vImag[i] = s0i + s1i;
+        vReal[i1] = d0r + d1r;
+        vImag[i1] = d0i + d1i;
+        vReal[i2] = s0r - s1r;
+        vImag[i2] = s0i - s1i;
+        vReal[i3] = d0r - d1r;
+        vImag[i3] = d0i - d1i;
+      }
+    }
+  }
+}
+
+// Returns the shared plan for the transform, or a null pointer if the
+// recurrence kernel is selected or memory for the plan ran out
+template <typename T>
+const FFTPlan<T> *ArduinoFFT<T>::plan(uint_fast16_t samples,
+                                      FFTDirection dir) const {
+  if (_kernel == FFTKernel::Recurrence) {
+    return nullptr;
+  }
+  return FFTPlan<T>::get(samples, dir);
+}
+
 template <typename T>
 void ArduinoFFT<T>::findMaxY(T *vData, uint_fast16_t length, T *maxY,
                              uint_fast16_t *index) const {
   *maxY = 0;
   *index = 0;
-  // If sampling_frequency = 2 * max_frequency in signal,
-  // value would be stored at position samples/2
-  for (uint_fast16_t i = 1; i < length; i++) {
+  // A local maximum needs a neighbour on each side, so the last of the length
+  // values (the Nyquist bin for length = samples / 2 + 1) is not a candidate
+  for (uint_fast16_t i = 1; (i + 1) < length; i++) {
     if ((vData[i - 1] < vData[i]) && (vData[i] > vData[i + 1])) {
       if (vData[i] > vData[*index]) {
         *index = i;
@@ -436,6 +1462,42 @@ void ArduinoFFT<T>::findMaxY(T *vData, uint_fast16_t length, T *maxY,
   *maxY = vData[*index];
 }
 
+template <typename T>
+void ArduinoFFT<T>::findMaxY(FFTComplex<T> *vData, uint_fast16_t length,
+                             T *maxY, uint_fast16_t *index) const {
+  *maxY = 0;
+  *index = 0;
+  for (uint_fast16_t i = 1; (i + 1) < length; i++) {
+    if ((vData[i - 1].re < vData[i].re) && (vData[i].re > vData[i + 1].re)) {
+      if (vData[i].re > vData[*index].re) {
+        *index = i;
+      }
+    }
+  }
+  *maxY = vData[*index].re;
+}
+
+// Interpolates the peak at index from its magnitude y2 and the magnitudes of
+// its neighbours y1 and y3
+template <typename T>
+void ArduinoFFT<T>::interpolatePeak(T y1, T y2, T y3, uint_fast16_t index,
+                                    uint_fast16_t samples, T samplingFrequency,
+                                    T *frequency, T *magnitude) const {
+  T delta = 0.5 * ((y1 - y3) / (y1 - (2.0 * y2) + y3));
+  T interpolatedX = ((index + delta) * samplingFrequency) / (samples - 1);
+  if (index == (samples >> 1)) // To improve calculation on edge values
+    interpolatedX = ((index + delta) * samplingFrequency) / (samples);
+  // returned value: interpolated frequency peak apex
+  *frequency = interpolatedX;
+  if (magnitude != nullptr) {
+#if defined(ESP8266) || defined(ESP32)
+    *magnitude = fabs(y1 - (2.0 * y2) + y3);
+#else
+    *magnitude = abs(y1 - (2.0 * y2) + y3);
+#endif
+  }
+}
+
 template <typename T>
 void ArduinoFFT<T>::parabola(T x1, T y1, T x2, T y2, T x3, T y3, T *a, T *b,
                              T *c) const {
@@ -50,8 +50,26 @@
 #define sqrt_internal sqrt
 #endif
 
+enum class FFTAlgorithm {
+  Radix2,     // powers of two: bit reversal and radix-2 or radix-4 stages
+  MixedRadix, // no prime factor above 5: digit reversal, radix 2 to 5 stages
+  Bluestein   // any other size: chirp convolution by power of two transforms
+};
+
 enum class FFTDirection { Forward, Reverse };
 
+enum class FFTKernel {
+  Recurrence, // radix-2, twiddles computed by recurrence on every call
+  Radix2,     // radix-2, twiddles and bit reversal taken from a cached plan
+  Radix4      // radix-4 with a radix-2 stage for odd powers, cached plan
+};
+
+enum class FFTScale {
+  Power,     // squared magnitude, no square root
+  Magnitude, // linear magnitude
+  Decibel    // 10 * log10 of the power, from a fast log2 approximation
+};
+
 enum class FFTWindow {
   Rectangle,        // rectangle (Box car)
   Hamming,          // hamming
@@ -91,6 +109,116 @@ enum class FFTWindow {
 #define fourPi 12.56637061
 #define sixPi 18.84955593
 
+/* Largest prime factor handled by the mixed radix stages */
+#define FFT_MAX_RADIX 5
+
+/* Number of plans kept by FFTPlan<T>::get() per data type. Further sizes
+   replace the least recently used plan. */
+#ifndef FFT_PLAN_CACHE_SIZE
+#define FFT_PLAN_CACHE_SIZE 4
+#endif
+
+/* Threads sharing the frames of computeBatch(), above 1 only where
+   std::thread is available (ESP32, hosts) */
+#ifndef FFT_BATCH_THREADS
+#define FFT_BATCH_THREADS 1
+#endif
+
+// Memory for the tables and work buffers of the library (windowing factors,
+// plans and the plan objects themselves, ChirpZ and its cache entries,
+// ConstantQ, computeBatch() and FixedFFT). It comes from
+// malloc() unless fftSetAllocator() routes it elsewhere, e.g. to a
+// MemoryArena; the release function then also gets the blocks allocated
+// before, so set it first thing or have it pass foreign blocks to free().
+typedef void *(*FFTAllocateFunction)(size_t bytes, const char *name);
+typedef void (*FFTReleaseFunction)(void *pointer);
+
+void *fftAllocateBytes(size_t bytes, const char *name);
+void fftRelease(void *pointer);
+void fftSetAllocator(FFTAllocateFunction allocate, FFTReleaseFunction release);
+
+template <typename U> inline U *fftAllocate(size_t count, const char *name) {
+  return static_cast<U *>(fftAllocateBytes(count * sizeof(U), name));
+}
+
+// Twiddle factors and input permutation for one transform size and
+// direction. Plans are built on first use and shared by all ArduinoFFT
+// instances. Create them before transforms run concurrently, and keep the
+// sizes in use within FFT_PLAN_CACHE_SIZE then, as a new size frees the least
+// recently used plan. The algorithm follows from the size: powers of two keep
+// the radix-2 tables, sizes with no prime factor above FFT_MAX_RADIX are
+// factored into mixed radix stages, and all others are computed by
+// Bluestein's algorithm. A Bluestein plan owns a work buffer, so only one
+// transform of its size may run at a time. Sizes above 32768 get no Bluestein
+// plan, as their power of two work size would exceed the 65536 points the 16
+// bit permutation tables index.
+template <typename T> class FFTPlan {
+public:
+  static const FFTPlan<T> *get(uint_fast16_t samples, FFTDirection dir);
+  static void clear(void);
+
+  FFTAlgorithm algorithm(void) const { return _algorithm; }
+  const uint16_t *bitReverse(void) const { return _bitReverse; }
+  const T *cosTable(void) const { return _cos; }
+  uint_fast16_t cycles(void) const { return _cycleCount; }
+  const uint16_t *cycleStarts(void) const { return _cycles; }
+  FFTDirection direction(void) const { return _dir; }
+  const T *filterImag(void) const { return _filterImag; }
+  const T *filterReal(void) const { return _filterReal; }
+  const FFTPlan<T> *inner(void) const { return _inner; }
+  uint_fast8_t power(void) const { return _power; }
+  uint_fast8_t radix(uint_fast8_t stage) const { return _radices[stage]; }
+  uint_fast16_t samples(void) const { return _samples; }
+  const T *sinTable(void) const { return _sin; }
+  uint_fast8_t stages(void) const { return _stages; }
+  T *workImag(void) const { return _workImag; }
+  T *workReal(void) const { return _workReal; }
+
+private:
+  FFTPlan(uint_fast16_t samples, FFTDirection dir);
+  ~FFTPlan();
+
+  static FFTPlan<T> *_cache[FFT_PLAN_CACHE_SIZE];
+  static uint32_t _uses;
+
+  FFTAlgorithm _algorithm;
+  uint16_t *_bitReverse = nullptr; // Input index of each position, or its
+                                   // bit reversal for Radix2 plans
+  T *_cos = nullptr; // cos(2 * pi * k / samples), k < samples / 2 for Radix2
+                     // and k < samples for MixedRadix plans; the real part
+                     // of the chirp for Bluestein plans
+  uint_fast16_t _cycleCount = 0;
+  uint16_t *_cycles = nullptr; // First position of each permutation cycle
+  FFTDirection _dir;
+  T *_filterImag = nullptr; // Transformed chirp filter, scaled by 1 / size
+  T *_filterReal = nullptr;
+  FFTPlan<T> *_inner = nullptr; // Power of two forward plan of Bluestein
+  uint_fast8_t _power;
+  uint8_t _radices[16];
+  uint_fast16_t _samples;
+  T *_sin = nullptr; // -sin(2 * pi * k / samples) for forward, +sin for
+                     // reverse plans, as _cos
+  uint_fast8_t _stages = 0;
+  uint32_t _used = 0; // Age for least recently used replacement
+  T *_workImag = nullptr;
+  T *_workReal = nullptr;
+  /* Functions */
+  static FFTPlan<T> *build(uint_fast16_t samples, FFTDirection dir);
+  static void destroy(FFTPlan<T> *plan);
+  void buildBluestein(void);
+  void buildMixedRadix(void);
+  void buildRadix2(void);
+  bool valid(void) const;
+};
+
+// One complex value, real part first. In an array of FFTComplex both parts of
+// a sample share a cache line or PSRAM burst, while the split vReal / vImag
+// layout touches two distant locations per access.
+template <typename T> struct FFTComplex {
+  T re;
+  T im;
+};
+
 template <typename T> class ArduinoFFT {
 public:
   ArduinoFFT();
@@ -99,23 +227,48 @@ public:
 
   ~ArduinoFFT();
 
+  void autocorrelate(T *vData, uint_fast16_t samples) const;
+
   void complexToMagnitude(void) const;
   void complexToMagnitude(T *vReal, T *vImag, uint_fast16_t samples) const;
+  void complexToMagnitude(FFTComplex<T> *vData, uint_fast16_t samples) const;
+
+  void complexToSpectrum(T *vReal, T *vImag, uint_fast16_t samples,
+                         FFTScale scale, T gain = 1.0) const;
 
-  void compute(FFTDirection dir) const;
-  void compute(T *vReal, T *vImag, uint_fast16_t samples,
+  static T coherentScale(FFTWindow windowType, uint_fast16_t samples);
+
+  bool compute(FFTDirection dir) const;
+  bool compute(T *vReal, T *vImag, uint_fast16_t samples,
+               FFTDirection dir) const;
+  bool compute(T *vReal, T *vImag, uint_fast16_t samples, uint_fast8_t power,
                FFTDirection dir) const;
-  void compute(T *vReal, T *vImag, uint_fast16_t samples, uint_fast8_t power,
+  bool compute(FFTComplex<T> *vData, uint_fast16_t samples,
                FFTDirection dir) const;
 
+  bool computeBatch(const T *vData, uint_fast16_t samples, uint_fast16_t hop,
+                    uint_fast16_t count, T *vOut, FFTWindow windowType,
+                    FFTScale scale, T gain = 1.0) const;
+
+  void computeReal(bool prepared = false) const;
+  void computeReal(T *vData, uint_fast16_t samples,
+                   bool prepared = false) const;
+  void computeRealInverse(T *vData, uint_fast16_t samples) const;
+
   void dcRemoval(void) const;
   void dcRemoval(T *vData, uint_fast16_t samples) const;
 
+  static T fastLog2(T x);
+
   T majorPeak(void) const;
   void majorPeak(T *f, T *v) const;
   T majorPeak(T *vData, uint_fast16_t samples, T samplingFrequency) const;
   void majorPeak(T *vData, uint_fast16_t samples, T samplingFrequency,
                  T *frequency, T *magnitude) const;
+  T majorPeak(FFTComplex<T> *vData, uint_fast16_t samples,
+              T samplingFrequency) const;
+  void majorPeak(FFTComplex<T> *vData, uint_fast16_t samples,
+                 T samplingFrequency, T *frequency, T *magnitude) const;
 
   T majorPeakParabola(void) const;
   void majorPeakParabola(T *frequency, T *magnitude) const;
@@ -124,10 +277,28 @@ public:
   void majorPeakParabola(T *vData, uint_fast16_t samples, T samplingFrequency,
                          T *frequency, T *magnitude) const;
 
+  void realToMagnitude(void) const;
+  void realToMagnitude(T *vData, uint_fast16_t samples) const;
+
+  void prepare(FFTWindow windowType, T mean);
+  void prepare(T *vData, uint_fast16_t samples, FFTWindow windowType, T mean,
+               T *windowingFactors = nullptr) const;
+
+  static void powerToSpectrum(const T *vPower, T *vData, uint_fast16_t bins,
+                              FFTScale scale, T gain = 1.0);
+
+  void realToSpectrum(T *vData, uint_fast16_t samples, FFTScale scale,
+                      T gain = 1.0) const;
+
   uint8_t revision(void);
 
   void setArrays(T *vReal, T *vImag, uint_fast16_t samples = 0);
 
+  void setKernel(FFTKernel kernel);
+
+  static T weighingFactor(FFTWindow windowType, uint_fast16_t i,
+                          uint_fast16_t samples);
+
   void windowing(FFTWindow windowType, FFTDirection dir,
                  bool withCompensation = false);
   void windowing(T *vData, uint_fast16_t samples, FFTWindow windowType,
@@ -141,18 +312,52 @@ private:
   T _oneOverSamples = 0.0;
 #endif
   bool _isPrecompiled = false;
+  FFTKernel _kernel = FFTKernel::Radix2;
   bool _precompiledWithCompensation = false;
   uint_fast8_t _power = 0;
-  T *_precompiledWindowingFactors;
+  T *_precompiledWindowingFactors = nullptr;
   uint_fast16_t _samples;
   T _samplingFrequency;
   T *_vImag;
   T *_vReal;
   FFTWindow _windowFunction;
   /* Functions */
+  friend class FFTPlan<T>; // Transforms the Bluestein filter
+  void batchFrames(const T *vData, uint_fast16_t samples, uint_fast16_t hop,
+                   uint_fast16_t count, T *vOut, FFTScale scale, T gain,
+                   const T *windowingFactors, const FFTPlan<T> *plan,
+                   T *work, uint_fast16_t first) const;
+  void bitReverse(T *vReal, T *vImag, uint_fast16_t samples,
+                  const FFTPlan<T> *plan) const;
+  void bitReverse(FFTComplex<T> *vData, uint_fast16_t samples,
+                  const FFTPlan<T> *plan) const;
+  void butterflies(T *vReal, T *vImag, uint_fast16_t samples,
+                   uint_fast8_t power, FFTDirection dir,
+                   const FFTPlan<T> *plan) const;
+  void butterflies(FFTComplex<T> *vData, uint_fast16_t samples,
+                   uint_fast8_t power, FFTDirection dir,
+                   const FFTPlan<T> *plan) const;
+  void butterfliesMixed(T *vReal, T *vImag, uint_fast8_t stride,
+                        uint_fast16_t samples, const FFTPlan<T> *plan) const;
+  void butterfliesRadix4(T *vReal, T *vImag, uint_fast16_t samples,
+                         uint_fast8_t power, const FFTPlan<T> *plan) const;
+  void bluestein(T *vReal, T *vImag, uint_fast8_t stride,
+                 uint_fast16_t samples, const FFTPlan<T> *plan) const;
+  bool computeGeneral(T *vReal, T *vImag, uint_fast8_t stride,
+                      uint_fast16_t samples, FFTDirection dir) const;
+  void computeRealPrepared(T *vData, uint_fast16_t samples,
+                           const FFTPlan<T> *plan) const;
+  void permute(T *vReal, T *vImag, uint_fast8_t stride,
+               const FFTPlan<T> *plan) const;
+  const FFTPlan<T> *plan(uint_fast16_t samples, FFTDirection dir) const;
   uint_fast8_t exponent(uint_fast16_t value) const;
   void findMaxY(T *vData, uint_fast16_t length, T *maxY,
                 uint_fast16_t *index) const;
+  void findMaxY(FFTComplex<T> *vData, uint_fast16_t length, T *maxY,
+                uint_fast16_t *index) const;
+  void interpolatePeak(T y1, T y2, T y3, uint_fast16_t index,
+                       uint_fast16_t samples, T samplingFrequency,
+                       T *frequency, T *magnitude) const;
   void parabola(T x1, T y1, T x2, T y2, T x3, T y3, T *a, T *b, T *c) const;
   void swap(T *a, T *b) const;
 
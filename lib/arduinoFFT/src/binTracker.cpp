@@ -0,0 +1,117 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "binTracker.h"
+
+template <typename T>
+BinTracker<T>::BinTracker(T *history, uint_fast16_t samples,
+                          T samplingFrequency, T damping)
+    : _damping(damping), _history(history), _samples(samples),
+      _samplingFrequency(samplingFrequency) {
+  reset();
+}
+
+// Starts tracking the DFT bin closest to frequency. Returns the tracker index
+// of the bin, or -1 if all BIN_TRACKER_MAX_BINS are in use. A new bin settles
+// after samples updates.
+template <typename T> int_fast8_t BinTracker<T>::addBin(T frequency) {
+  if (_bins >= BIN_TRACKER_MAX_BINS) {
+    return -1;
+  }
+  _frequency[_bins] = frequency;
+  tune(_bins);
+  _stateReal[_bins] = 0.0;
+  _stateImag[_bins] = 0.0;
+  return _bins++;
+}
+
+// Stops tracking all bins
+template <typename T> void BinTracker<T>::clear(void) { _bins = 0; }
+
+// Centre frequency of the tracked DFT bin
+template <typename T> T BinTracker<T>::frequency(uint_fast8_t bin) const {
+  return (_index[bin] * _samplingFrequency) / _samples;
+}
+
+template <typename T> T BinTracker<T>::magnitude(uint_fast8_t bin) const {
+  return sqrt(sq(_stateReal[bin]) + sq(_stateImag[bin]));
+}
+
+// Clears the history and all bin states
+template <typename T> void BinTracker<T>::reset(void) {
+  for (uint_fast16_t i = 0; i < _samples; i++) {
+    _history[i] = 0.0;
+  }
+  _position = 0;
+  for (uint_fast8_t bin = 0; bin < _bins; bin++) {
+    _stateReal[bin] = 0.0;
+    _stateImag[bin] = 0.0;
+  }
+}
+
+// Moves every bin to the DFT bin closest to its frequency at the new rate.
+// The history no longer matches the rate, so it is cleared.
+template <typename T>
+void BinTracker<T>::setSamplingFrequency(T samplingFrequency) {
+  _samplingFrequency = samplingFrequency;
+  for (uint_fast8_t bin = 0; bin < _bins; bin++) {
+    tune(bin);
+  }
+  reset();
+}
+
+// Slides the window by one sample:
+// X = damping * W * (X + sample - damping^samples * oldest sample)
+template <typename T> void BinTracker<T>::update(T sample) {
+  T oldest = _history[_position];
+  _history[_position] = sample;
+  if (++_position == _samples) {
+    _position = 0;
+  }
+  for (uint_fast8_t bin = 0; bin < _bins; bin++) {
+    T re = _stateReal[bin] + sample - _dampingN[bin] * oldest;
+    T im = _stateImag[bin];
+    _stateReal[bin] = _twiddleReal[bin] * re - _twiddleImag[bin] * im;
+    _stateImag[bin] = _twiddleReal[bin] * im + _twiddleImag[bin] * re;
+  }
+}
+
+// Private functions
+
+template <typename T> void BinTracker<T>::tune(uint_fast8_t bin) {
+  uint_fast16_t index =
+      uint_fast16_t((_frequency[bin] * _samples) / _samplingFrequency + 0.5);
+  if (index > (_samples >> 1)) {
+    index = _samples >> 1;
+  }
+  _index[bin] = index;
+  double angle = 6.28318530717958647692 * index / _samples;
+  _twiddleReal[bin] = _damping * cos(angle);
+  _twiddleImag[bin] = _damping * sin(angle);
+  // The comb has to cancel the pole of the rounded twiddle factor exactly,
+  // otherwise the rounding error of its radius grows with every sample
+  double radius = sqrt(sq(double(_twiddleReal[bin])) +
+                       sq(double(_twiddleImag[bin])));
+  _dampingN[bin] = pow(radius, double(_samples));
+}
+
+template class BinTracker<double>;
+template class BinTracker<float>;
@@ -0,0 +1,75 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef BinTracker_h /* Prevent loading library twice */
+#define BinTracker_h
+
+#include "arduinoFFT.h"
+
+/* Number of frequencies a BinTracker can follow */
+#ifndef BIN_TRACKER_MAX_BINS
+#define BIN_TRACKER_MAX_BINS 8
+#endif
+
+// Bank of sliding DFT resonators that follows a few bins of a samples point
+// DFT with O(1) work per bin and sample. After every update() each tracked
+// bin holds the DFT of the last samples values, the same magnitude a
+// rectangular-window compute() would give, without waiting for a block. The
+// poles are pulled inside the unit circle by the damping factor so rounding
+// errors decay instead of accumulating; the magnitudes are scaled down by
+// roughly damping^(samples / 2). The history array keeps the last samples
+// values.
+template <typename T> class BinTracker {
+public:
+  BinTracker(T *history, uint_fast16_t samples, T samplingFrequency,
+             T damping = 0.999999);
+
+  int_fast8_t addBin(T frequency);
+  uint_fast8_t bins(void) const { return _bins; }
+  void clear(void);
+  T frequency(uint_fast8_t bin) const;
+  T magnitude(uint_fast8_t bin) const;
+  void reset(void);
+  T samplingFrequency(void) const { return _samplingFrequency; }
+  void setSamplingFrequency(T samplingFrequency);
+  void update(T sample);
+
+private:
+  /* Variables */
+  uint_fast8_t _bins = 0;
+  T _damping;
+  T _dampingN[BIN_TRACKER_MAX_BINS]; // Weight of the sample leaving the window
+  T _frequency[BIN_TRACKER_MAX_BINS]; // Requested frequencies
+  T *_history;
+  uint_fast16_t _index[BIN_TRACKER_MAX_BINS]; // DFT bin numbers
+  uint_fast16_t _position = 0;
+  uint_fast16_t _samples;
+  T _samplingFrequency;
+  T _stateImag[BIN_TRACKER_MAX_BINS];
+  T _stateReal[BIN_TRACKER_MAX_BINS];
+  T _twiddleImag[BIN_TRACKER_MAX_BINS]; // damping * sin(2 * pi * bin / samples)
+  T _twiddleReal[BIN_TRACKER_MAX_BINS]; // damping * cos(2 * pi * bin / samples)
+  /* Functions */
+  void tune(uint_fast8_t bin);
+};
+
+#endif
@@ -0,0 +1,224 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "chirpZ.h"
+
+// Without memory for the cacheSize entries, configure() always fails
+template <typename T>
+ChirpZ<T>::ChirpZ(uint_fast8_t cacheSize)
+    : _cacheSize(cacheSize ? cacheSize : 1) {
+  _entries = fftAllocate<Entry>(_cacheSize, "Chirp-Z");
+  if (_entries == nullptr) {
+    _cacheSize = 0;
+  }
+  for (uint_fast8_t i = 0; i < _cacheSize; i++) {
+    _entries[i].filter = nullptr;
+    _entries[i].post = nullptr;
+    _entries[i].pre = nullptr;
+    _entries[i].samples = 0;
+    _entries[i].used = 0;
+  }
+}
+
+template <typename T> ChirpZ<T>::~ChirpZ() {
+  for (uint_fast8_t i = 0; i < _cacheSize; i++) {
+    release(&_entries[i]);
+  }
+  fftRelease(_entries);
+}
+
+// Transforms the first samples() values of vReal and vImag in place. Both
+// arrays must hold workSize() values; on return the first points() of them
+// are the spectrum at frequency(0) to frequency(points() - 1), scaled like
+// compute() of ArduinoFFT. Window the input first if needed.
+template <typename T> void ChirpZ<T>::compute(T *vReal, T *vImag) const {
+  if (!_current) {
+    return;
+  }
+  const Entry *entry = _current;
+  uint_fast16_t size = entry->workSize;
+  for (uint_fast16_t n = 0; n < entry->samples; n++) {
+    T xr = vReal[n];
+    T xi = vImag[n];
+    vReal[n] = xr * entry->pre[n].re - xi * entry->pre[n].im;
+    vImag[n] = xr * entry->pre[n].im + xi * entry->pre[n].re;
+  }
+  for (uint_fast16_t n = entry->samples; n < size; n++) {
+    vReal[n] = 0.0;
+    vImag[n] = 0.0;
+  }
+  ArduinoFFT<T> fft;
+  fft.compute(vReal, vImag, size, FFTDirection::Forward);
+  // Convolution with the chirp; the inverse transform runs as a forward one
+  // on the conjugate
+  for (uint_fast16_t k = 0; k < size; k++) {
+    T yr = vReal[k];
+    T yi = vImag[k];
+    vReal[k] = yr * entry->filter[k].re - yi * entry->filter[k].im;
+    vImag[k] = -(yr * entry->filter[k].im + yi * entry->filter[k].re);
+  }
+  fft.compute(vReal, vImag, size, FFTDirection::Forward);
+  for (uint_fast16_t k = 0; k < entry->points; k++) {
+    T gr = vReal[k];
+    T gi = -vImag[k];
+    vReal[k] = gr * entry->post[k].re - gi * entry->post[k].im;
+    vImag[k] = gr * entry->post[k].im + gi * entry->post[k].re;
+  }
+}
+
+// Selects the band to transform, building its tables unless they are cached.
+// Needs at least two points and samples + points - 1 <= 32768. Returns false,
+// with no band selected, if the arguments don't fit or memory runs out.
+template <typename T>
+bool ChirpZ<T>::configure(uint_fast16_t samples, uint_fast16_t points,
+                          T startFrequency, T endFrequency,
+                          T samplingFrequency) {
+  _current = nullptr;
+  if (_cacheSize == 0 || samples == 0 || points < 2 ||
+      uint32_t(samples) + points - 1 > 32768) {
+    return false;
+  }
+  _uses++;
+  Entry *oldest = &_entries[0];
+  for (uint_fast8_t i = 0; i < _cacheSize; i++) {
+    Entry *entry = &_entries[i];
+    if (entry->samples == samples && entry->points == points &&
+        entry->startFrequency == startFrequency &&
+        entry->endFrequency == endFrequency &&
+        entry->samplingFrequency == samplingFrequency) {
+      entry->used = _uses;
+      _current = entry;
+      return true;
+    }
+    if (entry->used < oldest->used) {
+      oldest = entry;
+    }
+  }
+  release(oldest);
+  oldest->samples = samples;
+  oldest->points = points;
+  oldest->startFrequency = startFrequency;
+  oldest->endFrequency = endFrequency;
+  oldest->samplingFrequency = samplingFrequency;
+  if (!build(oldest)) {
+    release(oldest);
+    return false;
+  }
+  oldest->used = _uses;
+  _current = oldest;
+  return true;
+}
+
+// Frequency of an output point of the selected band
+template <typename T> T ChirpZ<T>::frequency(uint_fast16_t point) const {
+  if (!_current) {
+    return 0.0;
+  }
+  return _current->startFrequency +
+         (_current->endFrequency - _current->startFrequency) * point /
+             (_current->points - 1);
+}
+
+template <typename T> uint_fast16_t ChirpZ<T>::points(void) const {
+  return _current ? _current->points : 0;
+}
+
+template <typename T> uint_fast16_t ChirpZ<T>::samples(void) const {
+  return _current ? _current->samples : 0;
+}
+
+// Length of the arrays passed to compute()
+template <typename T> uint_fast16_t ChirpZ<T>::workSize(void) const {
+  return _current ? _current->workSize : 0;
+}
+
+// Private functions
+
+// With the frequency step phi = 2 * pi * (end - start) / ((points - 1) *
+// samplingFrequency), X[k] = c[k] * sum(x[n] * shift[n] * c[n] *
+// conj(c[k - n])) for the chirp c[m] = exp(-i * phi * m^2 / 2). Phases are
+// evaluated in double, as m^2 gets large.
+template <typename T> bool ChirpZ<T>::build(Entry *entry) {
+  uint_fast16_t size = 1;
+  while (size < entry->samples + entry->points - 1) {
+    size <<= 1;
+  }
+  entry->workSize = size;
+  entry->pre = fftAllocate<FFTComplex<T>>(entry->samples, "Chirp-Z");
+  entry->post = fftAllocate<FFTComplex<T>>(entry->points, "Chirp-Z");
+  entry->filter = fftAllocate<FFTComplex<T>>(size, "Chirp-Z");
+  if (!entry->pre || !entry->post || !entry->filter) {
+    return false;
+  }
+  double start = 2.0 * PI * entry->startFrequency / entry->samplingFrequency;
+  double step = 2.0 * PI * (entry->endFrequency - entry->startFrequency) /
+                ((entry->points - 1) * double(entry->samplingFrequency));
+  for (uint_fast16_t n = 0; n < entry->samples; n++) {
+    double phase = fmod(start * n + 0.5 * step * (double(n) * n), 2.0 * PI);
+    entry->pre[n].re = cos(phase);
+    entry->pre[n].im = -sin(phase);
+  }
+  for (uint_fast16_t k = 0; k < entry->points; k++) {
+    double phase = fmod(0.5 * step * (double(k) * k), 2.0 * PI);
+    entry->post[k].re = cos(phase);
+    entry->post[k].im = -sin(phase);
+  }
+  // conj(c[m]) for lags 0 to points - 1 and, wrapped around, -1 to
+  // -(samples - 1), transformed in place
+  FFTComplex<T> *filter = entry->filter;
+  for (uint_fast16_t m = 0; m < size; m++) {
+    filter[m].re = 0.0;
+    filter[m].im = 0.0;
+  }
+  T scale = 1.0 / size;
+  uint_fast16_t lags =
+      (entry->points > entry->samples) ? entry->points : entry->samples;
+  for (uint_fast16_t m = 0; m < lags; m++) {
+    double phase = fmod(0.5 * step * (double(m) * m), 2.0 * PI);
+    T re = cos(phase) * scale;
+    T im = sin(phase) * scale;
+    if (m < entry->points) {
+      filter[m].re = re;
+      filter[m].im = im;
+    }
+    if (m > 0 && m < entry->samples) {
+      filter[size - m].re = re;
+      filter[size - m].im = im;
+    }
+  }
+  ArduinoFFT<T> fft;
+  fft.compute(filter, size, FFTDirection::Forward);
+  return true;
+}
+
+template <typename T> void ChirpZ<T>::release(Entry *entry) {
+  fftRelease(entry->filter);
+  fftRelease(entry->post);
+  fftRelease(entry->pre);
+  entry->filter = nullptr;
+  entry->post = nullptr;
+  entry->pre = nullptr;
+  entry->samples = 0;
+  entry->used = 0;
+}
+
+template class ChirpZ<double>;
+template class ChirpZ<float>;
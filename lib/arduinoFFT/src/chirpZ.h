@@ -0,0 +1,75 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef ChirpZ_h /* Prevent loading library twice */
+#define ChirpZ_h
+
+#include "arduinoFFT.h"
+
+// Chirp-Z transform: the DFT of samples values at points frequencies spaced
+// evenly from startFrequency to endFrequency, any band at any resolution. By
+// Bluestein's identity it is a convolution with a chirp, computed with two
+// power of two transforms of workSize() >= samples + points - 1 points, so
+// it costs O((N + M) log(N + M)) instead of O(N * M) for the direct sums. The
+// chirps and the transformed filter of the last few configurations are kept
+// (cacheSize of them, each of samples + points + workSize() complex values),
+// so going back to a recent band only switches tables.
+template <typename T> class ChirpZ {
+public:
+  ChirpZ(uint_fast8_t cacheSize = 2);
+  ChirpZ(const ChirpZ &) = delete;
+  ChirpZ &operator=(const ChirpZ &) = delete;
+  ~ChirpZ();
+
+  void compute(T *vReal, T *vImag) const;
+  bool configure(uint_fast16_t samples, uint_fast16_t points,
+                 T startFrequency, T endFrequency, T samplingFrequency);
+  T frequency(uint_fast16_t point) const;
+  uint_fast16_t points(void) const;
+  uint_fast16_t samples(void) const;
+  uint_fast16_t workSize(void) const;
+
+private:
+  // Tables of one configuration
+  struct Entry {
+    T endFrequency;
+    FFTComplex<T> *filter; // Transformed chirp, scaled by 1 / workSize
+    FFTComplex<T> *post;   // Output chirp, points values
+    FFTComplex<T> *pre;    // Input chirp and band shift, samples values
+    uint_fast16_t points;
+    uint_fast16_t samples;
+    T samplingFrequency;
+    T startFrequency;
+    uint32_t used; // Age for least recently used replacement
+    uint_fast16_t workSize;
+  };
+  /* Variables */
+  uint_fast8_t _cacheSize;
+  Entry *_current = nullptr;
+  Entry *_entries;
+  uint32_t _uses = 0;
+  /* Functions */
+  bool build(Entry *entry);
+  static void release(Entry *entry);
+};
+
+#endif
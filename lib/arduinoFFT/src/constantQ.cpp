@@ -0,0 +1,169 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "constantQ.h"
+
+template <typename T> ConstantQ<T>::~ConstantQ() { release(); }
+
+// Builds the sparse kernels of all bands from minFrequency up to at most
+// maxFrequency for frames of samples points (a power of two). Needs two
+// temporary arrays of samples values. Returns false, with no bands, if
+// memory runs out.
+template <typename T>
+bool ConstantQ<T>::configure(uint_fast16_t samples, T samplingFrequency,
+                             T minFrequency, T maxFrequency,
+                             uint_fast8_t bandsPerOctave, T threshold) {
+  release();
+  _samples = samples;
+  _minFrequency = minFrequency;
+  _bandsPerOctave = bandsPerOctave;
+  _q = 1.0 / (pow(2.0, 1.0 / bandsPerOctave) - 1.0);
+  T nyquist = samplingFrequency / 2;
+  if (maxFrequency > nyquist) {
+    maxFrequency = nyquist;
+  }
+  uint_fast16_t bands =
+      floor(bandsPerOctave * log2(maxFrequency / minFrequency)) + 1;
+  T *vReal = fftAllocate<T>(samples, "Constant-Q work");
+  T *vImag = fftAllocate<T>(samples, "Constant-Q work");
+  _rows = fftAllocate<uint32_t>(bands + 1, "Constant-Q");
+  if (!vReal || !vImag || !_rows) {
+    fftRelease(vReal);
+    fftRelease(vImag);
+    release();
+    return false;
+  }
+  // First pass counts the bins kept per band, the second stores them
+  uint_fast16_t half = samples >> 1;
+  _rows[0] = 0;
+  for (uint_fast8_t pass = 0; pass < 2; pass++) {
+    for (uint_fast16_t band = 0; band < bands; band++) {
+      spectralKernel(band, samplingFrequency, vReal, vImag);
+      T peak = 0;
+      for (uint_fast16_t k = 1; k < half; k++) {
+        T power = sq(vReal[k]) + sq(vImag[k]);
+        if (power > peak) {
+          peak = power;
+        }
+      }
+      T floor = sq(threshold) * peak;
+      uint32_t index = _rows[band];
+      for (uint_fast16_t k = 1; k < half; k++) {
+        if (sq(vReal[k]) + sq(vImag[k]) >= floor) {
+          if (pass == 1) {
+            _columns[index] = k;
+            _kernel[index].re = vReal[k] / samples;
+            _kernel[index].im = -vImag[k] / samples;
+          }
+          index++;
+        }
+      }
+      _rows[band + 1] = index;
+    }
+    if (pass == 0) {
+      _columns = fftAllocate<uint16_t>(_rows[bands], "Constant-Q");
+      _kernel = fftAllocate<FFTComplex<T>>(_rows[bands], "Constant-Q");
+      if (!_columns || !_kernel) {
+        break;
+      }
+    }
+  }
+  fftRelease(vReal);
+  fftRelease(vImag);
+  if (!_columns || !_kernel) {
+    release();
+    return false;
+  }
+  _bands = bands;
+  return true;
+}
+
+// Centre frequency of a band. Fractional bands, such as interpolated peak
+// positions, fall in between on the logarithmic scale.
+template <typename T> T ConstantQ<T>::frequency(T band) const {
+  return _minFrequency * pow(2.0, band / _bandsPerOctave);
+}
+
+// Computes the complex constant-Q value of every band from vData as left by
+// computeReal() (the real and imaginary parts of bin k at k and samples / 2
+// + k). The frame should not be windowed, the kernels carry their own
+// window. A sinusoid of amplitude A centred on a band reads A there.
+template <typename T>
+void ConstantQ<T>::transform(const T *vData, T *vReal, T *vImag) const {
+  const T *vDataImag = vData + (_samples >> 1);
+  for (uint_fast16_t band = 0; band < _bands; band++) {
+    T re = 0;
+    T im = 0;
+    for (uint32_t i = _rows[band]; i < _rows[band + 1]; i++) {
+      uint_fast16_t k = _columns[i];
+      re += vData[k] * _kernel[i].re - vDataImag[k] * _kernel[i].im;
+      im += vData[k] * _kernel[i].im + vDataImag[k] * _kernel[i].re;
+    }
+    vReal[band] = re;
+    vImag[band] = im;
+  }
+}
+
+// Private functions
+
+template <typename T> void ConstantQ<T>::release(void) {
+  fftRelease(_columns);
+  fftRelease(_kernel);
+  fftRelease(_rows);
+  _columns = nullptr;
+  _kernel = nullptr;
+  _rows = nullptr;
+  _bands = 0;
+}
+
+// Transform of the time kernel of a band: a Hann window of Q periods (at most
+// the frame), centred in the frame, times the complex exponential of the
+// band frequency, scaled by 2 / (sum of the window) so a sinusoid reads its
+// amplitude
+template <typename T>
+void ConstantQ<T>::spectralKernel(uint_fast16_t band, T samplingFrequency,
+                                  T *vReal, T *vImag) const {
+  T bandFrequency = frequency(band);
+  uint_fast16_t length = ceil(_q * samplingFrequency / bandFrequency);
+  if (length > _samples) {
+    length = _samples;
+  }
+  uint_fast16_t start = (_samples - length) >> 1;
+  for (uint_fast16_t i = 0; i < _samples; i++) {
+    vReal[i] = 0.0;
+    vImag[i] = 0.0;
+  }
+  T sum = 0;
+  for (uint_fast16_t n = 0; n < length; n++) {
+    sum += 0.5 - 0.5 * cos(twoPi * (n + 0.5) / length);
+  }
+  T omega = twoPi * bandFrequency / samplingFrequency;
+  for (uint_fast16_t n = 0; n < length; n++) {
+    T weight = (1.0 - cos(twoPi * (n + 0.5) / length)) / sum;
+    vReal[start + n] = weight * cos(omega * (start + n));
+    vImag[start + n] = weight * sin(omega * (start + n));
+  }
+  ArduinoFFT<T> fft;
+  fft.compute(vReal, vImag, _samples, FFTDirection::Forward);
+}
+
+template class ConstantQ<double>;
+template class ConstantQ<float>;
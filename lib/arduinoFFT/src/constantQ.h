@@ -0,0 +1,71 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef ConstantQ_h /* Prevent loading library twice */
+#define ConstantQ_h
+
+#include "arduinoFFT.h"
+
+// Constant-Q transform of a frame from its computeReal() half spectrum, by
+// the spectral kernel method of Brown and Puckette. Band k is centred on
+// minFrequency * 2^(k / bandsPerOctave) and correlates the frame with a Hann
+// windowed complex exponential of Q cycles, so every band has the same
+// relative bandwidth. The transform of each such kernel is concentrated in a
+// few bins: configure() computes them once, keeps the bins above threshold
+// times the peak of their band in compressed sparse row form, and each frame
+// then costs one sparse product. Kernels are capped at the frame length, so
+// bands below Q * samplingFrequency / samples Hz are only as narrow as the
+// frame allows. The DC and Nyquist bins are not used, so the top bands lose
+// the part of their kernel that would reach past the Nyquist frequency.
+template <typename T> class ConstantQ {
+public:
+  ConstantQ() = default;
+  ConstantQ(const ConstantQ &) = delete;
+  ConstantQ &operator=(const ConstantQ &) = delete;
+  ~ConstantQ();
+
+  uint_fast16_t bands(void) const { return _bands; }
+  bool configure(uint_fast16_t samples, T samplingFrequency, T minFrequency,
+                 T maxFrequency, uint_fast8_t bandsPerOctave,
+                 T threshold = 0.01);
+  T frequency(T band) const;
+  uint32_t nonZeros(void) const { return _bands ? _rows[_bands] : 0; }
+  T q(void) const { return _q; }
+  void transform(const T *vData, T *vReal, T *vImag) const;
+
+private:
+  /* Variables */
+  uint_fast16_t _bands = 0;
+  uint_fast8_t _bandsPerOctave = 1;
+  uint16_t *_columns = nullptr; // Bin of each stored kernel value
+  FFTComplex<T> *_kernel = nullptr; // Conjugated, scaled spectral kernels
+  T _minFrequency = 0;
+  T _q = 0;
+  uint32_t *_rows = nullptr; // First stored value of each band, bands + 1
+  uint_fast16_t _samples = 0;
+  /* Functions */
+  void release(void);
+  void spectralKernel(uint_fast16_t band, T samplingFrequency, T *vReal,
+                      T *vImag) const;
+};
+
+#endif
@@ -0,0 +1,94 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "convolver.h"
+
+template <typename T>
+Convolver<T>::Convolver(T *vResponse, T *vBuffer, T *vHistory,
+                        uint_fast16_t samples)
+    : _samples(samples), _vBuffer(vBuffer), _vHistory(vHistory),
+      _vResponse(vResponse) {
+  // Pass-through until a filter is set
+  for (uint_fast16_t i = 0; i < _samples; i++) {
+    _vResponse[i] = (i <= (_samples >> 1)) ? 1.0 : 0.0;
+  }
+  reset();
+}
+
+// Filters blockSize() values of input into blockSize() values of output,
+// continuing from the previous block. input and output may be the same array.
+template <typename T> void Convolver<T>::process(const T *input, T *output) {
+  uint_fast16_t overlap = _taps - 1;
+  uint_fast16_t block = blockSize();
+  uint_fast16_t half = _samples >> 1;
+  for (uint_fast16_t i = 0; i < overlap; i++) {
+    _vBuffer[i] = _vHistory[i];
+  }
+  for (uint_fast16_t i = 0; i < block; i++) {
+    _vBuffer[overlap + i] = input[i];
+  }
+  // The last taps - 1 inputs start the next block
+  for (uint_fast16_t i = 0; i < overlap; i++) {
+    _vHistory[i] = _vBuffer[block + i];
+  }
+  _fft.computeReal(_vBuffer, _samples);
+  // Multiply by the response; DC and Nyquist are real
+  _vBuffer[0] *= _vResponse[0];
+  _vBuffer[half] *= _vResponse[half];
+  for (uint_fast16_t k = 1; k < half; k++) {
+    T re = _vBuffer[k];
+    T im = _vBuffer[half + k];
+    _vBuffer[k] = re * _vResponse[k] - im * _vResponse[half + k];
+    _vBuffer[half + k] = re * _vResponse[half + k] + im * _vResponse[k];
+  }
+  _fft.computeRealInverse(_vBuffer, _samples);
+  // The first taps - 1 values wrapped around the circular convolution
+  for (uint_fast16_t i = 0; i < block; i++) {
+    output[i] = _vBuffer[overlap + i];
+  }
+}
+
+// Clears the input history, as if the filter had only seen zeros
+template <typename T> void Convolver<T>::reset(void) {
+  for (uint_fast16_t i = 0; i < (_samples >> 1); i++) {
+    _vHistory[i] = 0.0;
+  }
+}
+
+// Sets the impulse response and computes its frequency response. Returns
+// false, keeping the previous filter, if taps is 0 or more than samples / 2,
+// beyond which blocks would be shorter than the filter. Clears the history.
+template <typename T>
+bool Convolver<T>::setFilter(const T *coefficients, uint_fast16_t taps) {
+  if ((taps == 0) || (taps > (_samples >> 1))) {
+    return false;
+  }
+  _taps = taps;
+  for (uint_fast16_t i = 0; i < _samples; i++) {
+    _vResponse[i] = (i < taps) ? coefficients[i] : 0.0;
+  }
+  _fft.computeReal(_vResponse, _samples);
+  reset();
+  return true;
+}
+
+template class Convolver<double>;
+template class Convolver<float>;
@@ -0,0 +1,56 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef Convolver_h /* Prevent loading library twice */
+#define Convolver_h
+
+#include "arduinoFFT.h"
+
+// Overlap-save FIR filter for long impulse responses. Each block of
+// blockSize() = samples - taps + 1 input values costs one real forward and one
+// real inverse transform of samples points, with the frequency response of the
+// filter computed once by setFilter(). Direct convolution costs taps
+// multiply-adds per output value, so blocks pay off from a few dozen taps on.
+// All arrays belong to the caller: vResponse and vBuffer hold samples values,
+// vHistory samples / 2 values.
+template <typename T> class Convolver {
+public:
+  Convolver(T *vResponse, T *vBuffer, T *vHistory, uint_fast16_t samples);
+
+  uint_fast16_t blockSize(void) const { return _samples - _taps + 1; }
+  void process(const T *input, T *output);
+  void reset(void);
+  uint_fast16_t samples(void) const { return _samples; }
+  bool setFilter(const T *coefficients, uint_fast16_t taps);
+  uint_fast16_t taps(void) const { return _taps; }
+
+private:
+  /* Variables */
+  ArduinoFFT<T> _fft;
+  uint_fast16_t _samples;
+  uint_fast16_t _taps = 1;
+  T *_vBuffer;
+  T *_vHistory; // Last taps - 1 input values
+  T *_vResponse; // Frequency response in the packed computeReal() layout
+};
+
+#endif
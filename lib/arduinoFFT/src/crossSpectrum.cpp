@@ -0,0 +1,188 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "crossSpectrum.h"
+
+template <typename T>
+CrossSpectrum<T>::CrossSpectrum(T *vAccumulator, uint_fast16_t bins,
+                                FFTAveraging averaging, uint_fast16_t frames,
+                                T alpha)
+    : _bins(bins), _vAccumulator(vAccumulator) {
+  setAveraging(averaging, frames, alpha);
+}
+
+// Adds a frame of samples = 2 * (bins - 1) pairs, the reference in the real
+// and the response in the imaginary parts. Removes the mean of each channel,
+// windows and transforms the frame in place, so vData is overwritten.
+template <typename T>
+void CrossSpectrum<T>::add(FFTComplex<T> *vData, FFTWindow windowType) {
+  uint_fast16_t samples = (_bins - 1) << 1;
+  T meanReal = 0;
+  T meanImag = 0;
+  for (uint_fast16_t i = 0; i < samples; i++) {
+    meanReal += vData[i].re;
+    meanImag += vData[i].im;
+  }
+  meanReal /= samples;
+  meanImag /= samples;
+  for (uint_fast16_t i = 0; i < (samples >> 1); i++) {
+    T weighingFactor = ArduinoFFT<T>::weighingFactor(windowType, i, samples);
+    uint_fast16_t j = samples - (i + 1);
+    vData[i].re = (vData[i].re - meanReal) * weighingFactor;
+    vData[i].im = (vData[i].im - meanImag) * weighingFactor;
+    vData[j].re = (vData[j].re - meanReal) * weighingFactor;
+    vData[j].im = (vData[j].im - meanImag) * weighingFactor;
+  }
+  _fft.compute(vData, samples, FFTDirection::Forward);
+  // With Z = X + j Y for real x and y, X[k] = (Z[k] + conj(Z[-k])) / 2 and
+  // Y[k] = (Z[k] - conj(Z[-k])) / 2j. The factors of 1/2 are left out, which
+  // scales every average by 4 and cancels in coherence and transfer.
+  T weight = nextWeight();
+  T *vGxx = _vAccumulator;
+  T *vGyy = vGxx + _bins;
+  T *vGxyReal = vGyy + _bins;
+  T *vGxyImag = vGxyReal + _bins;
+  for (uint_fast16_t k = 0; k < _bins; k++) {
+    const FFTComplex<T> &z = vData[k];
+    const FFTComplex<T> &mirror = vData[k ? samples - k : 0];
+    T xReal = z.re + mirror.re;
+    T xImag = z.im - mirror.im;
+    T yReal = z.im + mirror.im;
+    T yImag = mirror.re - z.re;
+    vGxx[k] += weight * (sq(xReal) + sq(xImag) - vGxx[k]);
+    vGyy[k] += weight * (sq(yReal) + sq(yImag) - vGyy[k]);
+    vGxyReal[k] += weight * (xReal * yReal + xImag * yImag - vGxyReal[k]);
+    vGxyImag[k] += weight * (xReal * yImag - xImag * yReal - vGxyImag[k]);
+  }
+}
+
+// Writes the magnitude squared coherence |Gxy|^2 / (Gxx * Gyy) of each bin to
+// vData: 1 where the response is linear in the reference, towards 0 where it
+// is noise. A single frame always scores 1, so it needs several frames.
+template <typename T> void CrossSpectrum<T>::coherence(T *vData) const {
+  const T *vGxx = _vAccumulator;
+  const T *vGyy = vGxx + _bins;
+  const T *vGxyReal = vGyy + _bins;
+  const T *vGxyImag = vGxyReal + _bins;
+  for (uint_fast16_t k = 0; k < _bins; k++) {
+    T denominator = vGxx[k] * vGyy[k];
+    vData[k] = denominator > 0
+                   ? (sq(vGxyReal[k]) + sq(vGxyImag[k])) / denominator
+                   : 0;
+  }
+}
+
+// Writes the averaged cross spectrum, on the scale of complexToMagnitude()
+// squared times 4 like the auto spectra
+template <typename T>
+void CrossSpectrum<T>::crossSpectrum(T *vReal, T *vImag) const {
+  const T *vGxyReal = _vAccumulator + 2 * _bins;
+  const T *vGxyImag = vGxyReal + _bins;
+  for (uint_fast16_t k = 0; k < _bins; k++) {
+    vReal[k] = T(0.25) * vGxyReal[k];
+    vImag[k] = T(0.25) * vGxyImag[k];
+  }
+}
+
+// True once a linear average covers all its frames, or an exponential
+// average has seen a frame
+template <typename T> bool CrossSpectrum<T>::ready(void) const {
+  if (_averaging == FFTAveraging::Linear) {
+    return _count >= _frames;
+  }
+  return _count > 0;
+}
+
+// Writes the averaged spectrum of the reference channel, see
+// WelchPSD<T>::spectrum()
+template <typename T>
+void CrossSpectrum<T>::referenceSpectrum(T *vData, FFTScale scale,
+                                         T gain) const {
+  ArduinoFFT<T>::powerToSpectrum(_vAccumulator, vData, _bins, scale,
+                                 T(0.5) * gain);
+}
+
+// Writes the averaged spectrum of the response channel, see
+// WelchPSD<T>::spectrum()
+template <typename T>
+void CrossSpectrum<T>::responseSpectrum(T *vData, FFTScale scale,
+                                        T gain) const {
+  ArduinoFFT<T>::powerToSpectrum(_vAccumulator + _bins, vData, _bins, scale,
+                                 T(0.5) * gain);
+}
+
+// Same as WelchPSD<T>::setAveraging(). Restarts the average.
+template <typename T>
+void CrossSpectrum<T>::setAveraging(FFTAveraging averaging,
+                                    uint_fast16_t frames, T alpha) {
+  _averaging = averaging;
+  _frames = frames ? frames : 1;
+  _alpha = alpha;
+  _count = 0;
+}
+
+// Same as WelchPSD<T>::setBins(), for frames of 2 * (bins - 1) pairs. The
+// accumulator must hold 4 * bins values. Restarts the average.
+template <typename T> void CrossSpectrum<T>::setBins(uint_fast16_t bins) {
+  _bins = bins;
+  _count = 0;
+}
+
+// Writes the H1 transfer function estimate Gxy / Gxx: its gain on the given
+// scale to vMagnitude and, unless vPhase is nullptr, its phase in radians to
+// vPhase. H1 is unbiased by noise on the response, not on the reference.
+// Bins without reference power get 0.
+template <typename T>
+void CrossSpectrum<T>::transfer(T *vMagnitude, T *vPhase,
+                                FFTScale scale) const {
+  const T *vGxx = _vAccumulator;
+  const T *vGxyReal = vGxx + 2 * _bins;
+  const T *vGxyImag = vGxyReal + _bins;
+  for (uint_fast16_t k = 0; k < _bins; k++) {
+    if (vPhase) {
+      vPhase[k] = atan2(vGxyImag[k], vGxyReal[k]);
+    }
+    // Squared, so powerToSpectrum() reads it as a power ratio
+    vMagnitude[k] = vGxx[k] > 0
+                        ? (sq(vGxyReal[k]) + sq(vGxyImag[k])) / sq(vGxx[k])
+                        : 0;
+  }
+  ArduinoFFT<T>::powerToSpectrum(vMagnitude, vMagnitude, _bins, scale);
+}
+
+// Private functions
+
+// Same as WelchPSD<T>::nextWeight()
+template <typename T> T CrossSpectrum<T>::nextWeight(void) {
+  if (_averaging == FFTAveraging::Linear && _count >= _frames) {
+    _count = 0;
+  }
+  if (_count < UINT16_MAX) {
+    _count++;
+  }
+  if (_averaging == FFTAveraging::Linear || _count == 1) {
+    return T(1.0) / _count;
+  }
+  return _alpha;
+}
+
+template class CrossSpectrum<double>;
+template class CrossSpectrum<float>;
@@ -0,0 +1,69 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef CrossSpectrum_h /* Prevent loading library twice */
+#define CrossSpectrum_h
+
+#include "arduinoFFT.h"
+#include "welchPSD.h"
+
+// Two channel analysis of a reference x and a response y sampled together:
+// averaged auto spectra Gxx and Gyy, the cross spectrum Gxy = conj(X) * Y, the
+// magnitude squared coherence and the H1 transfer function estimate Gxy / Gxx.
+// Each frame holds both channels as one complex signal x + j y, so a single
+// complex FFT of samples points yields both spectra, separated through the
+// symmetry of real signals. The averages are kept in the caller's accumulator
+// array of 4 * bins values (bins = samples / 2 + 1), nothing is allocated.
+template <typename T> class CrossSpectrum {
+public:
+  CrossSpectrum(T *vAccumulator, uint_fast16_t bins,
+                FFTAveraging averaging = FFTAveraging::Linear,
+                uint_fast16_t frames = 8, T alpha = 0.25);
+
+  void add(FFTComplex<T> *vData, FFTWindow windowType = FFTWindow::Hamming);
+  void coherence(T *vData) const;
+  void crossSpectrum(T *vReal, T *vImag) const;
+  uint_fast16_t frames(void) const { return _count; }
+  bool ready(void) const;
+  void referenceSpectrum(T *vData, FFTScale scale, T gain = 1.0) const;
+  void reset(void) { _count = 0; }
+  void responseSpectrum(T *vData, FFTScale scale, T gain = 1.0) const;
+  void setAveraging(FFTAveraging averaging, uint_fast16_t frames,
+                    T alpha = 0.25);
+  void setBins(uint_fast16_t bins);
+  void transfer(T *vMagnitude, T *vPhase = nullptr,
+                FFTScale scale = FFTScale::Magnitude) const;
+
+private:
+  /* Variables */
+  T _alpha;
+  FFTAveraging _averaging;
+  uint_fast16_t _bins;
+  uint_fast16_t _count = 0; // Frames in the current average
+  ArduinoFFT<T> _fft;
+  uint_fast16_t _frames;
+  T *_vAccumulator; // Gxx, Gyy, real and imaginary Gxy, bins values each
+  /* Functions */
+  T nextWeight(void);
+};
+
+#endif
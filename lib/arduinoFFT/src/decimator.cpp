@@ -0,0 +1,109 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "decimator.h"
+
+template <typename T> Decimator<T>::Decimator(uint_fast8_t ratio) {
+  setRatio(ratio);
+}
+
+// Clears the filter state of all stages
+template <typename T> void Decimator<T>::reset(void) {
+  for (uint_fast8_t stage = 0; stage < DECIMATOR_MAX_STAGES; stage++) {
+    for (uint_fast8_t i = 0; i < 2 * DECIMATOR_TAPS; i++) {
+      _history[stage][i] = 0.0;
+    }
+    _odd[stage] = false;
+    _position[stage] = 0;
+  }
+}
+
+// Returns false and keeps the current ratio unless ratio is a power of two
+// up to 2^DECIMATOR_MAX_STAGES. Clears the filter state.
+template <typename T> bool Decimator<T>::setRatio(uint_fast8_t ratio) {
+  uint_fast8_t stages = 0;
+  while ((1 << stages) < ratio) {
+    stages++;
+  }
+  if ((stages > DECIMATOR_MAX_STAGES) || ((1 << stages) != ratio)) {
+    return false;
+  }
+  _stages = stages;
+  reset();
+  return true;
+}
+
+// Filters one input sample. Returns true and stores an output sample on every
+// ratio-th call.
+template <typename T> bool Decimator<T>::update(T sample, T *output) {
+  for (uint_fast8_t stage = 0; stage < _stages; stage++) {
+    if (!halve(stage, &sample)) {
+      return false;
+    }
+  }
+  *output = sample;
+  return true;
+}
+
+// Private functions
+
+// Feeds sample to a stage. On every second call the stage output replaces
+// sample and true is returned.
+template <typename T>
+bool Decimator<T>::halve(uint_fast8_t stage, T *sample) {
+  T *history = _history[stage];
+  uint_fast8_t position = _position[stage];
+  history[position] = *sample;
+  history[position + DECIMATOR_TAPS] = *sample;
+  if (++position == DECIMATOR_TAPS) {
+    position = 0;
+  }
+  _position[stage] = position;
+  _odd[stage] = !_odd[stage];
+  if (_odd[stage]) {
+    return false;
+  }
+  // Oldest to newest sample; the centre tap is 0.5, the other non zero taps
+  // sit at odd distances from it and are symmetric
+  const T *window = history + position;
+  const uint_fast8_t middle = (DECIMATOR_TAPS - 1) / 2;
+  T sum = 0.5 * window[middle];
+  for (uint_fast8_t k = 0; k < (DECIMATOR_TAPS + 1) / 4; k++) {
+    uint_fast8_t distance = 2 * k + 1;
+    sum += _coefficients[k] *
+           (window[middle - distance] + window[middle + distance]);
+  }
+  *sample = sum;
+  return true;
+}
+
+// Half band low pass taps at distances 1, 3, 5, ... from the centre tap:
+// 0.5 * sinc(n / 2) with a Kaiser window (beta 7.857), normalized together
+// with the centre tap of 0.5 to unity gain at DC
+template <typename T>
+const T Decimator<T>::_coefficients[(DECIMATOR_TAPS + 1) / 4] = {
+    0.316447695343,  -0.100625168981, 0.054895545392,  -0.033920370931,
+    0.021650642040,  -0.013730187944, 0.008450753034,  -0.004952258316,
+    0.002706740327,  -0.001341724373, 0.000575434547,  -0.000192567967,
+    0.000034029061};
+
+template class Decimator<double>;
+template class Decimator<float>;
@@ -0,0 +1,62 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef Decimator_h /* Prevent loading library twice */
+#define Decimator_h
+
+#include "arduinoFFT.h"
+
+/* Decimation by up to 2^DECIMATOR_MAX_STAGES */
+#ifndef DECIMATOR_MAX_STAGES
+#define DECIMATOR_MAX_STAGES 4
+#endif
+#define DECIMATOR_TAPS 51 // Length of the half band filter of each stage
+
+// Multi-stage decimator for oversampled input. Each stage halves the rate with
+// a 51 tap half band low pass (Kaiser window, 79 dB stopband) evaluated in
+// polyphase form: only every second output is computed, and every second
+// coefficient is zero, so a stage costs 14 multiplications per output. The
+// passband reaches 0.4 times the final rate, aliases above it are at least
+// 79 dB down. Ratios are 1 (pass through), 2, 4, 8 and 16.
+template <typename T> class Decimator {
+public:
+  Decimator(uint_fast8_t ratio = 1);
+
+  uint_fast8_t ratio(void) const { return 1 << _stages; }
+  void reset(void);
+  bool setRatio(uint_fast8_t ratio);
+  bool update(T sample, T *output);
+
+private:
+  /* Variables */
+  static const T _coefficients[(DECIMATOR_TAPS + 1) / 4];
+  // Each sample is stored twice, DECIMATOR_TAPS apart, so the newest
+  // DECIMATOR_TAPS samples are always contiguous
+  T _history[DECIMATOR_MAX_STAGES][2 * DECIMATOR_TAPS];
+  bool _odd[DECIMATOR_MAX_STAGES];
+  uint_fast8_t _position[DECIMATOR_MAX_STAGES];
+  uint_fast8_t _stages = 0;
+  /* Functions */
+  bool halve(uint_fast8_t stage, T *sample);
+};
+
+#endif
@@ -0,0 +1,285 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "arduinoFFT.h"
+#include <new>
+
+template <typename T>
+FFTPlan<T> *FFTPlan<T>::_cache[FFT_PLAN_CACHE_SIZE] = {nullptr};
+template <typename T> uint32_t FFTPlan<T>::_uses = 0;
+
+// Returns the cached plan for the given size and direction, building it on
+// first use. Once the cache is full, the new plan replaces the least recently
+// used one. Returns a null pointer if memory runs out.
+template <typename T>
+const FFTPlan<T> *FFTPlan<T>::get(uint_fast16_t samples, FFTDirection dir) {
+  _uses++;
+  // An empty slot if there is one, else the oldest plan
+  FFTPlan<T> **slot = &_cache[0];
+  for (uint_fast8_t i = 0; i < FFT_PLAN_CACHE_SIZE; i++) {
+    FFTPlan<T> *plan = _cache[i];
+    if (plan == nullptr) {
+      if (*slot != nullptr) {
+        slot = &_cache[i];
+      }
+      continue;
+    }
+    if (plan->_samples == samples && plan->_dir == dir) {
+      plan->_used = _uses;
+      return plan;
+    }
+    if (*slot != nullptr && plan->_used < (*slot)->_used) {
+      slot = &_cache[i];
+    }
+  }
+  destroy(*slot);
+  *slot = build(samples, dir);
+  if (*slot) {
+    (*slot)->_used = _uses;
+  }
+  return *slot;
+}
+
+// Frees all cached plans. No transform may be running.
+template <typename T> void FFTPlan<T>::clear(void) {
+  for (uint_fast8_t i = 0; i < FFT_PLAN_CACHE_SIZE; i++) {
+    destroy(_cache[i]);
+    _cache[i] = nullptr;
+  }
+}
+
+template <typename T>
+FFTPlan<T>::FFTPlan(uint_fast16_t samples, FFTDirection dir)
+    : _dir(dir), _power(0), _samples(samples) {
+  while ((samples >> _power) > 1)
+    _power++;
+  // Factor into radix 4, 2, 3 and 5 stages, first applied first
+  uint_fast16_t rest = samples;
+  while (rest > 1 && (rest & 3) == 0) {
+    _radices[_stages++] = 4;
+    rest >>= 2;
+  }
+  for (uint_fast8_t radix = 2; radix <= FFT_MAX_RADIX; radix++) {
+    while (rest > 1 && (rest % radix) == 0) {
+      _radices[_stages++] = radix;
+      rest /= radix;
+    }
+  }
+  if ((samples & (samples - 1)) == 0) {
+    _algorithm = FFTAlgorithm::Radix2;
+    buildRadix2();
+  } else if (rest == 1) {
+    _algorithm = FFTAlgorithm::MixedRadix;
+    buildMixedRadix();
+  } else {
+    _algorithm = FFTAlgorithm::Bluestein;
+    buildBluestein();
+  }
+}
+
+template <typename T> FFTPlan<T>::~FFTPlan() {
+  fftRelease(_bitReverse);
+  fftRelease(_cos);
+  fftRelease(_cycles);
+  fftRelease(_filterImag);
+  fftRelease(_filterReal);
+  destroy(_inner);
+  fftRelease(_sin);
+  fftRelease(_workImag);
+  fftRelease(_workReal);
+}
+
+// Private functions
+
+// A new plan, or a null pointer if it or its tables cannot be allocated. The
+// plan itself comes from fftAllocateBytes() like its tables.
+template <typename T>
+FFTPlan<T> *FFTPlan<T>::build(uint_fast16_t samples, FFTDirection dir) {
+  void *memory = fftAllocateBytes(sizeof(FFTPlan<T>), "FFT plan");
+  if (memory == nullptr) {
+    return nullptr;
+  }
+  FFTPlan<T> *plan = new (memory) FFTPlan<T>(samples, dir);
+  if (!plan->valid()) {
+    destroy(plan);
+    return nullptr;
+  }
+  return plan;
+}
+
+// Frees a plan of build() and its tables; a null pointer is ignored
+template <typename T> void FFTPlan<T>::destroy(FFTPlan<T> *plan) {
+  if (plan) {
+    plan->~FFTPlan();
+    fftRelease(plan);
+  }
+}
+
+// Chirp c[n] = exp(-+i * pi * n^2 / samples) in _cos and _sin, and the
+// transform of its conjugate, wrapped around a power of two size of at least
+// 2 * samples - 1, scaled by the inverse transform's 1 / size. The filter is
+// transformed with the inner plan and the work buffer. Sizes above 32768 are
+// left without tables, as the inner plan would need more than 65536 points.
+template <typename T> void FFTPlan<T>::buildBluestein(void) {
+  uint32_t size = 1;
+  while (size < (((uint32_t)_samples << 1) - 1)) {
+    size <<= 1;
+  }
+  if (size > 65536) {
+    return;
+  }
+  _cos = fftAllocate<T>(_samples, "FFT plan");
+  _sin = fftAllocate<T>(_samples, "FFT plan");
+  _filterReal = fftAllocate<T>(size, "FFT plan");
+  _filterImag = fftAllocate<T>(size, "FFT plan");
+  _workReal = fftAllocate<T>(size, "FFT plan");
+  _workImag = fftAllocate<T>(size, "FFT plan");
+  _inner = build(size, FFTDirection::Forward);
+  if (!valid()) {
+    return;
+  }
+  // n^2 modulo 2 * samples keeps the angle small and exact
+  uint32_t period = (uint32_t)_samples << 1;
+  for (uint_fast16_t n = 0; n < _samples; n++) {
+    double angle = 3.14159265358979323846 *
+                   (((uint32_t)n * n) % period) / _samples;
+    _cos[n] = ::cos(angle);
+    _sin[n] = (_dir == FFTDirection::Forward) ? -::sin(angle) : ::sin(angle);
+  }
+  for (uint_fast16_t n = 0; n < size; n++) {
+    _filterReal[n] = 0.0;
+    _filterImag[n] = 0.0;
+  }
+  _filterReal[0] = _cos[0];
+  _filterImag[0] = -_sin[0];
+  for (uint_fast16_t n = 1; n < _samples; n++) {
+    _filterReal[n] = _filterReal[size - n] = _cos[n];
+    _filterImag[n] = _filterImag[size - n] = -_sin[n];
+  }
+  ArduinoFFT<T> fft;
+  fft.bitReverse(_filterReal, _filterImag, size, _inner);
+  fft.butterflies(_filterReal, _filterImag, size, _inner->_power,
+                  FFTDirection::Forward, _inner);
+  T scale = 1.0 / size;
+  for (uint_fast16_t n = 0; n < size; n++) {
+    _filterReal[n] *= scale;
+    _filterImag[n] *= scale;
+  }
+}
+
+// Twiddle factors for a full turn and the digit reversal permutation of the
+// stages: position p of the permuted input holds sample _bitReverse[p]. The
+// permutation is applied in-place cycle by cycle, from _cycles.
+template <typename T> void FFTPlan<T>::buildMixedRadix(void) {
+  _bitReverse = fftAllocate<uint16_t>(_samples, "FFT plan");
+  _cos = fftAllocate<T>(_samples, "FFT plan");
+  _sin = fftAllocate<T>(_samples, "FFT plan");
+  if (!_bitReverse || !_cos || !_sin) {
+    return;
+  }
+  for (uint_fast16_t p = 0; p < _samples; p++) {
+    // The last stage combines blocks of samples / radix positions, block q
+    // holding the samples congruent to q modulo its radix, and so on inwards
+    uint_fast16_t rest = p;
+    uint_fast16_t size = _samples;
+    uint_fast16_t weight = 1;
+    uint_fast16_t n = 0;
+    for (uint_fast8_t s = _stages; s > 0; s--) {
+      size /= _radices[s - 1];
+      n += (rest / size) * weight;
+      rest %= size;
+      weight *= _radices[s - 1];
+    }
+    _bitReverse[p] = n;
+  }
+  // Count the cycles, then record their first positions. A position starts a
+  // cycle if it is the smallest one on it.
+  for (uint_fast8_t pass = 0; pass < 2; pass++) {
+    _cycleCount = 0;
+    for (uint_fast16_t p = 1; p < _samples; p++) {
+      uint_fast16_t q = _bitReverse[p];
+      while (q > p) {
+        q = _bitReverse[q];
+      }
+      if (q == p && _bitReverse[p] != p) {
+        if (pass) {
+          _cycles[_cycleCount] = p;
+        }
+        _cycleCount++;
+      }
+    }
+    if (!pass) {
+      _cycles =
+          fftAllocate<uint16_t>(_cycleCount ? _cycleCount : 1, "FFT plan");
+      if (!_cycles) {
+        return;
+      }
+    }
+  }
+  const double step = 6.28318530717958647692 / _samples;
+  for (uint_fast16_t k = 0; k < _samples; k++) {
+    double angle = step * k;
+    _cos[k] = ::cos(angle);
+    _sin[k] = (_dir == FFTDirection::Forward) ? -::sin(angle) : ::sin(angle);
+  }
+}
+
+template <typename T> void FFTPlan<T>::buildRadix2(void) {
+  uint_fast16_t half = _samples >> 1;
+  _bitReverse = fftAllocate<uint16_t>(_samples, "FFT plan");
+  _cos = fftAllocate<T>(half, "FFT plan");
+  _sin = fftAllocate<T>(half, "FFT plan");
+  if (!_bitReverse || !_cos || !_sin) {
+    return;
+  }
+  for (uint_fast16_t i = 0; i < _samples; i++) {
+    uint_fast16_t r = 0;
+    for (uint_fast8_t b = 0; b < _power; b++) {
+      r |= ((i >> b) & 1) << (_power - 1 - b);
+    }
+    _bitReverse[i] = r;
+  }
+  // Evaluate the angles in double precision (and with more digits than twoPi)
+  // so that float plans carry no more error than the rounding of each entry
+  const double step = 6.28318530717958647692 / _samples;
+  for (uint_fast16_t k = 0; k < half; k++) {
+    double angle = step * k;
+    _cos[k] = ::cos(angle);
+    _sin[k] = (_dir == FFTDirection::Forward) ? -::sin(angle) : ::sin(angle);
+  }
+}
+
+// True if all tables of the algorithm could be allocated
+template <typename T> bool FFTPlan<T>::valid(void) const {
+  switch (_algorithm) {
+  case FFTAlgorithm::Radix2:
+    return _bitReverse && _cos && _sin;
+  case FFTAlgorithm::MixedRadix:
+    return _bitReverse && _cos && _sin && _cycles;
+  default:
+    return _cos && _sin && _filterReal && _filterImag && _workReal &&
+           _workImag && _inner && _inner->valid();
+  }
+}
+
+template class FFTPlan<double>;
+template class FFTPlan<float>;
@@ -0,0 +1,291 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "fftSIMD.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define FFT_SIMD_X86
+#include <immintrin.h>
+#endif
+
+#ifdef FFT_SIMD_X86
+
+static FFTInstructionSet bestInstructionSet(void) {
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return FFTInstructionSet::AVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return FFTInstructionSet::SSE2;
+  }
+  return FFTInstructionSet::Scalar;
+}
+
+// Set before main() runs, simdSetInstructionSet() can override it later
+static FFTInstructionSet _instructionSet = bestInstructionSet();
+
+// Radix-2 stage on lanes the vector kernels can't fill
+static void scalarStage(float *vReal, float *vImag, uint_fast16_t samples,
+                        uint_fast16_t l1, const FFTPlan<float> *plan) {
+  uint_fast16_t l2 = l1 << 1;
+  uint_fast16_t step = plan->samples() / l2;
+  for (uint_fast16_t j = 0; j < l1; j++) {
+    float u1 = plan->cosTable()[j * step];
+    float u2 = plan->sinTable()[j * step];
+    for (uint_fast16_t i = j; i < samples; i += l2) {
+      uint_fast16_t i1 = i + l1;
+      float t1 = u1 * vReal[i1] - u2 * vImag[i1];
+      float t2 = u1 * vImag[i1] + u2 * vReal[i1];
+      vReal[i1] = vReal[i] - t1;
+      vImag[i1] = vImag[i] - t2;
+      vReal[i] += t1;
+      vImag[i] += t2;
+    }
+  }
+}
+
+// Four butterflies at once. Twiddles are gathered once per group of four j
+// and then applied to every block of the stage.
+__attribute__((target("sse2"))) static void
+sse2Stage(float *vReal, float *vImag, uint_fast16_t samples, uint_fast16_t l1,
+          const FFTPlan<float> *plan) {
+  uint_fast16_t l2 = l1 << 1;
+  uint_fast16_t step = plan->samples() / l2;
+  const float *cosTable = plan->cosTable();
+  const float *sinTable = plan->sinTable();
+  for (uint_fast16_t j = 0; j < l1; j += 4) {
+    __m128 u1;
+    __m128 u2;
+    if (step == 1) {
+      // Last stage: the twiddles are contiguous
+      u1 = _mm_loadu_ps(&cosTable[j]);
+      u2 = _mm_loadu_ps(&sinTable[j]);
+    } else {
+      u1 = _mm_set_ps(cosTable[(j + 3) * step], cosTable[(j + 2) * step],
+                      cosTable[(j + 1) * step], cosTable[j * step]);
+      u2 = _mm_set_ps(sinTable[(j + 3) * step], sinTable[(j + 2) * step],
+                      sinTable[(j + 1) * step], sinTable[j * step]);
+    }
+    for (uint_fast16_t i = j; i < samples; i += l2) {
+      uint_fast16_t i1 = i + l1;
+      __m128 xr = _mm_loadu_ps(&vReal[i1]);
+      __m128 xi = _mm_loadu_ps(&vImag[i1]);
+      __m128 t1 = _mm_sub_ps(_mm_mul_ps(u1, xr), _mm_mul_ps(u2, xi));
+      __m128 t2 = _mm_add_ps(_mm_mul_ps(u1, xi), _mm_mul_ps(u2, xr));
+      __m128 ar = _mm_loadu_ps(&vReal[i]);
+      __m128 ai = _mm_loadu_ps(&vImag[i]);
+      _mm_storeu_ps(&vReal[i1], _mm_sub_ps(ar, t1));
+      _mm_storeu_ps(&vImag[i1], _mm_sub_ps(ai, t2));
+      _mm_storeu_ps(&vReal[i], _mm_add_ps(ar, t1));
+      _mm_storeu_ps(&vImag[i], _mm_add_ps(ai, t2));
+    }
+  }
+}
+
+// Eight butterflies at once, twiddles are loaded like in sse2Stage. A
+// hardware gather was no faster here and is slow on some CPUs.
+__attribute__((target("avx2,fma"))) static void
+avx2Stage(float *vReal, float *vImag, uint_fast16_t samples, uint_fast16_t l1,
+          const FFTPlan<float> *plan) {
+  uint_fast16_t l2 = l1 << 1;
+  uint_fast16_t step = plan->samples() / l2;
+  const float *cosTable = plan->cosTable();
+  const float *sinTable = plan->sinTable();
+  for (uint_fast16_t j = 0; j < l1; j += 8) {
+    __m256 u1;
+    __m256 u2;
+    if (step == 1) {
+      u1 = _mm256_loadu_ps(&cosTable[j]);
+      u2 = _mm256_loadu_ps(&sinTable[j]);
+    } else {
+      const float *c = &cosTable[j * step];
+      const float *s = &sinTable[j * step];
+      u1 = _mm256_setr_ps(c[0], c[step], c[2 * step], c[3 * step],
+                          c[4 * step], c[5 * step], c[6 * step], c[7 * step]);
+      u2 = _mm256_setr_ps(s[0], s[step], s[2 * step], s[3 * step],
+                          s[4 * step], s[5 * step], s[6 * step], s[7 * step]);
+    }
+    for (uint_fast16_t i = j; i < samples; i += l2) {
+      uint_fast16_t i1 = i + l1;
+      __m256 xr = _mm256_loadu_ps(&vReal[i1]);
+      __m256 xi = _mm256_loadu_ps(&vImag[i1]);
+      __m256 t1 = _mm256_fmsub_ps(u1, xr, _mm256_mul_ps(u2, xi));
+      __m256 t2 = _mm256_fmadd_ps(u1, xi, _mm256_mul_ps(u2, xr));
+      __m256 ar = _mm256_loadu_ps(&vReal[i]);
+      __m256 ai = _mm256_loadu_ps(&vImag[i]);
+      _mm256_storeu_ps(&vReal[i1], _mm256_sub_ps(ar, t1));
+      _mm256_storeu_ps(&vImag[i1], _mm256_sub_ps(ai, t2));
+      _mm256_storeu_ps(&vReal[i], _mm256_add_ps(ar, t1));
+      _mm256_storeu_ps(&vImag[i], _mm256_add_ps(ai, t2));
+    }
+  }
+}
+
+bool simdButterflies(float *vReal, float *vImag, uint_fast16_t samples,
+                     const FFTPlan<float> *plan) {
+  if (_instructionSet == FFTInstructionSet::Scalar) {
+    return false;
+  }
+  for (uint_fast16_t l1 = 1; l1 < samples; l1 <<= 1) {
+    if (l1 >= 8 && _instructionSet == FFTInstructionSet::AVX2) {
+      avx2Stage(vReal, vImag, samples, l1, plan);
+    } else if (l1 >= 4) {
+      sse2Stage(vReal, vImag, samples, l1, plan);
+    } else {
+      scalarStage(vReal, vImag, samples, l1, plan);
+    }
+  }
+  return true;
+}
+
+__attribute__((target("avx2,fma"))) static void
+avx2Magnitude(float *vMagnitude, const float *vImag, uint_fast16_t count) {
+  uint_fast16_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 re = _mm256_loadu_ps(&vMagnitude[i]);
+    __m256 im = _mm256_loadu_ps(&vImag[i]);
+    __m256 power = _mm256_fmadd_ps(re, re, _mm256_mul_ps(im, im));
+    _mm256_storeu_ps(&vMagnitude[i], _mm256_sqrt_ps(power));
+  }
+  for (; i < count; i++) {
+    vMagnitude[i] = sqrtf(sq(vMagnitude[i]) + sq(vImag[i]));
+  }
+}
+
+__attribute__((target("sse2"))) static void
+sse2Magnitude(float *vMagnitude, const float *vImag, uint_fast16_t count) {
+  uint_fast16_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 re = _mm_loadu_ps(&vMagnitude[i]);
+    __m128 im = _mm_loadu_ps(&vImag[i]);
+    __m128 power = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+    _mm_storeu_ps(&vMagnitude[i], _mm_sqrt_ps(power));
+  }
+  for (; i < count; i++) {
+    vMagnitude[i] = sqrtf(sq(vMagnitude[i]) + sq(vImag[i]));
+  }
+}
+
+bool simdComplexToMagnitude(float *vMagnitude, const float *vImag,
+                            uint_fast16_t count) {
+  if (_instructionSet == FFTInstructionSet::Scalar) {
+    return false;
+  }
+  if (_instructionSet == FFTInstructionSet::AVX2) {
+    avx2Magnitude(vMagnitude, vImag, count);
+  } else {
+    sse2Magnitude(vMagnitude, vImag, count);
+  }
+  return true;
+}
+
+// The factors cover the first half of the window, the second half is read
+// backwards, so the upper samples use a lane reversed copy of the factors
+__attribute__((target("avx2,fma"))) static void
+avx2Windowing(float *vData, uint_fast16_t samples,
+              const float *windowingFactors) {
+  uint_fast16_t half = samples >> 1;
+  const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+  uint_fast16_t i = 0;
+  for (; i + 8 <= half; i += 8) {
+    __m256 factors = _mm256_loadu_ps(&windowingFactors[i]);
+    float *upper = &vData[samples - (i + 8)];
+    _mm256_storeu_ps(&vData[i],
+                     _mm256_mul_ps(_mm256_loadu_ps(&vData[i]), factors));
+    _mm256_storeu_ps(upper, _mm256_mul_ps(_mm256_loadu_ps(upper),
+                                          _mm256_permutevar8x32_ps(
+                                              factors, reverse)));
+  }
+  for (; i < half; i++) {
+    vData[i] *= windowingFactors[i];
+    vData[samples - (i + 1)] *= windowingFactors[i];
+  }
+}
+
+__attribute__((target("sse2"))) static void
+sse2Windowing(float *vData, uint_fast16_t samples,
+              const float *windowingFactors) {
+  uint_fast16_t half = samples >> 1;
+  uint_fast16_t i = 0;
+  for (; i + 4 <= half; i += 4) {
+    __m128 factors = _mm_loadu_ps(&windowingFactors[i]);
+    float *upper = &vData[samples - (i + 4)];
+    _mm_storeu_ps(&vData[i], _mm_mul_ps(_mm_loadu_ps(&vData[i]), factors));
+    _mm_storeu_ps(upper,
+                  _mm_mul_ps(_mm_loadu_ps(upper),
+                             _mm_shuffle_ps(factors, factors,
+                                            _MM_SHUFFLE(0, 1, 2, 3))));
+  }
+  for (; i < half; i++) {
+    vData[i] *= windowingFactors[i];
+    vData[samples - (i + 1)] *= windowingFactors[i];
+  }
+}
+
+bool simdWindowing(float *vData, uint_fast16_t samples,
+                   const float *windowingFactors) {
+  if (_instructionSet == FFTInstructionSet::Scalar) {
+    return false;
+  }
+  if (_instructionSet == FFTInstructionSet::AVX2) {
+    avx2Windowing(vData, samples, windowingFactors);
+  } else {
+    sse2Windowing(vData, samples, windowingFactors);
+  }
+  return true;
+}
+
+bool simdSupports(FFTInstructionSet instructionSet) {
+  return instructionSet <= bestInstructionSet();
+}
+
+#else
+
+static FFTInstructionSet _instructionSet = FFTInstructionSet::Scalar;
+
+bool simdButterflies(float *, float *, uint_fast16_t, const FFTPlan<float> *) {
+  return false;
+}
+
+bool simdComplexToMagnitude(float *, const float *, uint_fast16_t) {
+  return false;
+}
+
+bool simdWindowing(float *, uint_fast16_t, const float *) { return false; }
+
+bool simdSupports(FFTInstructionSet instructionSet) {
+  return instructionSet == FFTInstructionSet::Scalar;
+}
+
+#endif
+
+FFTInstructionSet simdInstructionSet(void) { return _instructionSet; }
+
+// Forces an instruction set, e.g. Scalar to compare against the vector code.
+// Returns false if the CPU doesn't support it.
+bool simdSetInstructionSet(FFTInstructionSet instructionSet) {
+  if (!simdSupports(instructionSet)) {
+    return false;
+  }
+  _instructionSet = instructionSet;
+  return true;
+}
@@ -0,0 +1,60 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef FFTSIMD_h /* Prevent loading library twice */
+#define FFTSIMD_h
+
+#include "arduinoFFT.h"
+
+// Vector kernels for x86 host builds. The best instruction set the CPU
+// supports is picked by a static initializer when the program loads;
+// everywhere else only Scalar is available and ArduinoFFT runs its regular
+// loops.
+enum class FFTInstructionSet { Scalar, SSE2, AVX2 };
+
+FFTInstructionSet simdInstructionSet(void);
+bool simdSetInstructionSet(FFTInstructionSet instructionSet);
+bool simdSupports(FFTInstructionSet instructionSet);
+
+// Kernels used by ArduinoFFT<float>. They return false when the scalar code
+// has to run instead, which is always the case for other data types.
+template <typename T>
+inline bool simdButterflies(T *, T *, uint_fast16_t, const FFTPlan<T> *) {
+  return false;
+}
+template <typename T>
+inline bool simdComplexToMagnitude(T *, const T *, uint_fast16_t) {
+  return false;
+}
+template <typename T>
+inline bool simdWindowing(T *, uint_fast16_t, const T *) {
+  return false;
+}
+
+bool simdButterflies(float *vReal, float *vImag, uint_fast16_t samples,
+                     const FFTPlan<float> *plan);
+bool simdComplexToMagnitude(float *vMagnitude, const float *vImag,
+                            uint_fast16_t count);
+bool simdWindowing(float *vData, uint_fast16_t samples,
+                   const float *windowingFactors);
+
+#endif
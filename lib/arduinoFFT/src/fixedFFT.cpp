@@ -0,0 +1,265 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "fixedFFT.h"
+
+// A butterfly output is at most (1 + sqrt(2)) times the largest input
+// component, so inputs up to this value cannot overflow int16_t
+#define FIXED_FFT_SAFE_INPUT 13572
+
+static inline uint16_t absMax(uint16_t maxAbs, int32_t value) {
+  uint16_t absValue = (value < 0) ? -value : value;
+  return (absValue > maxAbs) ? absValue : maxAbs;
+}
+
+FixedFFT::FixedFFT(int16_t *vReal, int16_t *vImag, uint_fast16_t samples)
+    : _samples(samples), _vImag(vImag), _vReal(vReal) {
+  buildTwiddles(samples);
+}
+
+FixedFFT::~FixedFFT(void) {
+  fftRelease(_cos);
+  fftRelease(_sin);
+  fftRelease(_windowingFactors);
+}
+
+int_fast8_t FixedFFT::complexToMagnitude(void) {
+  return complexToMagnitude(this->_vReal, this->_vImag, this->_samples);
+}
+
+// Integer magnitudes, stored in vReal. A magnitude can exceed the int16_t
+// range by up to sqrt(2); in that case the block is halved and the exponent
+// incremented. Returns the updated exponent.
+int_fast8_t FixedFFT::complexToMagnitude(int16_t *vReal, int16_t *vImag,
+                                         uint_fast16_t samples) {
+  uint16_t *vMagnitude = reinterpret_cast<uint16_t *>(vReal);
+  uint16_t maxMagnitude = 0;
+  for (uint_fast16_t i = 0; i < samples; i++) {
+    uint32_t power = int32_t(vReal[i]) * vReal[i] + int32_t(vImag[i]) * vImag[i];
+    vMagnitude[i] = sqrt32(power);
+    if (vMagnitude[i] > maxMagnitude) {
+      maxMagnitude = vMagnitude[i];
+    }
+  }
+  if (maxMagnitude > INT16_MAX) {
+    for (uint_fast16_t i = 0; i < samples; i++) {
+      vMagnitude[i] >>= 1;
+    }
+    _exponent++;
+  }
+  return _exponent;
+}
+
+int_fast8_t FixedFFT::compute(FFTDirection dir) {
+  return compute(this->_vReal, this->_vImag, this->_samples, dir);
+}
+
+// Computes in-place complex-to-complex FFT with block floating point scaling.
+// Returns the block exponent of the result. Without memory for the twiddle
+// factors the data is left untouched and 0 is returned, see valid().
+int_fast8_t FixedFFT::compute(int16_t *vReal, int16_t *vImag,
+                              uint_fast16_t samples, FFTDirection dir) {
+  _exponent = 0;
+  if ((samples != (uint_fast16_t(1) << _power) || !_cos) &&
+      !buildTwiddles(samples)) {
+    return _exponent;
+  }
+  // Reverse bits
+  uint_fast16_t j = 0;
+  for (uint_fast16_t i = 0; i < (samples - 1); i++) {
+    if (i < j) {
+      int16_t temp = vReal[i];
+      vReal[i] = vReal[j];
+      vReal[j] = temp;
+      temp = vImag[i];
+      vImag[i] = vImag[j];
+      vImag[j] = temp;
+    }
+    uint_fast16_t k = (samples >> 1);
+    while (k <= j) {
+      j -= k;
+      k >>= 1;
+    }
+    j += k;
+  }
+  uint16_t maxAbs = 0;
+  for (uint_fast16_t i = 0; i < samples; i++) {
+    maxAbs = absMax(maxAbs, vReal[i]);
+    maxAbs = absMax(maxAbs, vImag[i]);
+  }
+  // Compute the FFT, the twiddle table is always read at the full-size stride
+  for (uint_fast16_t l1 = 1; l1 < samples; l1 <<= 1) {
+    uint_fast8_t shift = headroomShift(maxAbs);
+    if (shift) {
+      scale(vReal, vImag, samples, shift);
+      _exponent += shift;
+    }
+    maxAbs = 0;
+    uint_fast16_t l2 = l1 << 1;
+    uint_fast16_t step = samples / l2;
+    for (j = 0; j < l1; j++) {
+      int32_t u1 = _cos[j * step];
+      int32_t u2 = (dir == FFTDirection::Forward) ? _sin[j * step]
+                                                  : -_sin[j * step];
+      for (uint_fast16_t i = j; i < samples; i += l2) {
+        uint_fast16_t i1 = i + l1;
+        int32_t t1 = (u1 * vReal[i1] - u2 * vImag[i1] + (1 << 14)) >> 15;
+        int32_t t2 = (u1 * vImag[i1] + u2 * vReal[i1] + (1 << 14)) >> 15;
+        int32_t a1 = vReal[i] - t1;
+        int32_t a2 = vImag[i] - t2;
+        int32_t b1 = vReal[i] + t1;
+        int32_t b2 = vImag[i] + t2;
+        vReal[i1] = a1;
+        vImag[i1] = a2;
+        vReal[i] = b1;
+        vImag[i] = b2;
+        maxAbs = absMax(maxAbs, a1);
+        maxAbs = absMax(maxAbs, a2);
+        maxAbs = absMax(maxAbs, b1);
+        maxAbs = absMax(maxAbs, b2);
+      }
+    }
+  }
+  // Scaling for reverse transform
+  if (dir == FFTDirection::Reverse) {
+    uint_fast8_t power = 0;
+    while ((samples >> power) > 1)
+      power++;
+    _exponent -= power;
+  }
+  return _exponent;
+}
+
+void FixedFFT::dcRemoval(uint_fast8_t shift) {
+  dcRemoval(this->_vReal, this->_samples, shift);
+}
+
+// Subtracts the mean of vData and shifts the result left, e.g. by 3 to bring
+// 12 bit ADC codes to the full Q15 range
+void FixedFFT::dcRemoval(int16_t *vData, uint_fast16_t samples,
+                         uint_fast8_t shift) {
+  int32_t mean = 0;
+  for (uint_fast16_t i = 0; i < samples; i++) {
+    mean += vData[i];
+  }
+  mean /= int32_t(samples);
+  for (uint_fast16_t i = 0; i < samples; i++) {
+    int32_t value = (int32_t(vData[i]) - mean) * (1 << shift);
+    vData[i] = constrain(value, INT16_MIN, INT16_MAX);
+  }
+}
+
+// Applies a Q15 version of the ArduinoFFT window, the factors are kept until
+// the window type or size changes. Without memory for them the data is left
+// untouched.
+void FixedFFT::windowing(FFTWindow windowType) {
+  uint_fast16_t half = this->_samples >> 1;
+  if (!_windowingFactors || _windowFunction != windowType) {
+    if (!_windowingFactors) {
+      _windowingFactors = fftAllocate<int16_t>(half, "Fixed FFT");
+      if (!_windowingFactors) {
+        return;
+      }
+    }
+    for (uint_fast16_t i = 0; i < half; i++) {
+      float factor =
+          ArduinoFFT<float>::weighingFactor(windowType, i, this->_samples);
+      _windowingFactors[i] = constrain(lroundf(factor * 32768.0f), 0, INT16_MAX);
+    }
+    _windowFunction = windowType;
+  }
+  for (uint_fast16_t i = 0; i < half; i++) {
+    int32_t factor = _windowingFactors[i];
+    int16_t *first = &this->_vReal[i];
+    int16_t *last = &this->_vReal[this->_samples - (i + 1)];
+    *first = (factor * *first + (1 << 14)) >> 15;
+    *last = (factor * *last + (1 << 14)) >> 15;
+  }
+}
+
+// Private functions
+
+// Returns false, with no tables and valid() false, if they don't fit
+bool FixedFFT::buildTwiddles(uint_fast16_t samples) {
+  fftRelease(_cos);
+  fftRelease(_sin);
+  fftRelease(_windowingFactors);
+  _windowingFactors = nullptr;
+  _samples = samples;
+  _power = 0;
+  while ((samples >> _power) > 1)
+    _power++;
+  uint_fast16_t half = samples >> 1;
+  _cos = fftAllocate<int16_t>(half, "Fixed FFT");
+  _sin = fftAllocate<int16_t>(half, "Fixed FFT");
+  if (!_cos || !_sin) {
+    fftRelease(_cos);
+    fftRelease(_sin);
+    _cos = nullptr;
+    _sin = nullptr;
+    return false;
+  }
+  const double step = 6.28318530717958647692 / samples;
+  for (uint_fast16_t k = 0; k < half; k++) {
+    _cos[k] = lround(32767.0 * cos(step * k));
+    _sin[k] = lround(-32767.0 * sin(step * k));
+  }
+  return true;
+}
+
+// Smallest right shift that brings maxAbs down to FIXED_FFT_SAFE_INPUT
+uint_fast8_t FixedFFT::headroomShift(uint16_t maxAbs) const {
+  uint_fast8_t shift = 0;
+  while (maxAbs > FIXED_FFT_SAFE_INPUT) {
+    maxAbs = (maxAbs + 1) >> 1;
+    shift++;
+  }
+  return shift;
+}
+
+void FixedFFT::scale(int16_t *vReal, int16_t *vImag, uint_fast16_t samples,
+                     uint_fast8_t shift) const {
+  int16_t round = 1 << (shift - 1);
+  for (uint_fast16_t i = 0; i < samples; i++) {
+    vReal[i] = (vReal[i] + round) >> shift;
+    vImag[i] = (vImag[i] + round) >> shift;
+  }
+}
+
+// Integer square root, rounded down
+uint16_t FixedFFT::sqrt32(uint32_t value) {
+  uint32_t result = 0;
+  uint32_t bit = uint32_t(1) << 30;
+  while (bit > value) {
+    bit >>= 2;
+  }
+  while (bit) {
+    if (value >= result + bit) {
+      value -= result + bit;
+      result = (result >> 1) + bit;
+    } else {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+  return result;
+}
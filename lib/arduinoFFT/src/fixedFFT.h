@@ -0,0 +1,76 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef FixedFFT_h /* Prevent loading library twice */
+#define FixedFFT_h
+
+#include "arduinoFFT.h"
+
+// Q15 fixed point FFT with block floating point scaling. Data stays in int16_t
+// arrays and all arithmetic runs on integer multiplies. Before each stage the
+// block is shifted right just enough to rule out overflow; the total number of
+// shifts is reported as the block exponent, so that
+// true value = stored value * 2^exponent.
+class FixedFFT {
+public:
+  FixedFFT(int16_t *vReal, int16_t *vImag, uint_fast16_t samples);
+
+  ~FixedFFT();
+
+  int_fast8_t complexToMagnitude(void);
+  int_fast8_t complexToMagnitude(int16_t *vReal, int16_t *vImag,
+                                 uint_fast16_t samples);
+
+  int_fast8_t compute(FFTDirection dir);
+  int_fast8_t compute(int16_t *vReal, int16_t *vImag, uint_fast16_t samples,
+                      FFTDirection dir);
+
+  void dcRemoval(uint_fast8_t shift = 0);
+  void dcRemoval(int16_t *vData, uint_fast16_t samples,
+                 uint_fast8_t shift = 0);
+
+  int_fast8_t exponent(void) const { return _exponent; }
+
+  bool valid(void) const { return _cos != nullptr; }
+
+  void windowing(FFTWindow windowType);
+
+private:
+  /* Variables */
+  int_fast8_t _exponent = 0;
+  uint_fast8_t _power = 0;
+  uint_fast16_t _samples;
+  int16_t *_cos = nullptr; // Q15 twiddle factors, samples / 2 entries each
+  int16_t *_sin = nullptr;
+  int16_t *_vImag;
+  int16_t *_vReal;
+  FFTWindow _windowFunction = FFTWindow::Precompiled;
+  int16_t *_windowingFactors = nullptr; // Q15, samples / 2 entries
+  /* Functions */
+  bool buildTwiddles(uint_fast16_t samples);
+  uint_fast8_t headroomShift(uint16_t maxAbs) const;
+  void scale(int16_t *vReal, int16_t *vImag, uint_fast16_t samples,
+             uint_fast8_t shift) const;
+  static uint16_t sqrt32(uint32_t value);
+};
+
+#endif
@@ -0,0 +1,175 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "memoryArena.h"
+
+// The first pool, in internal RAM (a static array or a block of the heap)
+MemoryArena::MemoryArena(void *internal, size_t bytes) {
+  addPool(internal, bytes, ArenaPlacement::Internal);
+}
+
+// Adds a pool of internal or external memory. Returns false if base is
+// nullptr (e.g. a failed reservation) or all ARENA_MAX_POOLS are in use.
+bool MemoryArena::addPool(void *base, size_t bytes, ArenaPlacement placement) {
+  if (base == nullptr || _poolCount == ARENA_MAX_POOLS) {
+    return false;
+  }
+  if (placement == ArenaPlacement::PreferInternal) {
+    placement = ArenaPlacement::Internal;
+  } else if (placement == ArenaPlacement::PreferExternal) {
+    placement = ArenaPlacement::External;
+  }
+  Pool &pool = _pools[_poolCount++];
+  pool.base = static_cast<uint8_t *>(base);
+  pool.bytes = bytes;
+  pool.highWater = 0;
+  pool.placement = placement;
+  pool.used = 0;
+  return true;
+}
+
+// Region of bytes aligned to alignment (a power of two) in the pools the
+// placement allows, the preferred kind first and each kind in the order it
+// was added. Returns nullptr, counting a failure, if no pool has a gap that
+// large or all ARENA_MAX_REGIONS are in use.
+void *MemoryArena::allocate(size_t bytes, const char *name,
+                            ArenaPlacement placement, size_t alignment) {
+  ArenaPlacement first = ArenaPlacement::Internal;
+  ArenaPlacement second = ArenaPlacement::External;
+  if (placement == ArenaPlacement::External ||
+      placement == ArenaPlacement::PreferExternal) {
+    first = ArenaPlacement::External;
+    second = ArenaPlacement::Internal;
+  }
+  bool fallback = (placement == ArenaPlacement::PreferInternal ||
+                   placement == ArenaPlacement::PreferExternal);
+  for (uint_fast8_t pass = 0; pass < (fallback ? 2 : 1); pass++) {
+    for (uint_fast8_t pool = 0; pool < _poolCount; pool++) {
+      if (_pools[pool].placement != (pass == 0 ? first : second)) {
+        continue;
+      }
+      void *pointer = allocateIn(pool, bytes, name, alignment);
+      if (pointer != nullptr) {
+        return pointer;
+      }
+    }
+  }
+  _failures++;
+  return nullptr;
+}
+
+size_t MemoryArena::capacity(uint_fast8_t pool) const {
+  return (pool < _poolCount) ? _pools[pool].bytes : 0;
+}
+
+// Whether pointer lies in one of the pools
+bool MemoryArena::contains(const void *pointer) const {
+  const uint8_t *address = static_cast<const uint8_t *>(pointer);
+  for (uint_fast8_t pool = 0; pool < _poolCount; pool++) {
+    if (address >= _pools[pool].base &&
+        address < _pools[pool].base + _pools[pool].bytes) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t MemoryArena::highWater(uint_fast8_t pool) const {
+  return (pool < _poolCount) ? _pools[pool].highWater : 0;
+}
+
+ArenaPlacement MemoryArena::placement(uint_fast8_t pool) const {
+  return (pool < _poolCount) ? _pools[pool].placement
+                             : ArenaPlacement::Internal;
+}
+
+const ArenaRegion &MemoryArena::region(uint_fast8_t index) const {
+  return _regions[index];
+}
+
+// Frees the region starting at pointer. Returns false, changing nothing, if
+// no region starts there, so memory from elsewhere can be handed on to its
+// own allocator.
+bool MemoryArena::release(void *pointer) {
+  if (pointer == nullptr) {
+    return false;
+  }
+  for (uint_fast8_t i = 0; i < _regionCount; i++) {
+    const ArenaRegion &region = _regions[i];
+    if (_pools[region.pool].base + region.offset == pointer) {
+      _pools[region.pool].used -= region.bytes;
+      _regionCount--;
+      for (uint_fast8_t j = i; j < _regionCount; j++) {
+        _regions[j] = _regions[j + 1];
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t MemoryArena::used(uint_fast8_t pool) const {
+  return (pool < _poolCount) ? _pools[pool].used : 0;
+}
+
+// Private functions
+
+// First fit: the gaps before, between and after the regions of the pool, in
+// address order
+void *MemoryArena::allocateIn(uint_fast8_t pool, size_t bytes,
+                              const char *name, size_t alignment) {
+  if (_regionCount == ARENA_MAX_REGIONS) {
+    return nullptr;
+  }
+  if (bytes == 0) {
+    bytes = 1; // So every region starts at its own address
+  }
+  Pool &target = _pools[pool];
+  uintptr_t mask = alignment - 1;
+  size_t gapStart = 0;
+  uint_fast8_t index = 0;
+  for (; index <= _regionCount; index++) {
+    bool inPool = index < _regionCount && _regions[index].pool == pool;
+    if (index < _regionCount && _regions[index].pool < pool) {
+      continue;
+    }
+    size_t gapEnd = inPool ? _regions[index].offset : target.bytes;
+    uintptr_t address = reinterpret_cast<uintptr_t>(target.base) + gapStart;
+    size_t offset = gapStart + (((address + mask) & ~mask) - address);
+    if (offset <= gapEnd && bytes <= gapEnd - offset) {
+      for (uint_fast8_t j = _regionCount; j > index; j--) {
+        _regions[j] = _regions[j - 1];
+      }
+      _regions[index] = {name, bytes, offset, (uint8_t)pool};
+      _regionCount++;
+      target.used += bytes;
+      if (offset + bytes > target.highWater) {
+        target.highWater = offset + bytes;
+      }
+      return target.base + offset;
+    }
+    if (!inPool) {
+      break;
+    }
+    gapStart = _regions[index].offset + _regions[index].bytes;
+  }
+  return nullptr;
+}
@@ -0,0 +1,108 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef MemoryArena_h /* Prevent loading library twice */
+#define MemoryArena_h
+
+#include "arduinoFFT.h"
+
+/* Most regions tracked by one MemoryArena */
+#ifndef ARENA_MAX_REGIONS
+#define ARENA_MAX_REGIONS 48
+#endif
+
+/* Most pools of one MemoryArena */
+#ifndef ARENA_MAX_POOLS
+#define ARENA_MAX_POOLS 6
+#endif
+
+// Where a pool lives, and where an allocation may be placed: only in internal
+// RAM or external RAM (PSRAM), or preferably in one and else in the other
+enum class ArenaPlacement {
+  Internal,
+  External,
+  PreferInternal,
+  PreferExternal
+};
+
+// One named allocation
+struct ArenaRegion {
+  const char *name; // Not copied, so usually a string literal
+  size_t bytes;
+  size_t offset; // From the start of its pool
+  uint8_t pool;
+};
+
+// Allocator over a few fixed pools of memory, e.g. a static array for the
+// buffers known at compile time and a block reserved at boot for the tables
+// built later. Each allocation is a named region at the first gap of the
+// first pool the placement allows that is large enough, aligned to a power
+// of two. Released regions leave gaps for later allocations, so memory stays
+// inside the pools however long the device runs, and the high-water mark of
+// each pool tells how large it must be. Not safe to use from several tasks
+// at once: callers on more than one task or core hold a lock around every
+// call, e.g. in the hooks they pass to fftSetAllocator().
+class MemoryArena {
+public:
+  MemoryArena(void *internal, size_t bytes);
+
+  bool addPool(void *base, size_t bytes, ArenaPlacement placement);
+  void *allocate(size_t bytes, const char *name,
+                 ArenaPlacement placement = ArenaPlacement::PreferInternal,
+                 size_t alignment = 8);
+  template <typename U>
+  U *allocate(size_t count, const char *name,
+              ArenaPlacement placement = ArenaPlacement::PreferInternal) {
+    return static_cast<U *>(allocate(count * sizeof(U), name, placement,
+                                     alignof(U) > 8 ? alignof(U) : 8));
+  }
+  size_t capacity(uint_fast8_t pool) const;
+  bool contains(const void *pointer) const;
+  uint32_t failures(void) const { return _failures; }
+  size_t highWater(uint_fast8_t pool) const;
+  ArenaPlacement placement(uint_fast8_t pool) const;
+  uint_fast8_t pools(void) const { return _poolCount; }
+  const ArenaRegion &region(uint_fast8_t index) const;
+  uint_fast8_t regions(void) const { return _regionCount; }
+  bool release(void *pointer);
+  size_t used(uint_fast8_t pool) const;
+
+private:
+  struct Pool {
+    uint8_t *base;
+    size_t bytes;
+    size_t highWater; // End of the highest region ever allocated
+    ArenaPlacement placement;
+    size_t used;
+  };
+  /* Variables */
+  uint32_t _failures = 0;
+  uint_fast8_t _poolCount = 0;
+  Pool _pools[ARENA_MAX_POOLS];
+  uint_fast8_t _regionCount = 0;
+  ArenaRegion _regions[ARENA_MAX_REGIONS]; // By pool, then by offset
+  /* Functions */
+  void *allocateIn(uint_fast8_t pool, size_t bytes, const char *name,
+                   size_t alignment);
+};
+
+#endif
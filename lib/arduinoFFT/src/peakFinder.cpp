@@ -0,0 +1,230 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "peakFinder.h"
+
+template <typename T>
+PeakFinder<T>::PeakFinder(uint_fast8_t maxPeaks, FFTPeakEstimator estimator)
+    : _estimator(estimator) {
+  setMaxPeaks(maxPeaks);
+}
+
+// Finds the strongest local maxima above threshold among bins magnitudes
+// (samples / 2 + 1 for a samples point transform of real input). binWidth is
+// the frequency step between bins, samplingFrequency / samples. Returns the
+// number of peaks found. Quinn's estimator needs the complex bins, so it falls
+// back to Jain's here.
+template <typename T>
+uint_fast8_t PeakFinder<T>::find(const T *vMagnitude, uint_fast16_t bins,
+                                 T binWidth, T threshold) {
+  _count = 0;
+  // A peak needs a neighbour on each side
+  for (uint_fast16_t i = 1; (i + 1) < bins; i++) {
+    T y = vMagnitude[i];
+    if ((y > threshold) && (y > vMagnitude[i - 1]) && (y >= vMagnitude[i + 1])) {
+      insert(i, y);
+    }
+  }
+  sort();
+  FFTPeakEstimator estimator = _estimator;
+  if (estimator == FFTPeakEstimator::Quinn) {
+    estimator = FFTPeakEstimator::Jain;
+  }
+  for (uint_fast8_t i = 0; i < _count; i++) {
+    uint_fast16_t bin = _peaks[i].bin;
+    T delta = interpolate(vMagnitude[bin - 1], vMagnitude[bin],
+                          vMagnitude[bin + 1], estimator,
+                          &_peaks[i].magnitude);
+    _peaks[i].frequency = (bin + delta) * binWidth;
+  }
+  return _count;
+}
+
+// Same as find(vMagnitude, ...) on the complex bins of compute(), before
+// complexToMagnitude(). Candidates are compared by power, so square roots are
+// only taken for the peaks returned. Where Quinn's estimate is more than a bin
+// off, Jain's is used instead.
+template <typename T>
+uint_fast8_t PeakFinder<T>::find(const T *vReal, const T *vImag,
+                                 uint_fast16_t bins, T binWidth, T threshold) {
+  _count = 0;
+  T powerThreshold = threshold > 0 ? sq(threshold) : 0;
+  T previous = sq(vReal[0]) + sq(vImag[0]);
+  T current = sq(vReal[1]) + sq(vImag[1]);
+  for (uint_fast16_t i = 1; (i + 1) < bins; i++) {
+    T next = sq(vReal[i + 1]) + sq(vImag[i + 1]);
+    if ((current > powerThreshold) && (current > previous) &&
+        (current >= next)) {
+      insert(i, current);
+    }
+    previous = current;
+    current = next;
+  }
+  sort();
+  for (uint_fast8_t i = 0; i < _count; i++) {
+    uint_fast16_t bin = _peaks[i].bin;
+    T y1 = sqrt(sq(vReal[bin - 1]) + sq(vImag[bin - 1]));
+    T y2 = sqrt(_peaks[i].magnitude);
+    T y3 = sqrt(sq(vReal[bin + 1]) + sq(vImag[bin + 1]));
+    T delta = 2.0;
+    if (_estimator == FFTPeakEstimator::Quinn) {
+      delta = interpolateQuinn(vReal, vImag, bin, &_peaks[i].magnitude);
+    }
+    // Quinn's estimator diverges on peaks that are not a single tone
+    if (!((delta >= -1.0) && (delta <= 1.0))) {
+      FFTPeakEstimator estimator = _estimator;
+      if (estimator == FFTPeakEstimator::Quinn) {
+        estimator = FFTPeakEstimator::Jain;
+      }
+      delta = interpolate(y1, y2, y3, estimator, &_peaks[i].magnitude);
+    }
+    _peaks[i].frequency = (bin + delta) * binWidth;
+  }
+  return _count;
+}
+
+// Limits the number of peaks find() returns, at most PEAK_FINDER_MAX_PEAKS
+template <typename T> void PeakFinder<T>::setMaxPeaks(uint_fast8_t maxPeaks) {
+  if (maxPeaks > PEAK_FINDER_MAX_PEAKS) {
+    maxPeaks = PEAK_FINDER_MAX_PEAKS;
+  }
+  _maxPeaks = maxPeaks;
+  _count = 0;
+}
+
+// Private functions
+
+// Magnitude of a rectangular-window peak delta bins away from the bin, from
+// the magnitude of the bin: the Dirichlet kernel is close to sinc(delta)
+template <typename T> T PeakFinder<T>::correct(T magnitude, T delta) const {
+  if (delta == 0) {
+    return magnitude;
+  }
+  T x = PI * delta;
+  return magnitude * x / sin(x);
+}
+
+// Keeps the maxPeaks largest levels seen, the smallest at the root
+template <typename T>
+void PeakFinder<T>::insert(uint_fast16_t bin, T level) {
+  if (_count < _maxPeaks) {
+    uint_fast8_t i = _count++;
+    while (i > 0) {
+      uint_fast8_t parent = (i - 1) >> 1;
+      if (_peaks[parent].magnitude <= level) {
+        break;
+      }
+      _peaks[i] = _peaks[parent];
+      i = parent;
+    }
+    _peaks[i].bin = bin;
+    _peaks[i].magnitude = level;
+  } else if ((_count > 0) && (level > _peaks[0].magnitude)) {
+    _peaks[0].bin = bin;
+    _peaks[0].magnitude = level;
+    siftDown(0, _count);
+  }
+}
+
+// Offset of the peak from the middle bin, in bins, from the magnitudes y1, y2
+// and y3 of three adjacent bins. Also writes the peak magnitude.
+template <typename T>
+T PeakFinder<T>::interpolate(T y1, T y2, T y3, FFTPeakEstimator estimator,
+                             T *magnitude) const {
+  T delta = 0;
+  if (estimator == FFTPeakEstimator::Jain) {
+    if (y1 > y3) {
+      T a = y2 / y1;
+      delta = a / (1.0 + a) - 1.0;
+    } else if (y2 > 0) {
+      T a = y3 / y2;
+      delta = a / (1.0 + a);
+    }
+    *magnitude = correct(y2, delta);
+    return delta;
+  }
+  T denominator = y1 - (2.0 * y2) + y3;
+  if (denominator != 0) {
+    delta = 0.5 * (y1 - y3) / denominator;
+  }
+  *magnitude = y2 - 0.25 * (y1 - y3) * delta;
+  return delta;
+}
+
+// Quinn's second estimator: the real parts of the ratios of each neighbour to
+// the peak bin give one offset estimate each, combined with the correction
+// function tau()
+template <typename T>
+T PeakFinder<T>::interpolateQuinn(const T *vReal, const T *vImag,
+                                  uint_fast16_t bin, T *magnitude) const {
+  T power = sq(vReal[bin]) + sq(vImag[bin]);
+  *magnitude = sqrt(power);
+  if (power == 0) {
+    return 0;
+  }
+  T am = (vReal[bin - 1] * vReal[bin] + vImag[bin - 1] * vImag[bin]) / power;
+  T ap = (vReal[bin + 1] * vReal[bin] + vImag[bin + 1] * vImag[bin]) / power;
+  T dm = am / (1.0 - am);
+  T dp = -ap / (1.0 - ap);
+  T delta = 0.5 * (dp + dm) + tau(dp * dp) - tau(dm * dm);
+  *magnitude = correct(*magnitude, delta);
+  return delta;
+}
+
+template <typename T>
+void PeakFinder<T>::siftDown(uint_fast8_t index, uint_fast8_t count) {
+  FFTPeak<T> peak = _peaks[index];
+  while (true) {
+    uint_fast8_t child = (index << 1) + 1;
+    if (child >= count) {
+      break;
+    }
+    if (((child + 1) < count) &&
+        (_peaks[child + 1].magnitude < _peaks[child].magnitude)) {
+      child++;
+    }
+    if (peak.magnitude <= _peaks[child].magnitude) {
+      break;
+    }
+    _peaks[index] = _peaks[child];
+    index = child;
+  }
+  _peaks[index] = peak;
+}
+
+// Heap sort of the min-heap, which leaves the peaks strongest first
+template <typename T> void PeakFinder<T>::sort(void) {
+  for (uint_fast8_t end = _count; end > 1; end--) {
+    FFTPeak<T> peak = _peaks[0];
+    _peaks[0] = _peaks[end - 1];
+    _peaks[end - 1] = peak;
+    siftDown(0, end - 1);
+  }
+}
+
+template <typename T> T PeakFinder<T>::tau(T x) const {
+  const T root = 0.8164965809; // sqrt(2 / 3)
+  return 0.25 * log(3.0 * x * x + 6.0 * x + 1.0) -
+         0.1020620726 * log((x + 1.0 - root) / (x + 1.0 + root)); // sqrt(6)/24
+}
+
+template class PeakFinder<double>;
+template class PeakFinder<float>;
@@ -0,0 +1,88 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PeakFinder_h /* Prevent loading library twice */
+#define PeakFinder_h
+
+#include "arduinoFFT.h"
+
+/* Number of peaks a PeakFinder can return */
+#ifndef PEAK_FINDER_MAX_PEAKS
+#define PEAK_FINDER_MAX_PEAKS 16
+#endif
+
+enum class FFTPeakEstimator {
+  Parabolic, // vertex of a parabola through the bin and its neighbours
+  Quinn,     // Quinn's second estimator, from the complex bins
+  Jain       // ratio of the bin and its larger neighbour
+};
+
+// One spectral peak: the bin of the local maximum and its interpolated
+// frequency and magnitude
+template <typename T> struct FFTPeak {
+  uint_fast16_t bin;
+  T frequency;
+  T magnitude;
+};
+
+// Finds the strongest local maxima of a spectrum in a single pass. The
+// candidates are kept in a min-heap of at most maxPeaks entries, so nothing is
+// allocated and only the peaks returned are interpolated. Peaks are returned
+// strongest first. Parabolic interpolation suits any window and any scale,
+// including dB; the Quinn and Jain estimators assume a rectangular window and
+// linear magnitudes, and correct the magnitude for the offset from the bin.
+template <typename T> class PeakFinder {
+public:
+  PeakFinder(uint_fast8_t maxPeaks = PEAK_FINDER_MAX_PEAKS,
+             FFTPeakEstimator estimator = FFTPeakEstimator::Parabolic);
+
+  FFTPeakEstimator estimator(void) const { return _estimator; }
+  uint_fast8_t find(const T *vMagnitude, uint_fast16_t bins, T binWidth,
+                    T threshold = 0);
+  uint_fast8_t find(const T *vReal, const T *vImag, uint_fast16_t bins,
+                    T binWidth, T threshold = 0);
+  uint_fast8_t maxPeaks(void) const { return _maxPeaks; }
+  const FFTPeak<T> &peak(uint_fast8_t index) const { return _peaks[index]; }
+  uint_fast8_t peaks(void) const { return _count; }
+  void setEstimator(FFTPeakEstimator estimator) { _estimator = estimator; }
+  void setMaxPeaks(uint_fast8_t maxPeaks);
+
+private:
+  /* Variables */
+  uint_fast8_t _count = 0;
+  FFTPeakEstimator _estimator;
+  uint_fast8_t _maxPeaks;
+  FFTPeak<T> _peaks[PEAK_FINDER_MAX_PEAKS]; // Min-heap on magnitude while
+                                            // searching
+  /* Functions */
+  void insert(uint_fast16_t bin, T level);
+  T correct(T magnitude, T delta) const;
+  T interpolate(T y1, T y2, T y3, FFTPeakEstimator estimator,
+                T *magnitude) const;
+  T interpolateQuinn(const T *vReal, const T *vImag, uint_fast16_t bin,
+                     T *magnitude) const;
+  void siftDown(uint_fast8_t index, uint_fast8_t count);
+  void sort(void);
+  T tau(T x) const;
+};
+
+#endif
@@ -0,0 +1,116 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "periodEstimator.h"
+
+template <typename T>
+PeriodEstimator<T>::PeriodEstimator(T minFrequency, T maxFrequency,
+                                    T threshold, T minConfidence)
+    : _minConfidence(minConfidence), _threshold(threshold) {
+  setRange(minFrequency, maxFrequency);
+}
+
+// Searches vAutocorrelation, lags 0 to lags - 1 of the autocorrelation of
+// length samples, for the fundamental period between 1 / maxFrequency and
+// 1 / minFrequency. Returns false, with a confidence of 0, if there is no
+// peak in that range. Returns false with the peak's confidence, but no lag,
+// if that is below the minimum confidence.
+template <typename T>
+bool PeriodEstimator<T>::estimate(const T *vAutocorrelation,
+                                  uint_fast16_t lags, uint_fast16_t length,
+                                  T samplingFrequency) {
+  _samplingFrequency = samplingFrequency;
+  _lag = 0;
+  _confidence = 0;
+  if ((vAutocorrelation[0] <= 0) || (lags < 3) || (length < 3)) {
+    return false;
+  }
+  // A peak needs a neighbour on each side
+  uint_fast16_t first = ceil(samplingFrequency / _maxFrequency);
+  uint_fast16_t last = floor(samplingFrequency / _minFrequency);
+  if (first < 1) {
+    first = 1;
+  }
+  if ((last + 2) > lags) {
+    last = lags - 2;
+  }
+  if ((last + 2) > length) {
+    last = length - 2;
+  }
+  // Skip the lobe around lag 0, where the signal still resembles itself
+  while ((first <= last) && (vAutocorrelation[first] > 0)) {
+    first++;
+  }
+  // Two passes: the best peak in range, then the first one close to it
+  T scale = length / vAutocorrelation[0];
+  T best = 0;
+  for (uint_fast8_t pass = 0; pass < 2; pass++) {
+    for (uint_fast16_t l = first; l <= last; l++) {
+      T y1 = vAutocorrelation[l - 1] * scale / (length - l + 1);
+      T y2 = vAutocorrelation[l] * scale / (length - l);
+      T y3 = vAutocorrelation[l + 1] * scale / (length - l - 1);
+      if ((y2 <= y1) || (y2 < y3)) {
+        continue;
+      }
+      if (pass == 0) {
+        if (y2 > best) {
+          best = y2;
+        }
+      } else if (y2 >= (_threshold * best)) {
+        T denominator = y1 - 2 * y2 + y3;
+        T delta = denominator < 0 ? 0.5 * (y1 - y3) / denominator : 0;
+        _lag = l + delta;
+        _confidence = y2 - 0.25 * (y1 - y3) * delta;
+        if (_confidence > 1) {
+          _confidence = 1;
+        }
+        if (_confidence < _minConfidence) {
+          _lag = 0;
+          return false;
+        }
+        return true;
+      }
+    }
+    if (best <= 0) {
+      return false;
+    }
+  }
+  return false;
+}
+
+// Fundamental frequency of the last estimate, 0 if it failed
+template <typename T> T PeriodEstimator<T>::frequency(void) const {
+  return _lag > 0 ? _samplingFrequency / _lag : 0;
+}
+
+// Fundamental period of the last estimate in seconds, 0 if it failed
+template <typename T> T PeriodEstimator<T>::period(void) const {
+  return _samplingFrequency > 0 ? _lag / _samplingFrequency : 0;
+}
+
+template <typename T>
+void PeriodEstimator<T>::setRange(T minFrequency, T maxFrequency) {
+  _minFrequency = minFrequency;
+  _maxFrequency = maxFrequency;
+}
+
+template class PeriodEstimator<double>;
+template class PeriodEstimator<float>;
@@ -0,0 +1,67 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PeriodEstimator_h /* Prevent loading library twice */
+#define PeriodEstimator_h
+
+#include "arduinoFFT.h"
+
+// Estimates the fundamental period of a signal, such as a heart beat or a
+// pitch, from its autocorrelation, e.g. from ArduinoFFT<T>::autocorrelate().
+// Lags are normalized by lag 0 and by the number of overlapping samples, so a
+// perfectly periodic signal scores 1 at every multiple of its period. Past
+// the first zero crossing, the first local maximum within threshold of the
+// best one in the frequency range is taken as the fundamental, so twice the
+// period is not reported, and refined with a parabola through its neighbours.
+// The normalized height of that peak is the confidence. Peaks below
+// minConfidence, as left by noise or baseline artifacts, are not reported.
+template <typename T> class PeriodEstimator {
+public:
+  PeriodEstimator(T minFrequency, T maxFrequency, T threshold = 0.9,
+                  T minConfidence = 0.25);
+
+  T confidence(void) const { return _confidence; }
+  bool estimate(const T *vAutocorrelation, uint_fast16_t lags,
+                uint_fast16_t length, T samplingFrequency);
+  T frequency(void) const;
+  T lag(void) const { return _lag; }
+  T maxFrequency(void) const { return _maxFrequency; }
+  T minConfidence(void) const { return _minConfidence; }
+  T minFrequency(void) const { return _minFrequency; }
+  T period(void) const;
+  void setMinConfidence(T minConfidence) { _minConfidence = minConfidence; }
+  void setRange(T minFrequency, T maxFrequency);
+  void setThreshold(T threshold) { _threshold = threshold; }
+  T threshold(void) const { return _threshold; }
+
+private:
+  /* Variables */
+  T _confidence = 0;
+  T _lag = 0;
+  T _maxFrequency;
+  T _minConfidence;
+  T _minFrequency;
+  T _samplingFrequency = 0;
+  T _threshold;
+};
+
+#endif
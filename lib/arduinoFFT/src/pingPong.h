@@ -0,0 +1,125 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PingPong_h /* Prevent loading library twice */
+#define PingPong_h
+
+#include "arduinoFFT.h"
+
+// Double buffer between a producer that fills frames (a sampling task) and a
+// consumer that processes them (a transform and display loop), usually on the
+// other core or thread. Each of the two caller-provided frames carries an
+// ownership flag that is handed over with atomic operations, no locks: while
+// the consumer works on one frame, the producer fills the other. The consumer
+// always gets the newest complete frame. If it is still busy when a second
+// frame completes, the older unread one is reused and counted as dropped. T
+// is the frame type, for example a struct of the samples and their mean.
+template <typename T> class PingPong {
+public:
+  PingPong(T *frame0, T *frame1) : _frames{frame0, frame1} {}
+
+  // Producer: a frame to fill. Never fails; if the consumer holds one frame
+  // and the other is unread, that one is taken back and dropped.
+  T *acquire(void) {
+    while (true) {
+      for (uint_fast8_t i = 0; i < 2; i++) {
+        if (exchange(i, Free, Filling)) {
+          return _frames[i];
+        }
+      }
+      for (uint_fast8_t i = 0; i < 2; i++) {
+        if (exchange(i, Ready, Filling)) {
+          __atomic_fetch_add(&_dropped, 1, __ATOMIC_RELAXED);
+          return _frames[i];
+        }
+      }
+    }
+  }
+
+  // Frees an unread frame, for example after a change of the input stream.
+  // Frames held by either side are not affected.
+  void discard(void) {
+    for (uint_fast8_t i = 0; i < 2; i++) {
+      exchange(i, Ready, Free);
+    }
+  }
+
+  // Number of completed frames the consumer never took
+  uint32_t dropped(void) const {
+    return __atomic_load_n(&_dropped, __ATOMIC_RELAXED);
+  }
+
+  // Number of frames published so far
+  uint32_t published(void) const {
+    return __atomic_load_n(&_published, __ATOMIC_RELAXED);
+  }
+
+  // Producer: hands a filled frame from acquire() to the consumer. An older
+  // frame still unread is dropped, so only the newest one is ever waiting.
+  void publish(T *frame) {
+    uint_fast8_t i = (frame == _frames[0]) ? 0 : 1;
+    if (exchange(1 - i, Ready, Free)) {
+      __atomic_fetch_add(&_dropped, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&_published, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&_state[i], Ready, __ATOMIC_RELEASE);
+  }
+
+  bool ready(void) const {
+    return (__atomic_load_n(&_state[0], __ATOMIC_ACQUIRE) == Ready) ||
+           (__atomic_load_n(&_state[1], __ATOMIC_ACQUIRE) == Ready);
+  }
+
+  // Consumer: returns a frame from take() to the producer
+  void release(T *frame) {
+    uint_fast8_t i = (frame == _frames[0]) ? 0 : 1;
+    __atomic_store_n(&_state[i], Free, __ATOMIC_RELEASE);
+  }
+
+  // Consumer: the newest complete frame, or a null pointer if there is none
+  // yet. It belongs to the consumer until release(), so call that before the
+  // next take().
+  T *take(void) {
+    for (uint_fast8_t i = 0; i < 2; i++) {
+      if (exchange(i, Ready, Busy)) {
+        return _frames[i];
+      }
+    }
+    return nullptr;
+  }
+
+private:
+  /* Variables */
+  enum : uint32_t { Free, Filling, Ready, Busy }; // Owner of each frame
+  uint32_t _dropped = 0;
+  T *_frames[2];
+  uint32_t _published = 0;
+  uint32_t _state[2] = {Free, Free};
+  /* Functions */
+  // Moves frame i from one state to another if it is in the first one
+  bool exchange(uint_fast8_t i, uint32_t from, uint32_t to) {
+    return __atomic_compare_exchange_n(&_state[i], &from, to, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+  }
+};
+
+#endif
@@ -0,0 +1,376 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef StaticFFT_h /* Prevent loading library twice */
+#define StaticFFT_h
+
+#include "arduinoFFT.h"
+
+#if __cplusplus < 201703L
+#error "StaticFFT requires C++17 (build with -std=gnu++17)"
+#endif
+
+// Compile time sine and cosine for table generation. The argument is reduced
+// to [-pi/2, pi/2] where 13 Taylor terms are exact to double precision.
+constexpr double staticSin(double x) {
+  const double pi = 3.14159265358979323846;
+  while (x > pi)
+    x -= 2.0 * pi;
+  while (x < -pi)
+    x += 2.0 * pi;
+  if (x > pi / 2.0)
+    x = pi - x;
+  if (x < -pi / 2.0)
+    x = -pi - x;
+  double term = x;
+  double sum = x;
+  for (int n = 1; n <= 12; n++) {
+    term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double staticCos(double x) {
+  return staticSin(x + 3.14159265358979323846 / 2.0);
+}
+
+// Same definitions as ArduinoFFT<T>::weighingFactor()
+constexpr double staticWeighingFactor(FFTWindow windowType, uint_fast16_t i,
+                                      uint_fast16_t samples) {
+  double samplesMinusOne = samples - 1.0;
+  double indexMinusOne = i;
+  double ratio = indexMinusOne / samplesMinusOne;
+  double distance = indexMinusOne - (samplesMinusOne / 2.0);
+  switch (windowType) {
+  case FFTWindow::Hamming:
+    return 0.54 - (0.46 * staticCos(twoPi * ratio));
+  case FFTWindow::Hann:
+    return 0.54 * (1.0 - staticCos(twoPi * ratio));
+  case FFTWindow::Triangle:
+    return 1.0 - ((2.0 * (distance < 0 ? -distance : distance)) /
+                  samplesMinusOne);
+  case FFTWindow::Nuttall:
+    return 0.355768 - (0.487396 * (staticCos(twoPi * ratio))) +
+           (0.144232 * (staticCos(fourPi * ratio))) -
+           (0.012604 * (staticCos(sixPi * ratio)));
+  case FFTWindow::Blackman:
+    return 0.42323 - (0.49755 * (staticCos(twoPi * ratio))) +
+           (0.07922 * (staticCos(fourPi * ratio)));
+  case FFTWindow::Blackman_Nuttall:
+    return 0.3635819 - (0.4891775 * (staticCos(twoPi * ratio))) +
+           (0.1365995 * (staticCos(fourPi * ratio))) -
+           (0.0106411 * (staticCos(sixPi * ratio)));
+  case FFTWindow::Blackman_Harris:
+    return 0.35875 - (0.48829 * (staticCos(twoPi * ratio))) +
+           (0.14128 * (staticCos(fourPi * ratio))) -
+           (0.01168 * (staticCos(sixPi * ratio)));
+  case FFTWindow::Flat_top:
+    return 0.2810639 - (0.5208972 * staticCos(twoPi * ratio)) +
+           (0.1980399 * staticCos(fourPi * ratio));
+  case FFTWindow::Welch:
+    return 1.0 - (distance / (samplesMinusOne / 2.0)) *
+                     (distance / (samplesMinusOne / 2.0));
+  default:
+    return 1.0;
+  }
+}
+
+// Forward twiddle factors, bit reversal permutation and window factors for one
+// transform size, generated by the compiler
+template <typename T, uint_fast16_t N, FFTWindow Window>
+struct StaticFFTTables {
+  T cosTable[N / 2];
+  T sinTable[N / 2];
+  T window[N / 2];
+  uint16_t bitReverse[N];
+
+  constexpr StaticFFTTables()
+      : cosTable(), sinTable(), window(), bitReverse() {
+    uint_fast8_t power = 0;
+    while ((N >> power) > 1)
+      power++;
+    for (uint_fast16_t i = 0; i < N; i++) {
+      uint_fast16_t r = 0;
+      for (uint_fast8_t b = 0; b < power; b++) {
+        r |= ((i >> b) & 1) << (power - 1 - b);
+      }
+      bitReverse[i] = r;
+    }
+    for (uint_fast16_t k = 0; k < N / 2; k++) {
+      double angle = (6.28318530717958647692 * k) / N;
+      cosTable[k] = staticCos(angle);
+      sinTable[k] = -staticSin(angle);
+      window[k] = staticWeighingFactor(Window, k, N);
+    }
+  }
+};
+
+// FFT of a size fixed at compile time. All tables live in flash, and every
+// stage is a separate instantiation with constant trip counts and strides.
+// The interface mirrors ArduinoFFT, with the window type fixed as well.
+template <typename T, uint_fast16_t N, FFTWindow Window = FFTWindow::Hamming>
+class StaticFFT {
+  static_assert(N >= 4 && (N & (N - 1)) == 0,
+                "StaticFFT size must be a power of 2");
+
+public:
+  // Same as ArduinoFFT<T>::autocorrelate() of the first N / 2 values
+  static void autocorrelate(T *vData) {
+    constexpr uint_fast16_t half = N / 2;
+    constexpr T scale = T(1.0) / N;
+    T mean = 0;
+    for (uint_fast16_t i = 0; i < half; i++) {
+      mean += vData[i];
+    }
+    mean *= T(1.0) / half;
+    for (uint_fast16_t i = 0; i < half; i++) {
+      vData[i] -= mean;
+      vData[half + i] = 0;
+    }
+    computeReal(vData);
+    vData[0] = sq(vData[0]) * scale;
+    vData[half] = sq(vData[half]) * scale;
+    for (uint_fast16_t k = 1; k < half / 2; k++) {
+      uint_fast16_t m = half - k;
+      T powerK = (sq(vData[k]) + sq(vData[half + k])) * scale;
+      T powerM = (sq(vData[m]) + sq(vData[half + m])) * scale;
+      vData[k] = powerK;
+      vData[half + m] = powerK;
+      vData[m] = powerM;
+      vData[half + k] = powerM;
+    }
+    T power = (sq(vData[half / 2]) + sq(vData[half + half / 2])) * scale;
+    vData[half / 2] = power;
+    vData[half + half / 2] = power;
+    computeReal(vData);
+  }
+
+  static void complexToMagnitude(T *vReal, T *vImag) {
+    for (uint_fast16_t i = 0; i < N; i++) {
+      vReal[i] = sqrt_internal(sq(vReal[i]) + sq(vImag[i]));
+    }
+  }
+
+  template <FFTDirection Dir> static void compute(T *vReal, T *vImag) {
+    bitReverse<N>(vReal, vImag);
+    butterflies<N, Dir>(vReal, vImag);
+    if constexpr (Dir == FFTDirection::Reverse) {
+      constexpr T oneOverSamples = T(1.0) / N;
+      for (uint_fast16_t i = 0; i < N; i++) {
+        vReal[i] *= oneOverSamples;
+        vImag[i] *= oneOverSamples;
+      }
+    }
+  }
+
+  static void compute(T *vReal, T *vImag, FFTDirection dir) {
+    if (dir == FFTDirection::Forward) {
+      compute<FFTDirection::Forward>(vReal, vImag);
+    } else {
+      compute<FFTDirection::Reverse>(vReal, vImag);
+    }
+  }
+
+  // Same output layout as ArduinoFFT<T>::computeReal()
+  static void computeReal(T *vData, bool prepared = false) {
+    constexpr uint_fast16_t half = N / 2;
+    T *vImag = vData + half;
+    if (!prepared) {
+      bitReverse<N>(vData, nullptr);
+    }
+    butterflies<half, FFTDirection::Forward>(vData, vImag);
+    T zr = vData[0];
+    T zi = vImag[0];
+    vData[0] = zr + zi;
+    vImag[0] = zr - zi;
+    for (uint_fast16_t k = 1; k < half / 2; k++) {
+      uint_fast16_t m = half - k;
+      T wr = _tables.cosTable[k];
+      T wi = _tables.sinTable[k];
+      T er = 0.5 * (vData[k] + vData[m]);
+      T ei = 0.5 * (vImag[k] - vImag[m]);
+      T or_ = 0.5 * (vImag[k] + vImag[m]);
+      T oi = 0.5 * (vData[m] - vData[k]);
+      T tr = wr * or_ - wi * oi;
+      T ti = wr * oi + wi * or_;
+      vData[k] = er + tr;
+      vImag[k] = ei + ti;
+      vData[m] = er - tr;
+      vImag[m] = ti - ei;
+    }
+    vImag[half / 2] = -vImag[half / 2];
+  }
+
+  static void dcRemoval(T *vData) {
+    T mean = 0;
+    for (uint_fast16_t i = 0; i < N; i++) {
+      mean += vData[i];
+    }
+    mean *= T(1.0) / N;
+    for (uint_fast16_t i = 0; i < N; i++) {
+      vData[i] -= mean;
+    }
+  }
+
+  // Mean removal, windowing and bit reversal in one pass, see
+  // ArduinoFFT<T>::prepare(). Follow with computeReal(vData, true).
+  static void prepare(T *vData, T mean) {
+    for (uint_fast16_t i = 0; i < N; i++) {
+      uint_fast16_t j = _tables.bitReverse[i];
+      if (i <= j) {
+        T factorI = _tables.window[i < N / 2 ? i : N - 1 - i];
+        T factorJ = _tables.window[j < N / 2 ? j : N - 1 - j];
+        T value = vData[i];
+        vData[i] = (vData[j] - mean) * factorJ;
+        vData[j] = (value - mean) * factorI;
+      }
+    }
+  }
+
+  static void realToMagnitude(T *vData) {
+    constexpr uint_fast16_t half = N / 2;
+    T nyquist = vData[half];
+    vData[0] = sqrt_internal(sq(vData[0]));
+    for (uint_fast16_t i = 1; i < half; i++) {
+      vData[i] = sqrt_internal(sq(vData[i]) + sq(vData[half + i]));
+    }
+    vData[half] = sqrt_internal(sq(nyquist));
+  }
+
+  static void windowing(T *vData) {
+    for (uint_fast16_t i = 0; i < N / 2; i++) {
+      vData[i] *= _tables.window[i];
+      vData[N - (i + 1)] *= _tables.window[i];
+    }
+  }
+
+private:
+  static constexpr StaticFFTTables<T, N, Window> _tables{};
+
+  static constexpr uint_fast8_t exponent(uint_fast16_t value) {
+    uint_fast8_t result = 0;
+    while (value >>= 1)
+      result++;
+    return result;
+  }
+
+  // vImag may be a null pointer if the imaginary part is known to be zero
+  template <uint_fast16_t M> static void bitReverse(T *vReal, T *vImag) {
+    for (uint_fast16_t i = 1; i < M - 1; i++) {
+      uint_fast16_t j = _tables.bitReverse[i] >> exponent(N / M);
+      if (i < j) {
+        T temp = vReal[i];
+        vReal[i] = vReal[j];
+        vReal[j] = temp;
+        if (vImag) {
+          temp = vImag[i];
+          vImag[i] = vImag[j];
+          vImag[j] = temp;
+        }
+      }
+    }
+  }
+
+  // Radix-4 butterflies with a leading radix-2 stage for odd powers, see
+  // ArduinoFFT<T>::butterfliesRadix4()
+  template <uint_fast16_t M, FFTDirection Dir>
+  static void butterflies(T *vReal, T *vImag) {
+    if constexpr (exponent(M) & 1) {
+      for (uint_fast16_t i = 0; i < M; i += 2) {
+        T tr = vReal[i + 1];
+        T ti = vImag[i + 1];
+        vReal[i + 1] = vReal[i] - tr;
+        vImag[i + 1] = vImag[i] - ti;
+        vReal[i] += tr;
+        vImag[i] += ti;
+      }
+      radix4Stage<M, 2, Dir>(vReal, vImag);
+    } else {
+      radix4Stage<M, 1, Dir>(vReal, vImag);
+    }
+  }
+
+  template <uint_fast16_t M, uint_fast16_t L1, FFTDirection Dir>
+  static void radix4Stage(T *vReal, T *vImag) {
+    if constexpr (L1 < M) {
+      constexpr uint_fast16_t l4 = L1 << 2;
+      constexpr uint_fast16_t step = N / l4;
+      for (uint_fast16_t j = 0; j < L1; j++) {
+        uint_fast16_t k = j * step;
+        T w2r = _tables.cosTable[k];
+        T w2i = _tables.sinTable[k];
+        T w1r = _tables.cosTable[k << 1];
+        T w1i = _tables.sinTable[k << 1];
+        T w3r, w3i;
+        if (3 * k < N / 2) {
+          w3r = _tables.cosTable[3 * k];
+          w3i = _tables.sinTable[3 * k];
+        } else {
+          w3r = -_tables.cosTable[3 * k - N / 2];
+          w3i = -_tables.sinTable[3 * k - N / 2];
+        }
+        if constexpr (Dir == FFTDirection::Reverse) {
+          w1i = -w1i;
+          w2i = -w2i;
+          w3i = -w3i;
+        }
+        for (uint_fast16_t i = j; i < M; i += l4) {
+          uint_fast16_t i1 = i + L1;
+          uint_fast16_t i2 = i1 + L1;
+          uint_fast16_t i3 = i2 + L1;
+          T t1r = w1r * vReal[i1] - w1i * vImag[i1];
+          T t1i = w1r * vImag[i1] + w1i * vReal[i1];
+          T t2r = w2r * vReal[i2] - w2i * vImag[i2];
+          T t2i = w2r * vImag[i2] + w2i * vReal[i2];
+          T t3r = w3r * vReal[i3] - w3i * vImag[i3];
+          T t3i = w3r * vImag[i3] + w3i * vReal[i3];
+          T s0r = vReal[i] + t1r;
+          T s0i = vImag[i] + t1i;
+          T d0r = vReal[i] - t1r;
+          T d0i = vImag[i] - t1i;
+          T s1r = t2r + t3r;
+          T s1i = t2i + t3i;
+          T d1r, d1i;
+          if constexpr (Dir == FFTDirection::Forward) {
+            d1r = t2i - t3i;
+            d1i = t3r - t2r;
+          } else {
+            d1r = t3i - t2i;
+            d1i = t2r - t3r;
+          }
+          vReal[i] = s0r + s1r;
+          vImag[i] = s0i + s1i;
+          vReal[i1] = d0r + d1r;
+          vImag[i1] = d0i + d1i;
+          vReal[i2] = s0r - s1r;
+          vImag[i2] = s0i - s1i;
+          vReal[i3] = d0r - d1r;
+          vImag[i3] = d0i - d1i;
+        }
+      }
+      radix4Stage<M, l4, Dir>(vReal, vImag);
+    }
+  }
+};
+
+#endif
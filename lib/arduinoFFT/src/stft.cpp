@@ -0,0 +1,164 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "stft.h"
+
+// Positions count samples since construction and wrap around at 2^32. The
+// producer publishes a sample by advancing _write after storing it, and the
+// consumer releases ring space by advancing _read after copying a frame out.
+
+template <typename T>
+STFT<T>::STFT(T *ring, uint_fast16_t ringSize, uint_fast16_t frameSize,
+              uint_fast16_t hop)
+    : _frameSize(frameSize), _mask(ringSize - 1), _ring(ring) {
+  setHop(hop);
+}
+
+// Number of unread samples
+template <typename T> uint_fast16_t STFT<T>::available(void) const {
+  return __atomic_load_n(&_write, __ATOMIC_ACQUIRE) -
+         __atomic_load_n(&_read, __ATOMIC_RELAXED);
+}
+
+// Drops all buffered samples, so the next frame starts with the next sample
+// pushed. Must be called from the consumer side.
+template <typename T> void STFT<T>::discard(void) {
+  __atomic_store_n(&_read, __atomic_load_n(&_write, __ATOMIC_ACQUIRE),
+                   __ATOMIC_RELEASE);
+}
+
+template <typename T> bool STFT<T>::frameReady(void) const {
+  return available() >= _frameSize;
+}
+
+// Copies the oldest complete frame to vData and advances to the next frame by
+// the hop size. Returns false if no complete frame is buffered yet.
+template <typename T> bool STFT<T>::nextFrame(T *vData) {
+  if (!frameReady()) {
+    return false;
+  }
+  uint32_t read = __atomic_load_n(&_read, __ATOMIC_RELAXED);
+  for (uint_fast16_t i = 0; i < _frameSize; i++) {
+    vData[i] = _ring[(read + i) & _mask];
+  }
+  __atomic_store_n(&_read, read + _hop, __ATOMIC_RELEASE);
+  return true;
+}
+
+// Same as nextFrame(vData), also returning the mean of the frame, summed while
+// copying it. Pass it to ArduinoFFT<T>::prepare() instead of calling
+// dcRemoval().
+template <typename T> bool STFT<T>::nextFrame(T *vData, T *mean) {
+  if (!frameReady()) {
+    return false;
+  }
+  uint32_t read = __atomic_load_n(&_read, __ATOMIC_RELAXED);
+  T sum = 0;
+  for (uint_fast16_t i = 0; i < _frameSize; i++) {
+    T sample = _ring[(read + i) & _mask];
+    vData[i] = sample;
+    sum += sample;
+  }
+  __atomic_store_n(&_read, read + _hop, __ATOMIC_RELEASE);
+  *mean = sum / _frameSize;
+  return true;
+}
+
+// Number of samples dropped because the ring buffer was full
+template <typename T> uint32_t STFT<T>::overruns(void) const {
+  return __atomic_load_n(&_overruns, __ATOMIC_RELAXED);
+}
+
+// Copies the next count unread samples without consuming them. Right after
+// nextFrame() these are the last frameSize - hop samples of that frame, still
+// in the ring buffer. Returns false if fewer than count samples are there.
+template <typename T>
+bool STFT<T>::peek(T *vData, uint_fast16_t count) const {
+  if (available() < count) {
+    return false;
+  }
+  uint32_t read = __atomic_load_n(&_read, __ATOMIC_RELAXED);
+  for (uint_fast16_t i = 0; i < count; i++) {
+    vData[i] = _ring[(read + i) & _mask];
+  }
+  return true;
+}
+
+// Appends a sample. Returns false and drops it if the ring buffer is full.
+template <typename T> bool STFT<T>::push(T sample) {
+  uint32_t write = __atomic_load_n(&_write, __ATOMIC_RELAXED);
+  if (write - __atomic_load_n(&_read, __ATOMIC_ACQUIRE) > _mask) {
+    __atomic_store_n(&_overruns, _overruns + 1, __ATOMIC_RELAXED);
+    return false;
+  }
+  _ring[write & _mask] = sample;
+  __atomic_store_n(&_write, write + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+// Appends count samples at once, for example both parts of a complex value,
+// so the consumer never sees only some of them. Returns false and drops all
+// of them if they don't fit.
+template <typename T>
+bool STFT<T>::push(const T *samples, uint_fast16_t count) {
+  uint32_t write = __atomic_load_n(&_write, __ATOMIC_RELAXED);
+  if (write - __atomic_load_n(&_read, __ATOMIC_ACQUIRE) + count > _mask + 1) {
+    __atomic_store_n(&_overruns, _overruns + count, __ATOMIC_RELAXED);
+    return false;
+  }
+  for (uint_fast16_t i = 0; i < count; i++) {
+    _ring[(write + i) & _mask] = samples[i];
+  }
+  __atomic_store_n(&_write, write + count, __ATOMIC_RELEASE);
+  return true;
+}
+
+// Number of samples pushed so far
+template <typename T> uint32_t STFT<T>::samples(void) const {
+  return __atomic_load_n(&_write, __ATOMIC_ACQUIRE);
+}
+
+// Sets the frame length, at most the ring size, and keeps the hop within it.
+// Together with setHop() and discard() this switches the stream to another
+// frame size without a new ring buffer. Must be called from the consumer side.
+template <typename T> void STFT<T>::setFrameSize(uint_fast16_t frameSize) {
+  if (frameSize < 1) {
+    frameSize = 1;
+  } else if (frameSize > _mask + 1) {
+    frameSize = _mask + 1;
+  }
+  _frameSize = frameSize;
+  setHop(_hop);
+}
+
+// Sets the frame advance, for example frameSize / 2 for 50 % or frameSize / 4
+// for 75 % overlap. Must be called from the consumer side.
+template <typename T> void STFT<T>::setHop(uint_fast16_t hop) {
+  if (hop < 1) {
+    hop = 1;
+  } else if (hop > _frameSize) {
+    hop = _frameSize;
+  }
+  _hop = hop;
+}
+
+template class STFT<double>;
+template class STFT<float>;
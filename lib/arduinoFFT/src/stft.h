@@ -0,0 +1,66 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef STFT_h /* Prevent loading library twice */
+#define STFT_h
+
+#include "arduinoFFT.h"
+
+// Streaming front end for a short-time Fourier transform. Samples are pushed
+// one at a time into a ring buffer, and frames of frameSize samples are read
+// out, each starting hop samples after the previous one. Acquisition never
+// has to stop for a transform: one producer (a sampling task or interrupt)
+// and one consumer may use the buffer concurrently without locks. The ring
+// size must be a power of two of at least frameSize samples; every sample
+// beyond frameSize is room for the producer while the consumer is busy.
+template <typename T> class STFT {
+public:
+  STFT(T *ring, uint_fast16_t ringSize, uint_fast16_t frameSize,
+       uint_fast16_t hop);
+
+  uint_fast16_t available(void) const;
+  void discard(void);
+  uint_fast16_t frameSize(void) const { return _frameSize; }
+  bool frameReady(void) const;
+  uint_fast16_t hop(void) const { return _hop; }
+  bool nextFrame(T *vData);
+  bool nextFrame(T *vData, T *mean);
+  uint32_t overruns(void) const;
+  bool peek(T *vData, uint_fast16_t count) const;
+  bool push(T sample);
+  bool push(const T *samples, uint_fast16_t count);
+  uint32_t samples(void) const;
+  void setFrameSize(uint_fast16_t frameSize);
+  void setHop(uint_fast16_t hop);
+
+private:
+  /* Variables */
+  uint_fast16_t _frameSize;
+  uint_fast16_t _hop;
+  uint_fast16_t _mask;
+  uint32_t _overruns = 0; // Written by the producer only
+  uint32_t _read = 0;     // Written by the consumer only
+  T *_ring;
+  uint32_t _write = 0; // Written by the producer only
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "welchPSD.h"
+
+template <typename T>
+WelchPSD<T>::WelchPSD(T *vAccumulator, uint_fast16_t bins,
+                      FFTAveraging averaging, uint_fast16_t frames, T alpha)
+    : _bins(bins), _vAccumulator(vAccumulator) {
+  setAveraging(averaging, frames, alpha);
+}
+
+// Adds the power spectrum of a complex spectrum, of which the first bins
+// values are used
+template <typename T> void WelchPSD<T>::add(const T *vReal, const T *vImag) {
+  T weight = nextWeight();
+  for (uint_fast16_t i = 0; i < _bins; i++) {
+    T power = sq(vReal[i]) + sq(vImag[i]);
+    _vAccumulator[i] += weight * (power - _vAccumulator[i]);
+  }
+}
+
+// Adds the power spectrum of the packed output of computeReal()
+template <typename T> void WelchPSD<T>::addReal(const T *vData) {
+  T weight = nextWeight();
+  uint_fast16_t half = _bins - 1;
+  _vAccumulator[0] += weight * (sq(vData[0]) - _vAccumulator[0]);
+  for (uint_fast16_t i = 1; i < half; i++) {
+    T power = sq(vData[i]) + sq(vData[half + i]);
+    _vAccumulator[i] += weight * (power - _vAccumulator[i]);
+  }
+  _vAccumulator[half] += weight * (sq(vData[half]) - _vAccumulator[half]);
+}
+
+// Writes the one-sided power spectral density in units^2 / Hz to vData.
+// windowPower is the sum of the squared window weights of one frame.
+template <typename T>
+void WelchPSD<T>::density(T *vData, T samplingFrequency,
+                          T windowPower) const {
+  T scale = 1.0 / (samplingFrequency * windowPower);
+  // DC and Nyquist have no mirrored negative frequency bin
+  vData[0] = _vAccumulator[0] * scale;
+  for (uint_fast16_t i = 1; i < (_bins - 1); i++) {
+    vData[i] = _vAccumulator[i] * 2.0 * scale;
+  }
+  vData[_bins - 1] = _vAccumulator[_bins - 1] * scale;
+}
+
+// Writes the averaged magnitude spectrum, the square root of the averaged
+// power, to vData. This is on the scale of complexToMagnitude().
+template <typename T> void WelchPSD<T>::magnitude(T *vData) const {
+  for (uint_fast16_t i = 0; i < _bins; i++) {
+    vData[i] = sqrt(_vAccumulator[i]);
+  }
+}
+
+// True once a linear average covers all its frames, or an exponential
+// average has seen a frame
+template <typename T> bool WelchPSD<T>::ready(void) const {
+  if (_averaging == FFTAveraging::Linear) {
+    return _count >= _frames;
+  }
+  return _count > 0;
+}
+
+// Linear averaging restarts after frames frames; exponential averaging
+// weighs each new frame by alpha. Restarts the average.
+template <typename T>
+void WelchPSD<T>::setAveraging(FFTAveraging averaging, uint_fast16_t frames,
+                               T alpha) {
+  _averaging = averaging;
+  _frames = frames ? frames : 1;
+  _alpha = alpha;
+  _count = 0;
+}
+
+// Averages bins values from now on, for example after the frame size of the
+// stream changed. The accumulator must hold that many. Restarts the average.
+template <typename T> void WelchPSD<T>::setBins(uint_fast16_t bins) {
+  _bins = bins;
+  _count = 0;
+}
+
+// Writes the averaged spectrum to vData on the given scale, multiplied by
+// gain, see ArduinoFFT<T>::powerToSpectrum(). No square root is taken for
+// FFTScale::Power or FFTScale::Decibel.
+template <typename T>
+void WelchPSD<T>::spectrum(T *vData, FFTScale scale, T gain) const {
+  ArduinoFFT<T>::powerToSpectrum(_vAccumulator, vData, _bins, scale, gain);
+}
+
+// Private functions
+
+// Weight of the next frame in the running average. The first frame of an
+// average replaces the accumulator contents, so no clearing pass is needed.
+template <typename T> T WelchPSD<T>::nextWeight(void) {
+  if (_averaging == FFTAveraging::Linear && _count >= _frames) {
+    _count = 0;
+  }
+  if (_count < UINT16_MAX) {
+    _count++;
+  }
+  if (_averaging == FFTAveraging::Linear || _count == 1) {
+    return T(1.0) / _count;
+  }
+  return _alpha;
+}
+
+template class WelchPSD<double>;
+template class WelchPSD<float>;
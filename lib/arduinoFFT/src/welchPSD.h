@@ -0,0 +1,67 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef WelchPSD_h /* Prevent loading library twice */
+#define WelchPSD_h
+
+#include "arduinoFFT.h"
+
+enum class FFTAveraging {
+  Linear,     // equal weights over blocks of a fixed number of frames
+  Exponential // each frame weighted by alpha, older frames decay
+};
+
+// Welch power spectral density estimate: averages the magnitude squared
+// spectra of successive (usually overlapping and windowed) frames. The average
+// is kept in place in the caller's accumulator array of bins values
+// (samples / 2 + 1 for a samples point transform), nothing is allocated.
+template <typename T> class WelchPSD {
+public:
+  WelchPSD(T *vAccumulator, uint_fast16_t bins,
+           FFTAveraging averaging = FFTAveraging::Linear,
+           uint_fast16_t frames = 8, T alpha = 0.25);
+
+  void add(const T *vReal, const T *vImag);
+  void addReal(const T *vData);
+  void density(T *vData, T samplingFrequency, T windowPower) const;
+  uint_fast16_t frames(void) const { return _count; }
+  void magnitude(T *vData) const;
+  bool ready(void) const;
+  void reset(void) { _count = 0; }
+  void setAveraging(FFTAveraging averaging, uint_fast16_t frames,
+                    T alpha = 0.25);
+  void setBins(uint_fast16_t bins);
+  void spectrum(T *vData, FFTScale scale, T gain = 1.0) const;
+
+private:
+  /* Variables */
+  T _alpha;
+  FFTAveraging _averaging;
+  uint_fast16_t _bins;
+  uint_fast16_t _count = 0; // Frames in the current average
+  uint_fast16_t _frames;
+  T *_vAccumulator;
+  /* Functions */
+  T nextWeight(void);
+};
+
+#endif
@@ -0,0 +1,159 @@
+/*
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "zoomFFT.h"
+
+template <typename T>
+ZoomFFT<T>::ZoomFFT(T samplingFrequency, T centerFrequency,
+                    uint_fast8_t decimation) {
+  configure(samplingFrequency, centerFrequency, decimation);
+}
+
+// Frequency of the last bin edge of the zoomed band
+template <typename T> T ZoomFFT<T>::bandEnd(void) const {
+  return _centerFrequency + _samplingFrequency / (2 * _decimation);
+}
+
+// Frequency of bin 0 of the output of compute()
+template <typename T> T ZoomFFT<T>::bandStart(void) const {
+  return _centerFrequency - _samplingFrequency / (2 * _decimation);
+}
+
+// Windows and transforms samples decimated values produced by update(). On
+// return the first samples values of vData, viewed as an array of T, hold the
+// magnitudes in ascending frequency order: value i belongs to
+// bandStart() + i * (bandEnd() - bandStart()) / samples. scale and gain are
+// those of ArduinoFFT<T>::powerToSpectrum(); a gain of
+// ArduinoFFT<T>::coherentScale(windowType, samples) gives the amplitude of
+// real sinusoids in the band.
+template <typename T>
+void ZoomFFT<T>::compute(FFTComplex<T> *vData, uint_fast16_t samples,
+                         FFTWindow windowType, FFTScale scale, T gain) const {
+  for (uint_fast16_t i = 0; i < (samples >> 1); i++) {
+    T weighingFactor = ArduinoFFT<T>::weighingFactor(windowType, i, samples);
+    uint_fast16_t j = samples - (i + 1);
+    vData[i].re *= weighingFactor;
+    vData[i].im *= weighingFactor;
+    vData[j].re *= weighingFactor;
+    vData[j].im *= weighingFactor;
+  }
+  _fft.compute(vData, samples, FFTDirection::Forward);
+  // Power i only overwrites values of bins up to i, which are done
+  T *vMagnitude = reinterpret_cast<T *>(vData);
+  for (uint_fast16_t i = 0; i < samples; i++) {
+    vMagnitude[i] = sq(vData[i].re) + sq(vData[i].im);
+  }
+  ArduinoFFT<T>::powerToSpectrum(vMagnitude, vMagnitude, samples, scale, gain);
+  // Negative frequencies (upper half) go below the centre frequency
+  uint_fast16_t half = samples >> 1;
+  for (uint_fast16_t i = 0; i < half; i++) {
+    T temp = vMagnitude[i];
+    vMagnitude[i] = vMagnitude[i + half];
+    vMagnitude[i + half] = temp;
+  }
+}
+
+// Sets the band and designs the low pass filter: a Blackman windowed sinc
+// with its cutoff at half the decimated rate. Clears the filter state.
+template <typename T>
+void ZoomFFT<T>::configure(T samplingFrequency, T centerFrequency,
+                           uint_fast8_t decimation) {
+  if (decimation < 1) {
+    decimation = 1;
+  }
+  _samplingFrequency = samplingFrequency;
+  _centerFrequency = centerFrequency;
+  _decimation = decimation;
+  _taps = 16 * decimation + 1;
+  if (_taps > ZOOM_FFT_MAX_TAPS) {
+    _taps = (ZOOM_FFT_MAX_TAPS - 1) | 1; // Odd, symmetric around one tap
+  }
+  T cutoff = T(0.5) / decimation; // Relative to the sampling frequency
+  T middle = T(_taps - 1) / 2;
+  T sum = 0.0;
+  for (uint_fast16_t i = 0; i < _taps; i++) {
+    T x = T(i) - middle;
+    T sinc = (x == 0) ? 2 * cutoff : sin(twoPi * cutoff * x) / (PI * x);
+    _coefficients[i] =
+        sinc * ArduinoFFT<T>::weighingFactor(FFTWindow::Blackman, i, _taps);
+    sum += _coefficients[i];
+  }
+  // Unity gain at the centre frequency
+  for (uint_fast16_t i = 0; i < _taps; i++) {
+    _coefficients[i] /= sum;
+  }
+  double angle = 6.28318530717958647692 * centerFrequency / samplingFrequency;
+  _stepReal = cos(angle);
+  _stepImag = -sin(angle);
+  reset();
+}
+
+template <typename T> void ZoomFFT<T>::reset(void) {
+  for (uint_fast16_t i = 0; i < _taps; i++) {
+    _historyReal[i] = 0.0;
+    _historyImag[i] = 0.0;
+  }
+  _position = 0;
+  _count = 0;
+  _ncoReal = 1.0;
+  _ncoImag = 0.0;
+}
+
+// Mixes, filters and decimates one input sample. Returns true and stores a
+// decimated value in output on every decimation-th call. The filter is only
+// evaluated for the samples that are kept.
+template <typename T>
+bool ZoomFFT<T>::update(T sample, FFTComplex<T> *output) {
+  _historyReal[_position] = sample * _ncoReal;
+  _historyImag[_position] = sample * _ncoImag;
+  if (++_position == _taps) {
+    _position = 0;
+  }
+  T z = _ncoReal * _stepReal - _ncoImag * _stepImag;
+  _ncoImag = _ncoReal * _stepImag + _ncoImag * _stepReal;
+  _ncoReal = z;
+  if (++_count < _decimation) {
+    return false;
+  }
+  _count = 0;
+  // Pull the phasor back to unit length (first order Newton step)
+  T gain = 1.5 - 0.5 * (sq(_ncoReal) + sq(_ncoImag));
+  _ncoReal *= gain;
+  _ncoImag *= gain;
+  // _position is the oldest sample; the filter is symmetric, so the taps can
+  // run in either direction
+  T re = 0.0;
+  T im = 0.0;
+  uint_fast16_t index = _position;
+  for (uint_fast16_t i = 0; i < _taps; i++) {
+    re += _coefficients[i] * _historyReal[index];
+    im += _coefficients[i] * _historyImag[index];
+    if (++index == _taps) {
+      index = 0;
+    }
+  }
+  output->re = re;
+  output->im = im;
+  return true;
+}
+
+template class ZoomFFT<double>;
+template class ZoomFFT<float>;
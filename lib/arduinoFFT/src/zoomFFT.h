@@ -0,0 +1,74 @@
+/*
+
+        FFT library
+        Copyright (C) 2010 Didier Longueville
+        Copyright (C) 2014 Enrique Condes
+        Copyright (C) 2020 Bim Overbohm (template, speed improvements)
+
+        This program is free software: you can redistribute it and/or modify
+        it under the terms of the GNU General Public License as published by
+        the Free Software Foundation, either version 3 of the License, or
+        (at your option) any later version.
+
+        This program is distributed in the hope that it will be useful,
+        but WITHOUT ANY WARRANTY; without even the implied warranty of
+        MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+        GNU General Public License for more details.
+
+        You should have received a copy of the GNU General Public License
+        along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef ZoomFFT_h /* Prevent loading library twice */
+#define ZoomFFT_h
+
+#include "arduinoFFT.h"
+
+/* Longest low pass filter; decimation factors up to 16 get 16 taps per unit */
+#ifndef ZOOM_FFT_MAX_TAPS
+#define ZOOM_FFT_MAX_TAPS 257
+#endif
+
+// Zoom FFT: band limited analysis around a centre frequency. Each input sample
+// is mixed down by a numerically controlled oscillator, so the centre
+// frequency moves to 0 Hz, then low pass filtered and decimated. A complex FFT
+// of samples decimated values covers samplingFrequency / decimation Hz around
+// the centre frequency with decimation times finer bins than a transform of
+// the same size on the raw stream. Bins within a transition band of the band
+// edges carry some aliased energy.
+template <typename T> class ZoomFFT {
+public:
+  ZoomFFT(T samplingFrequency, T centerFrequency, uint_fast8_t decimation);
+
+  T bandEnd(void) const;
+  T bandStart(void) const;
+  T centerFrequency(void) const { return _centerFrequency; }
+  void compute(FFTComplex<T> *vData, uint_fast16_t samples,
+               FFTWindow windowType = FFTWindow::Hamming,
+               FFTScale scale = FFTScale::Magnitude, T gain = 1.0) const;
+  uint_fast8_t decimation(void) const { return _decimation; }
+  void configure(T samplingFrequency, T centerFrequency,
+                 uint_fast8_t decimation);
+  void reset(void);
+  bool update(T sample, FFTComplex<T> *output);
+
+private:
+  /* Variables */
+  T _centerFrequency;
+  T _coefficients[ZOOM_FFT_MAX_TAPS];
+  uint_fast8_t _count = 0; // Inputs since the last output
+  uint_fast8_t _decimation;
+  ArduinoFFT<T> _fft;
+  T _historyImag[ZOOM_FFT_MAX_TAPS];
+  T _historyReal[ZOOM_FFT_MAX_TAPS];
+  T _ncoImag = 0.0; // Oscillator phasor
+  T _ncoReal = 1.0;
+  uint_fast16_t _position = 0;
+  T _samplingFrequency;
+  T _stepImag; // Phasor rotation per sample
+  T _stepReal;
+  uint_fast16_t _taps;
+};
+
+#endif
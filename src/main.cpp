@@ -31,6 +31,19 @@
 #include <TFT_eSPI.h>
 #include <TFT_eWidget.h>
 #include <arduinoFFT.h>
+#include <stft.h>
+#include <pingPong.h>
+#include <binTracker.h>
+#include <convolver.h>
+#include <welchPSD.h>
+#include <constantQ.h>
+#include <crossSpectrum.h>
+#include <zoomFFT.h>
+#include <chirpZ.h>
+#include <memoryArena.h>
+#include <decimator.h>
+#include <peakFinder.h>
+#include <periodEstimator.h>
 #include <Free_Fonts.h>
 #include <test_data_1.h> //EKG Test Data
 #include <test_data_2.h> //Sine Wave Test Data
@@ -42,6 +55,7 @@
 // Pin Definitions
 /* ACQUISITION INTERFACES*/
 #define SIGNAL_PIN 34
+#define RESPONSE_PIN 35 //Second channel of the dual analog mode (SIGNAL_PIN is the reference)
 /* BUTTONS */
 #define BUTTON_01 13
 #define BUTTON_02 12
@@ -52,7 +66,56 @@
 #define DEBOUNCE_DELAY 250 //250ms debounce delay
 //MEASUREMENT
 #define DEFAULT_SAMPLE_FREQ 1000
+#define MIN_SAMPLE_FREQ 50
+#define MAX_SAMPLE_FREQ 4000 //Hz, ADC_OVERSAMPLING conversions per sample take about a third of the sampler core here
 #define DEFAULT_BUFFER_SIZE 2048
+#define MIN_BUFFER_SIZE 256
+#define MAX_BUFFER_SIZE 2048 //All buffers and pools are carved for frames of this size
+#define RING_BUFFER_SIZE MAX_BUFFER_SIZE //Power of 2, at least one frame (the sampler task reads each frame right away)
+//Sampling
+#define SAMPLE_TIMER 0
+#define SAMPLE_TIMER_PRESCALER 8 //80 MHz APB clock / 8 = 10 MHz timer ticks
+#define SAMPLE_TIMER_FREQ 10000000
+#define ADC_OVERSAMPLING 8 //Hall and analog modes sample this much faster and decimate (1, 2, 4, 8 or 16)
+#define SAMPLER_CORE 0 //loop() runs on core 1
+#define SAMPLER_PRIORITY 3
+#define SAMPLER_STACK_SIZE 4096
+//Analysis Plan ("size", "rate", "window", "overlap", "average" or "analysis" over Serial, swapped between two frames)
+#define DEFAULT_WINDOW FFTWindow::Hamming
+#define DEFAULT_OVERLAP 75 //Percent of each frame repeated in the next
+//Spectrum Averaging (Welch, defaults of the analysis plan)
+#define PSD_AVERAGING FFTAveraging::Exponential //or FFTAveraging::Linear
+#define PSD_FRAMES 8 //Frames per linear average
+#define PSD_ALPHA 0.25 //Weight of the newest frame in the exponential average
+#define SPECTRUM_DB_RANGE 80 //Levels shown below the peak of the frequency graph
+//Zoom FFT ("zoom <center Hz> [decimation]" or "zoom off" over Serial)
+#define ZOOM_DEFAULT_DECIMATION 8
+#define ZOOM_MAX_DECIMATION 16
+#define SERIAL_COMMAND_LENGTH 32
+//Constant-Q Frequency Graph ("log on" or "log off" over Serial)
+#define CQ_BANDS_PER_OCTAVE 6
+#define CQ_MIN_FREQ 4 //Hz, lowest band (bands below Q * rate / size are as narrow as the frame allows)
+#define CQ_MAX_BANDS 64
+//Chirp-Z Band ("czt <start Hz> <end Hz>" or "czt off" over Serial, also on the last frame once stopped)
+#define CZT_POINTS 420 //One point per pixel of the frequency graph
+#define CZT_CACHE_SIZE 1 //Recent bands kept ready (tables of about 52kB each at 2048 samples, see "memory")
+//Memory ("memory" over Serial reports every region and the high-water mark of each pool)
+#define BUFFER_ARENA_SIZE (116 * 1024) //All buffers below at MAX_BUFFER_SIZE 2048 take 112kB
+#define TABLE_ARENA_SIZE (48 * 1024) //Per block reserved at boot for FFT plans, constant-Q kernels, chirp-Z tables and sprites
+#define TABLE_ARENA_BLOCKS 3 //Separate blocks, as the heap rarely has one free block of over 100kB (all tables take 139kB)
+#define PSRAM_ARENA_SIZE (1024 * 1024) //Tables that do not fit above, on boards with PSRAM
+//Tracked Frequencies (updated every sample, reported every frame)
+#define MAINS_FREQ 60 //Mains hum
+#define MAINS_HARMONIC_FREQ 120
+#define PEAK_COUNT 5 //Strongest tones reported per frame
+#define PEAK_THRESHOLD_DB -60 //Weakest tone reported (dB relative to 1V amplitude)
+#define CONVOLVER_SIZE 512 //Transform size of the EKG filter blocks
+#define EKG_FILTER_TAPS 255 //Band-pass on the EKG data (odd, at most CONVOLVER_SIZE / 2)
+#define EKG_FILTER_LOW 0.5 //Hz, eases baseline wander (a soft edge at this length, DC is 8dB down)
+#define EKG_FILTER_HIGH 40 //Hz, muscle noise and mains hum above are over 60dB down
+#define HEART_RATE_MIN 30 //BPM, longest beat period searched
+#define HEART_RATE_MAX 220 //BPM, shortest beat period searched
+#define HEART_RATE_SAMPLES (BUFFER_SIZE / 2) //Latest samples correlated, zero-padded to BUFFER_SIZE; 5.1s at 200Hz whatever the frame size
 //Graphing
 #define FFT_GRID_COLOR TFT_BLUE
 #define FFT_TRACE_COLOR TFT_GREEN
@@ -70,7 +133,11 @@
 
 /* Instantiate Variables */
 //Timing
-volatile unsigned long sample_start_time, sample_end_time;
+unsigned long last_frame_time = 0;
+uint32_t last_frame_samples = 0;
+float *frame_data = NULL; //Frame being processed by loop()
+float frame_mean = 0;
+uint32_t frame_end = 0; //Stream position just past the frame's last sample
 //Buttons
 volatile unsigned long button_01_last_millis = 0;
 volatile unsigned long button_02_last_millis = 0;
@@ -79,32 +146,95 @@ volatile bool button_01_pressed = false;
 volatile bool button_02_pressed = false;
 //volatile bool button_03_pressed = false;
 unsigned int display_mode = 0; //0 - Graph, 1 - Data
-unsigned int data_mode = 1; //0 - Hall Sensor, 1 - Analog, 2 - Test 1, 3 - Test 2
+unsigned int data_mode = 1; //0 - Hall Sensor, 1 - Analog, 2 - Test 1, 3 - Test 2, 4 - Dual Analog
 volatile bool acquire_data = false;
+/* STREAM CHANGES (zoom, data mode and analysis plan; requested by loop(), applied by the sampler task between samples) */
+volatile bool stream_change_pending = false;
+volatile unsigned int stream_generation = 0; //Changes the sampler task applied
+unsigned int displayed_stream_generation = 0; //Changes loop() took up
+/* ZOOM (applied with the next stream change) */
+volatile bool zoom_requested = false;
+volatile float zoom_center_freq = 0;
+volatile unsigned int zoom_decimation = ZOOM_DEFAULT_DECIMATION;
+volatile bool zoom_active = false;
+bool zoom_displayed = false;
+/* DUAL ANALOG (interleaved reference / response pairs, switched like the zoom) */
+volatile bool dual_active = false;
+bool dual_displayed = false;
+/* CONSTANT-Q (log-spaced bands of the single channel spectrum) */
+bool log_requested = false;
+bool log_displayed = false;
+unsigned int constant_q_freq = 0; //Sample rate of the kernels
+/* CHIRP-Z (any band of the last single channel frame at CZT_POINTS points) */
+bool czt_requested = false;
+bool czt_displayed = false;
+float czt_start_freq = 0;
+float czt_end_freq = 0;
+float capture_mean = 0;
+unsigned int capture_freq = 0; //Sample rate of the captured frame
+bool capture_valid = false;
 /* TEST DATA */
 unsigned int data_index_set1 = 0;
-unsigned int last_data_point_set1 = 0;
 unsigned int data_index_set2 = 0;
-unsigned int last_data_point_set2 = 0;
-float current_data_point = 0.00;
 //SINE WAVE TEST DATA PARAMETERS
 const unsigned int DATA_FREQ_set1 = 1000;
-const unsigned int DATA_PERIOD_set1 = 1E6 / DATA_FREQ_set1;
 //ELECTROCARDIOGRAM TEST DATA PARAMETERS
 const unsigned int DATA_FREQ_set2 = 200;
-const unsigned int DATA_PERIOD_set2 = 1E6 / DATA_FREQ_set2;
 //Buffer Parameters
-volatile unsigned long last_acquisition = 0;
-unsigned int SAMPLE_FREQ = DEFAULT_SAMPLE_FREQ;
-unsigned int SAMPLE_PERIOD;
-const unsigned int BUFFER_SIZE = DEFAULT_BUFFER_SIZE;
-const unsigned int BUFFER_POWER = log2(BUFFER_SIZE);
+volatile unsigned int oversampling = ADC_OVERSAMPLING;
+const unsigned int BUFFER_SIZE = MAX_BUFFER_SIZE;
 const unsigned int SEC_TO_GRAPH = 10;
-//Buffers
-float DATA_BUFFER[BUFFER_SIZE];
-float COMPLEX_BUFFER[BUFFER_SIZE];
-float TIME_BUFFER[BUFFER_SIZE];
-volatile unsigned int buffer_index = 0;
+//Buffers (carved from one static arena in this order before setup(), never freed)
+struct Frame { //Filled by the sampler task, processed by loop()
+  float data[BUFFER_SIZE];
+  float mean;
+  uint32_t end; //Stream position just past the last sample, to tell consecutive frames from ones after a gap
+};
+alignas(16) uint8_t BUFFER_ARENA[BUFFER_ARENA_SIZE];
+MemoryArena memory = MemoryArena(BUFFER_ARENA, BUFFER_ARENA_SIZE);
+portMUX_TYPE memory_lock = portMUX_INITIALIZER_UNLOCKED; //Held by the allocator hooks, which loop() and the sampler task may both call
+Frame *FRAME_BUFFER = memory.allocate<Frame>(2, "FRAME_BUFFER");
+float *DATA_BUFFER = memory.allocate<float>(BUFFER_SIZE, "DATA_BUFFER");
+float *RING_BUFFER = memory.allocate<float>(RING_BUFFER_SIZE, "RING_BUFFER");
+float *TRACKER_HISTORY = memory.allocate<float>(BUFFER_SIZE, "TRACKER_HISTORY");
+float *HEART_RATE_HISTORY = memory.allocate<float>(HEART_RATE_SAMPLES, "HEART_RATE_HISTORY"); //Latest EKG samples, across frames
+float *PSD_BUFFER = memory.allocate<float>(BUFFER_SIZE / 2 + 1, "PSD_BUFFER");
+float *CROSS_BUFFER = memory.allocate<float>(4 * (BUFFER_SIZE / 4 + 1), "CROSS_BUFFER"); //Gxx, Gyy and Gxy of BUFFER_SIZE / 2 pair frames
+float *CQ_REAL = memory.allocate<float>(CQ_MAX_BANDS, "CQ_REAL");
+float *CQ_IMAG = memory.allocate<float>(CQ_MAX_BANDS, "CQ_IMAG");
+float *CQ_PSD_BUFFER = memory.allocate<float>(CQ_MAX_BANDS, "CQ_PSD_BUFFER");
+float *CAPTURE_BUFFER = memory.allocate<float>(BUFFER_SIZE, "CAPTURE_BUFFER"); //Raw copy of the last single channel frame
+float *CZT_REAL = memory.allocate<float>(2 * BUFFER_SIZE, "CZT_REAL"); //Chirp-Z work arrays (BUFFER_SIZE + CZT_POINTS - 1 rounded up to a power of 2)
+float *CZT_IMAG = memory.allocate<float>(2 * BUFFER_SIZE, "CZT_IMAG");
+float *WINDOW_BUFFER = memory.allocate<float>(BUFFER_SIZE, "WINDOW_BUFFER"); //Half windows of the analysis plan in use and of the next one
+float *CONVOLVER_RESPONSE = memory.allocate<float>(CONVOLVER_SIZE, "CONVOLVER_RESPONSE");
+float *CONVOLVER_BUFFER = memory.allocate<float>(CONVOLVER_SIZE, "CONVOLVER_BUFFER");
+float *CONVOLVER_HISTORY = memory.allocate<float>(CONVOLVER_SIZE / 2, "CONVOLVER_HISTORY");
+float *FILTER_BLOCK = memory.allocate<float>(CONVOLVER_SIZE, "FILTER_BLOCK");
+unsigned int filter_block_index = 0; //Sampler task only
+bool ekg_filtering = false; //Sampler task only
+//Analysis Plan (edited by commands, handed to the sampler task with a stream change and taken up by loop() with its first frame)
+struct AnalysisConfig {
+  unsigned int size; //Samples per frame, a power of 2 from MIN_BUFFER_SIZE to BUFFER_SIZE
+  unsigned int rate; //Hz
+  FFTWindow window;
+  unsigned int overlap; //Percent of each frame repeated in the next
+  FFTAveraging averaging;
+  unsigned int frames; //Frames per linear average
+  float alpha; //Weight of the newest frame in the exponential average
+  //Filled by PrepareAnalysis() before the hand-over
+  float *window_factors; //First half of the window, in one half of WINDOW_BUFFER
+  float spectrum_gain; //So a sinusoid of amplitude A reads A (20log10(A) dB) behind the window
+  float zoom_spectrum_gain; //The same for the size / 2 baseband pairs of the zoom
+};
+AnalysisConfig analysis = {DEFAULT_BUFFER_SIZE, DEFAULT_SAMPLE_FREQ, DEFAULT_WINDOW, DEFAULT_OVERLAP,
+                           PSD_AVERAGING, PSD_FRAMES, PSD_ALPHA, NULL, 1, 1}; //In use by loop()
+AnalysisConfig requested_analysis = analysis; //Read by the sampler task while stream_change_pending is set
+AnalysisConfig next_analysis = analysis; //Edited by commands, requested once no stream change is under way
+bool analysis_queued = false;
+bool analysis_requested = false;
+const char *WINDOW_NAMES[] = {"rectangle", "hamming", "hann", "triangle", "nuttall", "blackman",
+                              "blackman_nuttall", "blackman_harris", "flat_top", "welch"}; //In FFTWindow order
 //Screen Properties
 unsigned long last_toolbar_refresh = 0;
 char toolbar_left[10] = "LEFT";
@@ -130,6 +260,37 @@ float frequency_y_inc = 1;
 float frequency_magnitude_max = 4;
 
 /* CREATE OBJECTS */
+//Sampling
+hw_timer_t *sample_timer = NULL;
+TaskHandle_t sampler_task = NULL;
+//Sample Stream (new frame of analysis.size samples every FrameHop() samples)
+STFT<float> stft = STFT<float>(RING_BUFFER, RING_BUFFER_SIZE, DEFAULT_BUFFER_SIZE, DEFAULT_BUFFER_SIZE * (100 - DEFAULT_OVERLAP) / 100);
+//Frame Pipeline (the sampler task fills one frame while loop() processes the other)
+PingPong<Frame> frames = PingPong<Frame>(&FRAME_BUFFER[0], &FRAME_BUFFER[1]);
+//Welch Averaging of the frame power spectra
+WelchPSD<float> welch = WelchPSD<float>(PSD_BUFFER, BUFFER_SIZE / 2 + 1, PSD_AVERAGING, PSD_FRAMES, PSD_ALPHA);
+//Cross Spectrum (coherence and transfer function of the dual analog mode, one complex FFT per frame)
+CrossSpectrum<float> cross = CrossSpectrum<float>(CROSS_BUFFER, BUFFER_SIZE / 4 + 1, PSD_AVERAGING, PSD_FRAMES, PSD_ALPHA);
+//Constant-Q Bands (sparse kernels applied to the unwindowed spectrum, averaged like the Welch spectrum)
+ConstantQ<float> constant_q;
+WelchPSD<float> constant_q_welch = WelchPSD<float>(CQ_PSD_BUFFER, CQ_MAX_BANDS, PSD_AVERAGING, PSD_FRAMES, PSD_ALPHA);
+//Chirp-Z Band (chirps and filter transform cached per band, reused frame after frame)
+ChirpZ<float> chirp_z = ChirpZ<float>(CZT_CACHE_SIZE);
+//Decimator (anti-alias filter from the ADC rate down to the sample rate)
+Decimator<float> decimator = Decimator<float>(ADC_OVERSAMPLING);
+Decimator<float> response_decimator = Decimator<float>(ADC_OVERSAMPLING);
+//Zoom FFT (mixes the band around the center frequency to baseband and decimates)
+ZoomFFT<float> zoom = ZoomFFT<float>(DEFAULT_SAMPLE_FREQ, 0, ZOOM_DEFAULT_DECIMATION);
+//Bin Tracker (sliding DFT of the last BUFFER_SIZE samples at a few frequencies)
+BinTracker<float> bin_tracker = BinTracker<float>(TRACKER_HISTORY, BUFFER_SIZE, DEFAULT_SAMPLE_FREQ);
+//Peak Finder (strongest tones of each displayed spectrum, for harmonic analysis)
+PeakFinder<float> peak_finder = PeakFinder<float>(PEAK_COUNT, FFTPeakEstimator::Parabolic);
+//Heart Rate (fundamental period of the EKG from its autocorrelation)
+PeriodEstimator<float> heart_rate = PeriodEstimator<float>(HEART_RATE_MIN / 60.0, HEART_RATE_MAX / 60.0);
+unsigned int heart_rate_count = 0; //Samples in HEART_RATE_HISTORY
+uint32_t heart_rate_end = 0; //Stream position just past the newest of them
+//EKG Filter (overlap-save FIR band-pass, one transform pair per block)
+Convolver<float> ekg_filter = Convolver<float>(CONVOLVER_RESPONSE, CONVOLVER_BUFFER, CONVOLVER_HISTORY, CONVOLVER_SIZE);
 //Screen Object
 TFT_eSPI tft = TFT_eSPI();
 //Graph Objects
@@ -137,8 +298,8 @@ GraphWidget timeseries_graph = GraphWidget(&tft);
 TraceWidget timeseries_trace = TraceWidget(&timeseries_graph);
 GraphWidget frequency_graph = GraphWidget(&tft);
 TraceWidget frequency_trace = TraceWidget(&frequency_graph);
-//FFT Object
-ArduinoFFT<float> FFT = ArduinoFFT<float>(DATA_BUFFER, COMPLEX_BUFFER, BUFFER_SIZE, SAMPLE_FREQ);
+//FFT Object (any frame size of the analysis plan, tables of every size built by PrewarmPlans())
+ArduinoFFT<float> FFT;
 
 /* Function Declarations */
 /* BUTTON LOGIC*/
@@ -150,6 +311,7 @@ void IRAM_ATTR buttonDebounce02();
 //void ChangeDisplayMode();
 void ChangeDataMode();
 void ChangeAcquisitionMode();
+void HandleSerialCommand();
 /* TFT SCREEN LOGIC*/
 //Define Screens
 void DrawGraphScreen();
@@ -168,15 +330,42 @@ void WriteDataScreen();
 //Tool bar
 void DrawToolBar();
 /* DATA ACQUISITION LOGIC*/
+void IRAM_ATTR onSampleTimer();
+void SamplerTask(void *parameter);
+void StartSampling();
+void SetSampleRate(unsigned int rate);
 void AcquireData();
+void DesignEKGFilter();
+void FilterEKG(float data);
 float AcquireAnalog(unsigned int pin = SIGNAL_PIN);
 float AcquireTest(unsigned int set);
 float AcquireHall();
 /* BUFFER LOGIC*/
 void ResetBuffers();
+void ApplyStreamChange();
 void WriteBuffer(float data);
+void WriteBufferPair(float reference, float response);
+void PublishFrame();
+/* ANALYSIS PLAN LOGIC*/
+void PrewarmPlans();
+void PrepareAnalysis(AnalysisConfig &config);
+void RequestAnalysis();
+void ApplyAnalysis();
+void ReportAnalysis(const AnalysisConfig &config);
+unsigned int FrameHop(const AnalysisConfig &config);
 /* FFT LOGIC*/
 void RunFFT();
+void ConfigureConstantQ();
+bool ComputeChirpZ();
+void UpdateHeartRateHistory();
+void EstimateHeartRate();
+void RunCrossSpectrum();
+/* MEMORY LOGIC*/
+void ReserveTableMemory();
+void *AllocateTable(size_t bytes, const char *name);
+void *AllocateSprite(size_t bytes, bool psram);
+void ReleaseTable(void *pointer);
+void ReportMemory();
 /* LED LOGIC*/
 void TurnOffLED();
 void SetLEDColor(int color);
@@ -188,6 +377,9 @@ void setup() {
   }
   Serial.printf("Serial Communication Established. Baud Rate: %d\n", BAUD_RATE);
 
+  //Route the FFT tables and sprites to the memory arena before any is built
+  ReserveTableMemory();
+
   //Set PinModes
   pinMode(BUTTON_01, INPUT_PULLUP);
   pinMode(BUTTON_02, INPUT_PULLUP);
@@ -198,12 +390,32 @@ void setup() {
   attachInterrupt(digitalPinToInterrupt(BUTTON_02), buttonDebounce02, FALLING);
   //attachInterrupt(digitalPinToInterrupt(BUTTON_03), buttonDebounce03, FALLING);
 
+  //Select FFT Kernel (plan-driven radix-4 for every power of two frame size)
+  FFT.setKernel(FFTKernel::Radix4);
+
   //Initiate TFT Screen
   tft.begin();
   tft.setRotation(1);
   Serial.printf("TFT Initialized. Width: %d. Height: %d.\n", tft.width(), tft.height());
   //Write Welcome Screen (Inherent Delay of WELCOME_TIME)
   WriteWelcomeScreen();
+
+  //Select Tracked Frequencies
+  bin_tracker.addBin(MAINS_FREQ);
+  bin_tracker.addBin(MAINS_HARMONIC_FREQ);
+
+  //Design the EKG Band-Pass Filter
+  DesignEKGFilter();
+
+  //Tables of every frame size, then the window and gains of the default analysis plan
+  PrewarmPlans();
+  PrepareAnalysis(next_analysis);
+  requested_analysis = next_analysis;
+  ApplyAnalysis();
+
+  //Start Sample Timer and Sampler Task
+  StartSampling();
+  ReportMemory();
 }
 
 void loop() {
@@ -221,6 +433,8 @@ void loop() {
   //   button_03_pressed = false;
   // }
 
+  HandleSerialCommand();
+
   DrawToolBar();
 
   if ((0 == display_mode) and ((current_mode != 0) or (false == screen_initialized))) {
@@ -234,8 +448,50 @@ void loop() {
   //   Serial.println("Data Screen Not Written");
   // }
 
-  if (acquire_data) {
-    AcquireData();
+  //Start over once the sampler task switched between the raw and zoomed stream or to another analysis plan
+  if (stream_generation != displayed_stream_generation) {
+    displayed_stream_generation = stream_generation;
+    zoom_displayed = zoom_active;
+    dual_displayed = dual_active;
+    if (analysis_requested) {
+      ApplyAnalysis();
+    }
+    welch.reset();
+    cross.reset();
+    constant_q_welch.reset();
+    heart_rate_count = 0;
+    DrawGraphScreen();
+  }
+  RequestAnalysis(); //Hands over the latest edits once the sampler task has no stream change pending
+
+  //Sampling and framing continue on the other core; process the newest frame
+  Frame *frame = frames.take();
+  if (frame) {
+    if (stream_generation == displayed_stream_generation) {
+      frame_data = frame->data;
+      frame_mean = frame->mean;
+      frame_end = frame->end;
+      if ((false == zoom_displayed) and (false == dual_displayed)) {
+        //Keep the raw frame, so bands can still be inspected after the acquisition stops
+        memcpy(CAPTURE_BUFFER, frame_data, analysis.size * sizeof(float));
+        capture_mean = frame_mean;
+        capture_freq = analysis.rate;
+        capture_valid = true;
+      }
+      czt_displayed = czt_requested and (false == zoom_displayed) and (false == dual_displayed);
+      log_displayed = log_requested and (false == czt_displayed) and (false == zoom_displayed) and (false == dual_displayed);
+      if (log_displayed and (constant_q_freq != analysis.rate)) {
+        ConfigureConstantQ(); //Turns the log scale off if out of memory
+      }
+      PlotTimeGraph();
+      if (dual_displayed) {
+        RunCrossSpectrum();
+      }
+      else {
+        RunFFT();
+      }
+    }
+    frames.release(frame);
   }
 }
 
@@ -273,26 +529,192 @@ void ChangeDisplayMode() {
 }
 void ChangeDataMode() {
   data_mode++;
-  if (data_mode > 3) {
+  if (data_mode > 4) {
     data_mode = 1;
   }
 
+  //Test data plays at the rate it was recorded at
   if (2 == data_mode) {
-    SAMPLE_FREQ = DATA_FREQ_set1;
+    next_analysis.rate = DATA_FREQ_set1;
   }
-
-  if (3 == data_mode) {
-    SAMPLE_FREQ = DATA_FREQ_set2;
+  else if (3 == data_mode) {
+    next_analysis.rate = DATA_FREQ_set2;
   }
   else {
-    SAMPLE_FREQ = DEFAULT_SAMPLE_FREQ;
+    next_analysis.rate = DEFAULT_SAMPLE_FREQ;
   }
+  analysis_queued = true; //Retune the timer and zoom to the new rate, switch streams and drop the frames of the old mode
+  welch.reset();
+  cross.reset();
+  constant_q_welch.reset();
   Serial.printf("Data Mode: %d\n", data_mode);
 }
 void ChangeAcquisitionMode() {
+  if (!acquire_data) {
+    stft.discard(); //Start with a fresh frame (the sampler task is idle)
+    frames.discard();
+    welch.reset();
+    cross.reset();
+    constant_q_welch.reset();
+  }
   acquire_data = !acquire_data;
   Serial.printf("Acquisition Button Pressed. Acquiring: %s\n", acquire_data ? "Yes" : "No");
 }
+//Serial Commands
+void HandleSerialCommand() {
+  if (Serial.available() <= 0) {
+    return;
+  }
+  char command[SERIAL_COMMAND_LENGTH];
+  size_t length = Serial.readBytesUntil('\n', command, sizeof(command) - 1);
+  command[length] = '\0';
+  command[strcspn(command, "\r")] = '\0'; //Line endings of CR LF terminals
+  float center_freq = 0;
+  unsigned int decimation = ZOOM_DEFAULT_DECIMATION;
+  float start_freq = 0;
+  float end_freq = 0;
+  unsigned int value = 0;
+  float alpha = 0;
+  if (0 == strncmp(command, "memory", 6)) {
+    ReportMemory();
+  }
+  else if (0 == strncmp(command, "analysis", 8)) {
+    ReportAnalysis(analysis);
+  }
+  else if (1 == sscanf(command, "size %u", &value)) {
+    if ((value < MIN_BUFFER_SIZE) or (value > BUFFER_SIZE) or (0 != (value & (value - 1)))) {
+      Serial.printf("Frame Size Needs a Power of 2 from %d to %d\n", MIN_BUFFER_SIZE, BUFFER_SIZE);
+      return;
+    }
+    next_analysis.size = value;
+    analysis_queued = true;
+    Serial.printf("Frame Size: %u samples\n", value);
+  }
+  else if (1 == sscanf(command, "rate %u", &value)) {
+    if ((2 == data_mode) or (3 == data_mode)) {
+      Serial.println("Sample Rate Fixed by the Test Data");
+      return;
+    }
+    if ((value < MIN_SAMPLE_FREQ) or (value > MAX_SAMPLE_FREQ)) {
+      Serial.printf("Sample Rate Needs %d to %dHz\n", MIN_SAMPLE_FREQ, MAX_SAMPLE_FREQ);
+      return;
+    }
+    next_analysis.rate = value;
+    analysis_queued = true;
+    Serial.printf("Sample Rate: %uHz\n", value);
+  }
+  else if (0 == strncmp(command, "window ", 7)) {
+    for (int i = 0; i < sizeof(WINDOW_NAMES) / sizeof(WINDOW_NAMES[0]); i++) {
+      if (0 == strcmp(command + 7, WINDOW_NAMES[i])) {
+        next_analysis.window = static_cast<FFTWindow>(i);
+        analysis_queued = true;
+        Serial.printf("Window: %s\n", WINDOW_NAMES[i]);
+        return;
+      }
+    }
+    Serial.print("Windows:");
+    for (int i = 0; i < sizeof(WINDOW_NAMES) / sizeof(WINDOW_NAMES[0]); i++) {
+      Serial.printf(" %s", WINDOW_NAMES[i]);
+    }
+    Serial.println();
+  }
+  else if (1 == sscanf(command, "overlap %u", &value)) {
+    if (value > 99) {
+      Serial.println("Overlap Needs 0 to 99%");
+      return;
+    }
+    if (0 != ((next_analysis.size * (100 - value) / 100) & 1)) {
+      //Zoom and dual analog push pairs of values, an odd hop would split them across frames
+      Serial.printf("Overlap of %u%% Gives an Odd Hop at %u Samples\n", value, next_analysis.size);
+      return;
+    }
+    next_analysis.overlap = value;
+    analysis_queued = true;
+    Serial.printf("Overlap: %u%%\n", value);
+  }
+  else if (1 == sscanf(command, "average linear %u", &value)) {
+    if (value < 1) {
+      Serial.println("Linear Average Needs at Least 1 Frame");
+      return;
+    }
+    next_analysis.averaging = FFTAveraging::Linear;
+    next_analysis.frames = value;
+    analysis_queued = true;
+    Serial.printf("Averaging: Linear over %u frames\n", value);
+  }
+  else if (1 == sscanf(command, "average exponential %f", &alpha)) {
+    if ((alpha <= 0) or (alpha > 1)) {
+      Serial.println("Exponential Average Needs 0 < Alpha <= 1");
+      return;
+    }
+    next_analysis.averaging = FFTAveraging::Exponential;
+    next_analysis.alpha = alpha;
+    analysis_queued = true;
+    Serial.printf("Averaging: Exponential, alpha %.3f\n", alpha);
+  }
+  else if (0 == strncmp(command, "log on", 6)) {
+    log_requested = true;
+    constant_q_welch.reset();
+    Serial.println("Log Frequency Scale On");
+  }
+  else if (0 == strncmp(command, "log off", 7)) {
+    log_requested = false;
+    welch.reset();
+    Serial.println("Log Frequency Scale Off");
+  }
+  else if (0 == strncmp(command, "zoom off", 8)) {
+    zoom_requested = false;
+    stream_change_pending = true;
+    Serial.println("Zoom Off");
+  }
+  else if (0 == strncmp(command, "czt off", 7)) {
+    czt_requested = false;
+    welch.reset();
+    Serial.println("Chirp-Z Band Off");
+  }
+  else if (2 == sscanf(command, "czt %f %f", &start_freq, &end_freq)) {
+    float nyquist = (acquire_data or (false == capture_valid)) ? analysis.rate / 2.0 : capture_freq / 2.0;
+    if ((start_freq < 0) or (start_freq >= end_freq) or (end_freq > nyquist)) {
+      Serial.printf("Chirp-Z Needs 0 <= Start < End <= %.0fHz\n", nyquist);
+      return;
+    }
+    czt_start_freq = start_freq;
+    czt_end_freq = end_freq;
+    czt_requested = true;
+    Serial.printf("Chirp-Z Band: %.2fHz to %.2fHz, %.3fHz Steps\n", start_freq, end_freq, (end_freq - start_freq) / (CZT_POINTS - 1));
+    if ((false == acquire_data) and capture_valid) {
+      //Acquisition stopped: zoom into the last frame without acquiring again
+      czt_displayed = true;
+      log_displayed = false;
+      if (ComputeChirpZ()) {
+        frame_data = CZT_REAL;
+        peak_finder.find(frame_data, CZT_POINTS, (czt_end_freq - czt_start_freq) / (CZT_POINTS - 1), PEAK_THRESHOLD_DB);
+        PlotFrequencyGraph();
+        for (int i = 0; i < peak_finder.peaks(); i++) {
+          Serial.printf("Peak %d: %.3fHz %.1fdB\n", i + 1, czt_start_freq + peak_finder.peak(i).frequency, peak_finder.peak(i).magnitude);
+        }
+      }
+    }
+  }
+  else if (sscanf(command, "zoom %f %u", &center_freq, &decimation) >= 1) {
+    if (4 == data_mode) {
+      Serial.println("Zoom Needs a Single Channel Data Mode");
+      return;
+    }
+    if ((decimation < 2) or (decimation > ZOOM_MAX_DECIMATION) or (center_freq < 0) or (center_freq > analysis.rate / 2)) {
+      Serial.printf("Zoom Needs 0 to %dHz and Decimation 2 to %d\n", analysis.rate / 2, ZOOM_MAX_DECIMATION);
+      return;
+    }
+    zoom_center_freq = center_freq;
+    zoom_decimation = decimation;
+    zoom_requested = true;
+    stream_change_pending = true;
+    Serial.printf("Zoom: %.2fHz +/- %.2fHz\n", center_freq, analysis.rate / (2.0 * decimation));
+  }
+  else {
+    Serial.printf("Unknown Command: %s\n", command);
+  }
+}
 
 /* TFT SCREEN LOGIC*/
 
@@ -336,31 +758,41 @@ void DrawFrequencyGraph() {
   tft.drawLine(39,151,460,151,TFT_WHITE);
   tft.setTextSize(1);
   tft.setTextColor(TFT_WHITE);
-  //Draw FFT Y-Axis Values
-  char ymidlabel[5];
-  float y_mid = frequency_magnitude_max / 2;
-  snprintf(ymidlabel, sizeof(ymidlabel), "%.0f", y_mid);
-  int length_y_mid_label = strlen(ymidlabel);
-  tft.setCursor((38 - (length_y_mid_label * 1 * 6)) / 2, 96);
+  //Draw FFT Y-Axis Values (dB, from the peak down SPECTRUM_DB_RANGE)
   tft.fillRect(0,36,37,124,TFT_BLACK);
-  tft.printf("%.0f", y_mid);
-  tft.setCursor(16, 146);
-  tft.print("0");
-  char ymaxlabel[5];
-  snprintf(ymaxlabel, sizeof(ymaxlabel), "%.0f", frequency_magnitude_max);
-  int length_y_max_label = strlen(ymaxlabel);
-  tft.setCursor((38 - (length_y_max_label * 1 * 6)) / 2, 36);
-  tft.printf("%.0f", frequency_magnitude_max);
-  //Draw FFT X-Axis Values
-  float y_max_freq = float(SAMPLE_FREQ / 2);
+  float y_values[3] = {frequency_magnitude_max, frequency_magnitude_max - SPECTRUM_DB_RANGE / 2, frequency_magnitude_max - SPECTRUM_DB_RANGE};
+  int y_positions[3] = {36, 96, 146};
+  for (int i = 0; i < 3; i++) {
+    char ylabel[6];
+    snprintf(ylabel, sizeof(ylabel), "%.0f", y_values[i]);
+    tft.setCursor((38 - (strlen(ylabel) * 1 * 6)) / 2, y_positions[i]);
+    tft.print(ylabel);
+  }
+  //Draw FFT X-Axis Values (the zoomed band when zooming)
+  float x_min_freq = 0;
+  float x_max_freq = float(analysis.rate / 2);
+  if (zoom_displayed) {
+    x_min_freq = zoom.bandStart();
+    x_max_freq = zoom.bandEnd();
+  }
+  else if (czt_displayed) {
+    x_min_freq = czt_start_freq;
+    x_max_freq = czt_end_freq;
+  }
+  const char *xformat = ((x_max_freq - x_min_freq) < 20) ? "%.1f" : "%.0f";
   for (int i = 0; i < 11; i++) {
     float modifier = (i) / float(10);
-    float x_val = y_max_freq * modifier;
-    char xlabel[4];
-    snprintf(xlabel, sizeof(xlabel), "%.0f", x_val);
+    float x_val = x_min_freq + (x_max_freq - x_min_freq) * modifier;
+    if (log_displayed and (constant_q.bands() > 1)) {
+      //Equal steps in bands are equal frequency ratios
+      x_val = constant_q.frequency((constant_q.bands() - 1) * modifier);
+      xformat = (x_val < 10) ? "%.1f" : "%.0f";
+    }
+    char xlabel[8];
+    snprintf(xlabel, sizeof(xlabel), xformat, x_val);
     int length_xlabel = strlen(xlabel);
     tft.setCursor((((40 + 42*i) - 21) + ((42 - length_xlabel * 6) / 2)), 155);
-    tft.printf("%.0f", x_val);
+    tft.print(xlabel);
   }
 }
 void DrawTimeGraph() {
@@ -401,8 +833,14 @@ void DrawTimeGraph() {
   tft.setCursor((38 - (length_y_max_label * 1 * 6)) / 2, 176);
   tft.printf("%.1f", timeseries_y_max);
   //Draw TimeSeries X-Axis Values
-  float curr_sample_period = (1E6 / SAMPLE_FREQ);
-  float max_time = BUFFER_SIZE * (curr_sample_period / 1E6);
+  float curr_sample_period = (1E6 / analysis.rate);
+  float max_time = analysis.size * (curr_sample_period / 1E6);
+  if (zoom_displayed) {
+    max_time *= zoom.decimation() / 2.0; //size / 2 decimated I/Q pairs
+  }
+  else if (dual_displayed) {
+    max_time /= 2; //size / 2 reference / response pairs
+  }
   for (int i = 0; i < 11; i++) {
     float modifier = (i) / float(10);
     float x_val = max_time * modifier;
@@ -418,13 +856,13 @@ void DrawTimeGraph() {
 }
 void ScaleTimeGraph() {
   float sum_buffer = 0, max_buffer = 0, min_buffer = 0;
-  for (int i = 0; i < BUFFER_SIZE; i++) {
-    sum_buffer = sum_buffer + DATA_BUFFER[i];
-    if (DATA_BUFFER[i] < min_buffer) {
-      min_buffer = DATA_BUFFER[i];
+  for (int i = 0; i < analysis.size; i++) {
+    sum_buffer = sum_buffer + frame_data[i];
+    if (frame_data[i] < min_buffer) {
+      min_buffer = frame_data[i];
     }
-    else if (DATA_BUFFER[i] > max_buffer) {
-      max_buffer = DATA_BUFFER[i];
+    else if (frame_data[i] > max_buffer) {
+      max_buffer = frame_data[i];
     }
   }
   float buffer_range = (max_buffer - min_buffer);
@@ -443,25 +881,40 @@ void ScaleTimeGraph() {
 }
 void ScaleFrequencyGraph();
 void PlotFrequencyGraph() {
-  int maxVal = 0, minVal = 0;
-  for(int i = 0; i < (BUFFER_SIZE / 2); i++) {
-    if (DATA_BUFFER[i] > maxVal) {
-      maxVal = DATA_BUFFER[i];
+  int step = dual_displayed ? 2 : 1; //Dual frames have half the bins over the same band
+  int points = analysis.size / (2 * step);
+  float x_step = step;
+  if (log_displayed) {
+    //Constant-Q bands spread over the whole axis
+    points = constant_q.bands();
+    x_step = frequency_x_max / max(points - 1, 1);
+  }
+  else if (czt_displayed) {
+    //Chirp-Z points from the band start to the band end
+    points = CZT_POINTS;
+    x_step = frequency_x_max / (points - 1);
+  }
+  float maxVal = frame_data[0];
+  for(int i = 1; i < points; i++) {
+    if (frame_data[i] > maxVal) {
+      maxVal = frame_data[i];
     }
   }
   frequency_magnitude_max = maxVal;
   DrawFrequencyGraph();
   frequency_trace.startTrace(FFT_TRACE_COLOR);
-  for(int i = 0; i < (BUFFER_SIZE / 2); i++) {
-    DATA_BUFFER[i] = 4 * DATA_BUFFER[i] / maxVal; //Magnitude Normalization
-    frequency_trace.addPoint(i, DATA_BUFFER[i]);
+  float floorVal = maxVal - SPECTRUM_DB_RANGE;
+  for(int i = 0; i < points; i++) {
+    //dB Normalization (the peak at the top, levels below the range on the axis)
+    frame_data[i] = frequency_y_max * max(frame_data[i] - floorVal, 0.0f) / SPECTRUM_DB_RANGE;
+    frequency_trace.addPoint(i * x_step, frame_data[i]);
   }
 }
-void PlotTimeGraph(int x, int y) {
-  timeseries_trace.addPoint(x,y);
-  if (x == (BUFFER_SIZE - 1)) {
-    ScaleTimeGraph();
-    x = 0;
+void PlotTimeGraph() {
+  ScaleTimeGraph(); //Redraws the graph screen scaled to the new frame
+  int step = (zoom_displayed or dual_displayed) ? 2 : 1; //Paired frames plot the in-phase or reference part
+  for (int i = 0; i < analysis.size; i += step) {
+    timeseries_trace.addPoint(i, frame_data[i]);
   }
 }
 //Data Screen
@@ -480,7 +933,7 @@ void DrawToolBar() {
     char toolbar_left_update[10];
     char toolbar_center_update[10];
     char toolbar_right_update[10];
-    snprintf(toolbar_left_update, sizeof(toolbar_left_update), "%d Hz", SAMPLE_FREQ);
+    snprintf(toolbar_left_update, sizeof(toolbar_left_update), "%d Hz", analysis.rate);
     snprintf(toolbar_center_update, sizeof(toolbar_center_update), "%s", acquire_data ? "Acquiring" : "Stopped");
     if (0 == data_mode) {
       snprintf(toolbar_right_update, sizeof(toolbar_right_update), "%s", "HALL");
@@ -494,6 +947,9 @@ void DrawToolBar() {
     else if (3 == data_mode) {
       snprintf(toolbar_right_update, sizeof(toolbar_right_update), "%s", "TST: EKG");
     }
+    else if (4 == data_mode) {
+      snprintf(toolbar_right_update, sizeof(toolbar_right_update), "%s", "DUAL");
+    }
     tft.setTextSize(2);
     int text_height = 2 * 8;
     int toolbar_height = 30;
@@ -526,112 +982,486 @@ void DrawToolBar() {
   }
 }
 /* DATA ACQUISITION LOGIC*/
+//Sample Timer: wakes the sampler task once per sample period
+void IRAM_ATTR onSampleTimer() {
+  BaseType_t task_woken = pdFALSE;
+  vTaskNotifyGiveFromISR(sampler_task, &task_woken);
+  portYIELD_FROM_ISR(task_woken);
+}
+//Sampler Task: takes one sample per timer tick, also while loop() computes and draws
+void SamplerTask(void *parameter) {
+  while (true) {
+    ulTaskNotifyTake(pdFALSE, portMAX_DELAY); //One sample per pending tick
+    if (acquire_data) {
+      AcquireData();
+    }
+  }
+}
+void StartSampling() {
+  xTaskCreatePinnedToCore(SamplerTask, "Sampler", SAMPLER_STACK_SIZE, NULL,
+                          SAMPLER_PRIORITY, &sampler_task, SAMPLER_CORE);
+  sample_timer = timerBegin(SAMPLE_TIMER, SAMPLE_TIMER_PRESCALER, true);
+  timerAttachInterrupt(sample_timer, onSampleTimer, true);
+  SetSampleRate(analysis.rate);
+  timerAlarmEnable(sample_timer);
+}
+void SetSampleRate(unsigned int rate) {
+  //Test data is already at its final rate
+  oversampling = ((2 == data_mode) or (3 == data_mode)) ? 1 : ADC_OVERSAMPLING;
+  timerAlarmWrite(sample_timer, SAMPLE_TIMER_FREQ / (rate * oversampling), true);
+}
 void AcquireData() {
-  unsigned long current_time = micros();
-  SAMPLE_PERIOD = 1E6 / SAMPLE_FREQ;
-  if (0 == buffer_index) {
-    DrawTimeGraph();
+  float data = 0.00;
+  float response = 0.00;
+  if (0 == data_mode) {
+    data = AcquireHall();
   }
-  if (current_time - last_acquisition >= SAMPLE_PERIOD) {
-    if (sample_start_time != 0) {
-      TIME_BUFFER[buffer_index] = 1E6 / (micros() - sample_start_time);
-    }
-    sample_start_time = micros();
-    float data = 0.00;
-    last_acquisition = current_time;
-    if (0 == data_mode) {
-      data = AcquireHall();
+  else if (1 == data_mode) {
+    data = AcquireAnalog(SIGNAL_PIN);
+  }
+  else if (2 == data_mode) {
+    data = AcquireTest(1);
+  }
+  else if (3 == data_mode) {
+    data = AcquireTest(2);
+  }
+  else if (4 == data_mode) {
+    data = AcquireAnalog(SIGNAL_PIN); //Back to back, the response lags by one conversion
+    response = AcquireAnalog(RESPONSE_PIN);
+  }
+  //One sample per oversampling ticks reaches the buffers
+  if (decimator.ratio() != oversampling) {
+    decimator.setRatio(oversampling);
+    response_decimator.setRatio(oversampling);
+  }
+  //Both decimators see every tick, so they stay in step
+  bool decimated = decimator.update(data, &data);
+  if (4 == data_mode) {
+    response_decimator.update(response, &response);
+  }
+  if (decimated) {
+    if (4 == data_mode) {
+      ekg_filtering = false;
+      WriteBufferPair(data, response);
     }
-    else if (1 == data_mode) {
-      data = AcquireAnalog(SIGNAL_PIN);
+    else if (3 == data_mode) {
+      FilterEKG(data);
     }
-    else if (2 == data_mode) {
-      data = AcquireTest(1);
+    else {
+      ekg_filtering = false;
+      WriteBuffer(data);
     }
-    else if (3 == data_mode) {
-      data = AcquireTest(2);
+  }
+}
+//Windowed sinc band-pass from EKG_FILTER_LOW to EKG_FILTER_HIGH at the EKG data rate
+void DesignEKGFilter() {
+  float low = float(EKG_FILTER_LOW) / DATA_FREQ_set2;
+  float high = float(EKG_FILTER_HIGH) / DATA_FREQ_set2;
+  float middle = (EKG_FILTER_TAPS - 1) / 2.0;
+  for (int i = 0; i < EKG_FILTER_TAPS; i++) {
+    float x = i - middle;
+    float pass = (x == 0) ? 2 * (high - low) : (sin(twoPi * high * x) - sin(twoPi * low * x)) / (PI * x);
+    FILTER_BLOCK[i] = pass * ArduinoFFT<float>::weighingFactor(FFTWindow::Hamming, i, EKG_FILTER_TAPS);
+  }
+  ekg_filter.setFilter(FILTER_BLOCK, EKG_FILTER_TAPS);
+  Serial.printf("EKG Filter: %d taps, %d sample blocks\n", EKG_FILTER_TAPS, ekg_filter.blockSize());
+}
+//Collects a block, filters it in one go and passes it on (adds one block of latency)
+void FilterEKG(float data) {
+  if (!ekg_filtering) { //Start clean after a data mode change
+    ekg_filter.reset();
+    filter_block_index = 0;
+    ekg_filtering = true;
+  }
+  FILTER_BLOCK[filter_block_index++] = data;
+  if (filter_block_index == ekg_filter.blockSize()) {
+    ekg_filter.process(FILTER_BLOCK, FILTER_BLOCK);
+    for (unsigned int i = 0; i < filter_block_index; i++) {
+      WriteBuffer(FILTER_BLOCK[i]);
     }
-    WriteBuffer(data);
+    filter_block_index = 0;
   }
-  return;
 }
 float AcquireAnalog(unsigned int pin) {
   float raw_analog_value = analogRead(pin);
-  float map_analog_value = map(raw_analog_value, 0, 4095, 0.000, 3.300);
+  float map_analog_value = raw_analog_value * 3.300 / 4095; //map() would truncate to whole volts
   return map_analog_value;
 }
+//The sample timer runs at the data rate of the set, so each call steps one point
 float AcquireTest(unsigned int set) {
-  unsigned long current_time = micros();
+  float data_point = 0.00;
   //Sine Data
   if (1 == set) {
-    if (current_time - last_data_point_set1 > DATA_PERIOD_set1) {
-      if (data_index_set1 >= 10000) {
-        data_index_set1 = 0;
-        Serial.println("Reached End of Sine Data.");
-      }
-      current_data_point = set_one[data_index_set1];
-      data_index_set1++;
-      last_data_point_set1 = current_time;
+    if (data_index_set1 >= 10000) {
+      data_index_set1 = 0;
+      Serial.println("Reached End of Sine Data.");
     }
+    data_point = set_one[data_index_set1];
+    data_index_set1++;
   }
   //EKG Data
   else if (2 == set) {
-    if (current_time - last_data_point_set2 > DATA_PERIOD_set2) {
-      if (data_index_set2 >= 10000) {
-        data_index_set2 = 0;
-        Serial.println("Reached End of EKG Data.");
-      }
-      current_data_point = set_two[data_index_set2] * 10.0;
-      data_index_set2++;
-      last_data_point_set2 = current_time;
+    if (data_index_set2 >= 10000) {
+      data_index_set2 = 0;
+      Serial.println("Reached End of EKG Data.");
     }
+    data_point = set_two[data_index_set2] * 10.0;
+    data_index_set2++;
   }
-  return current_data_point;
+  return data_point;
 }
 float AcquireHall() {
   float raw_hall_value = hallRead();
-  float mapped_hall_value = map(raw_hall_value, 0, 500, 0.000, 3.300);
+  float mapped_hall_value = raw_hall_value * 3.300 / 500;
   return mapped_hall_value;
 }
 
 /* BUFFER LOGIC*/
 void ResetBuffers() {
-  memset(DATA_BUFFER, 0, BUFFER_SIZE);
-  memset(COMPLEX_BUFFER, 0, BUFFER_SIZE);
+  memset(DATA_BUFFER, 0, BUFFER_SIZE * sizeof(float));
 }
+//Called from the sampler task for every sample
 void WriteBuffer(float data) {
-  if(buffer_index < BUFFER_SIZE) {
-    DATA_BUFFER[buffer_index] = data;
-    COMPLEX_BUFFER[buffer_index] = 0;
-    PlotTimeGraph(buffer_index, data);
-    buffer_index++;
+  ApplyStreamChange();
+  if (zoom_active) {
+    FFTComplex<float> baseband;
+    if (zoom.update(data, &baseband)) {
+      stft.push(&baseband.re, 2); //I and Q together
+    }
   }
   else {
-    acquire_data = false;
-    RunFFT();
-    buffer_index = 0;
-    ResetBuffers();
+    stft.push(data); //Counted as an overrun if the ring buffer is full
+  }
+  PublishFrame();
+  bin_tracker.update(data);
+}
+//Called from the sampler task for every reference / response pair
+void WriteBufferPair(float reference, float response) {
+  ApplyStreamChange();
+  float pair[2] = {reference, response};
+  stft.push(pair, 2); //Both channels together, like the zoomed I/Q pairs
+  PublishFrame();
+}
+//Cuts each complete frame into the free half of the ping-pong pair; if loop() is still busy, the unread frame is dropped
+void PublishFrame() {
+  if (stft.frameReady()) {
+    Frame *frame = frames.acquire();
+    frame->end = stft.samples() - (stft.available() - stft.frameSize());
+    stft.nextFrame(frame->data, &frame->mean);
+    frames.publish(frame);
+  }
+}
+//Apply zoom, data mode and analysis plan changes between samples, so no frame mixes two streams
+void ApplyStreamChange() {
+  if (stream_change_pending) {
+    const AnalysisConfig &config = requested_analysis;
+    SetSampleRate(config.rate);
+    zoom.configure(config.rate, zoom_center_freq, zoom_decimation);
+    bin_tracker.setSamplingFrequency(config.rate); //The tracker is only updated by this task
+    stft.setFrameSize(config.size);
+    stft.setHop(FrameHop(config));
+    dual_active = (4 == data_mode);
+    zoom_active = zoom_requested and (false == dual_active);
+    stft.discard(); //Don't mix samples of different streams in one frame
+    frames.discard();
+    stream_change_pending = false;
+    stream_generation++;
   }
 }
 
+/* ANALYSIS PLAN LOGIC*/
+//Build the tables of every size in use before the sampler task starts, so neither core adds to the plan cache while the other reads it
+void PrewarmPlans() {
+  for (unsigned int size = MIN_BUFFER_SIZE; size <= BUFFER_SIZE; size *= 2) {
+    bool built = (NULL != FFTPlan<float>::get(size, FFTDirection::Forward)); //Real frames and constant-Q kernels
+    built = (NULL != FFTPlan<float>::get(size / 2, FFTDirection::Forward)) and built; //Zoom and dual analog pairs
+    if (false == built) {
+      Serial.printf("FFT Plans: No Room for %u Samples (raise FFT_PLAN_CACHE_SIZE)\n", size);
+    }
+  }
+  //Chirp-Z of the largest frame, and the EKG filter blocks on the sampler core (its forward size is among the frame sizes)
+  bool built = (NULL != FFTPlan<float>::get(2 * BUFFER_SIZE, FFTDirection::Forward));
+  built = (NULL != FFTPlan<float>::get(CONVOLVER_SIZE, FFTDirection::Reverse)) and built;
+  if (false == built) {
+    Serial.println("FFT Plans: No Room for the Chirp-Z and Filter Plans (raise FFT_PLAN_CACHE_SIZE)");
+  }
+}
+//Window factors and gains of a plan, into the half of WINDOW_BUFFER loop() is not using; the slow part of a switch, done while the old plan runs on
+void PrepareAnalysis(AnalysisConfig &config) {
+  config.window_factors = (WINDOW_BUFFER == analysis.window_factors) ? WINDOW_BUFFER + BUFFER_SIZE / 2 : WINDOW_BUFFER;
+  for (int i = 0; i < config.size / 2; i++) {
+    config.window_factors[i] = ArduinoFFT<float>::weighingFactor(config.window, i, config.size);
+  }
+  config.spectrum_gain = ArduinoFFT<float>::coherentScale(config.window, config.size);
+  config.zoom_spectrum_gain = ArduinoFFT<float>::coherentScale(config.window, config.size / 2);
+}
+//One change at a time: the sampler task reads requested_analysis until it switched streams, loop() until it took the switch up
+void RequestAnalysis() {
+  if ((false == analysis_queued) or stream_change_pending or (stream_generation != displayed_stream_generation)) {
+    return;
+  }
+  PrepareAnalysis(next_analysis);
+  requested_analysis = next_analysis;
+  analysis_queued = false;
+  analysis_requested = true;
+  stream_change_pending = true; //Applied by the sampler task before its next sample
+}
+//Takes up the plan of the new stream: counts and pointers change, nothing is allocated or rebuilt
+void ApplyAnalysis() {
+  unsigned long start = micros();
+  analysis = requested_analysis;
+  analysis_requested = false;
+  welch.setBins(analysis.size / 2 + 1);
+  welch.setAveraging(analysis.averaging, analysis.frames, analysis.alpha);
+  cross.setBins(analysis.size / 4 + 1);
+  cross.setAveraging(analysis.averaging, analysis.frames, analysis.alpha);
+  constant_q_welch.setAveraging(analysis.averaging, analysis.frames, analysis.alpha);
+  constant_q_freq = 0; //Kernels for the new frame with the next log scale frame
+  capture_valid = false; //Cut at the old size or rate
+  timeseries_x_max = analysis.size;
+  timeseries_x_inc = timeseries_x_max / 10;
+  frequency_x_max = analysis.size / 2;
+  frequency_x_inc = analysis.size / 20;
+  unsigned long elapsed = micros() - start;
+  ReportAnalysis(analysis);
+  Serial.printf("Analysis Plan Switched in %luus\n", elapsed);
+}
+void ReportAnalysis(const AnalysisConfig &config) {
+  Serial.printf("Analysis: %u samples at %uHz (%.3fHz bins), %s window, %u%% overlap (hop %u), ", config.size, config.rate,
+                float(config.rate) / config.size, WINDOW_NAMES[static_cast<int>(config.window)], config.overlap, FrameHop(config));
+  if (FFTAveraging::Linear == config.averaging) {
+    Serial.printf("linear average of %u frames\n", config.frames);
+  }
+  else {
+    Serial.printf("exponential average, alpha %.3f\n", config.alpha);
+  }
+}
+//Frame advance in samples, rounded down to even so zoom I/Q and dual analog pairs never straddle two frames; an overlap accepted at one size can give an odd hop at a smaller one
+unsigned int FrameHop(const AnalysisConfig &config) {
+  return (config.size * (100 - config.overlap) / 100) & ~1u;
+}
+
 /* FFT LOGIC*/
 void RunFFT() {
-  FFT.windowing(FFTWindow::Hamming, FFTDirection::Forward);
-  FFT.dcRemoval(DATA_BUFFER, BUFFER_SIZE);
-  FFT.compute(DATA_BUFFER,
-              COMPLEX_BUFFER,
-              BUFFER_SIZE,
-              BUFFER_POWER,
-              FFTDirection::Forward);
-  FFT.complexToMagnitude();
-  PlotFrequencyGraph();
-  float average_sample_freq = 0;
-  for(int i=1; i<BUFFER_SIZE; i++) {
-    average_sample_freq += TIME_BUFFER[i];
+  bool heart_rate_frame = (3 == data_mode) and (false == zoom_displayed);
+  if (heart_rate_frame) {
+    UpdateHeartRateHistory(); //Before the transform overwrites the frame
   }
-  average_sample_freq /= BUFFER_SIZE;
+  if (zoom_displayed) {
+    //size / 2 complex baseband samples, magnitudes from the band start up
+    zoom.compute(reinterpret_cast<FFTComplex<float> *>(frame_data), analysis.size / 2, analysis.window, FFTScale::Decibel,
+                 analysis.zoom_spectrum_gain);
+  }
+  else if (czt_displayed and ComputeChirpZ()) {
+    frame_data = CZT_REAL; //Band spectrum in dB (the full spectrum below if out of memory)
+  }
+  else if (log_displayed) {
+    //Only the frame mean removed, the kernels carry their own windows
+    for (int i = 0; i < analysis.size; i++) {
+      frame_data[i] -= frame_mean;
+    }
+    FFT.computeReal(frame_data, analysis.size);
+    constant_q.transform(frame_data, CQ_REAL, CQ_IMAG);
+    constant_q_welch.add(CQ_REAL, CQ_IMAG);
+    constant_q_welch.spectrum(frame_data, FFTScale::Decibel); //A sinusoid of amplitude A reads 20log10(A) dB in its band
+  }
+  else {
+    //Remove the frame mean, window and bit reverse in one pass
+    FFT.prepare(frame_data, analysis.size, FFTWindow::Precompiled, frame_mean, analysis.window_factors);
+    FFT.computeReal(frame_data, analysis.size, true);
+    welch.addReal(frame_data);
+    welch.spectrum(frame_data, FFTScale::Decibel, analysis.spectrum_gain); //Averaged spectrum up to Nyquist, in dB
+  }
+  //Find the strongest tones before the plot normalizes the spectrum (parabolic fit on dB)
+  float peak_offset = 0;
+  if (zoom_displayed) {
+    peak_offset = zoom.bandStart();
+    peak_finder.find(frame_data, analysis.size / 2, (zoom.bandEnd() - zoom.bandStart()) / (analysis.size / 2), PEAK_THRESHOLD_DB);
+  }
+  else if (czt_displayed) {
+    peak_offset = czt_start_freq;
+    peak_finder.find(frame_data, CZT_POINTS, (czt_end_freq - czt_start_freq) / (CZT_POINTS - 1), PEAK_THRESHOLD_DB);
+  }
+  else if (log_displayed) {
+    peak_finder.find(frame_data, constant_q.bands(), 1, PEAK_THRESHOLD_DB); //Peak positions in (fractional) bands
+  }
+  else {
+    peak_finder.find(frame_data, analysis.size / 2 + 1, float(analysis.rate) / analysis.size, PEAK_THRESHOLD_DB);
+  }
+  PlotFrequencyGraph();
+  //Sample rate measured over the samples pushed since the previous frame
+  unsigned long current_time = micros();
+  uint32_t current_samples = stft.samples();
+  float average_sample_freq = 1E6 * (current_samples - last_frame_samples) / float(current_time - last_frame_time);
+  last_frame_time = current_time;
+  last_frame_samples = current_samples;
   Serial.printf("Average Sample Rate: %.2fHz\n", average_sample_freq);
-  Serial.printf("Maximum Magnitude: %.0f\n", frequency_magnitude_max);
+  Serial.printf("Peak Level: %.1fdB\n", frequency_magnitude_max);
+  Serial.printf("Dropped Samples: %u\n", (unsigned int)stft.overruns());
+  Serial.printf("Dropped Frames: %u of %u\n", (unsigned int)frames.dropped(), (unsigned int)frames.published());
+  for (int i = 0; i < peak_finder.peaks(); i++) {
+    float peak_freq = log_displayed ? constant_q.frequency(peak_finder.peak(i).frequency) : peak_offset + peak_finder.peak(i).frequency;
+    Serial.printf("Peak %d: %.2fHz %.1fdB\n", i + 1, peak_freq, peak_finder.peak(i).magnitude);
+  }
+  for (int i = 0; i < bin_tracker.bins(); i++) {
+    Serial.printf("Tracked %.2fHz: %.2f\n", bin_tracker.frequency(i), bin_tracker.magnitude(i));
+  }
+  if (heart_rate_frame) {
+    EstimateHeartRate();
+  }
+}
+
+//Kernels for log-spaced bands from CQ_MIN_FREQ up to Nyquist at the current sample rate, rebuilt after rate changes
+void ConfigureConstantQ() {
+  float max_freq = min(analysis.rate / 2.0, CQ_MIN_FREQ * pow(2.0, (CQ_MAX_BANDS - 1) / float(CQ_BANDS_PER_OCTAVE)));
+  constant_q_welch.reset();
+  if (false == constant_q.configure(analysis.size, analysis.rate, CQ_MIN_FREQ, max_freq, CQ_BANDS_PER_OCTAVE)) {
+    Serial.println("Constant-Q: Out of Memory, Log Frequency Scale Off");
+    log_requested = false;
+    log_displayed = false;
+    constant_q_freq = 0;
+    return;
+  }
+  constant_q_freq = analysis.rate;
+  Serial.printf("Constant-Q: %d bands from %.1fHz, Q %.1f, %u kernel values\n", (int)constant_q.bands(), constant_q.frequency(0),
+                constant_q.q(), (unsigned int)constant_q.nonZeros());
+}
+//Spectrum of the captured frame from czt_start_freq to czt_end_freq into CZT_REAL, in dB like the full spectrum
+bool ComputeChirpZ() {
+  if (false == chirp_z.configure(analysis.size, CZT_POINTS, czt_start_freq, czt_end_freq, capture_freq)) {
+    Serial.println("Chirp-Z: Out of Memory, Band Off");
+    czt_requested = false;
+    czt_displayed = false;
+    return false;
+  }
+  for (int i = 0; i < analysis.size; i++) {
+    CZT_REAL[i] = CAPTURE_BUFFER[i] - capture_mean;
+    CZT_IMAG[i] = 0;
+  }
+  FFT.windowing(CZT_REAL, analysis.size, FFTWindow::Precompiled, FFTDirection::Forward, analysis.window_factors);
+  chirp_z.compute(CZT_REAL, CZT_IMAG);
+  for (int i = 0; i < CZT_POINTS; i++) {
+    CZT_REAL[i] = sq(CZT_REAL[i]) + sq(CZT_IMAG[i]);
+  }
+  ArduinoFFT<float>::powerToSpectrum(CZT_REAL, CZT_REAL, CZT_POINTS, FFTScale::Decibel, analysis.spectrum_gain); //Same gain as the full spectrum, so levels match
+  return true;
+}
+//Appends the samples of the frame that are not in HEART_RATE_HISTORY yet, so the history spans more than a small frame; starts over after a gap
+void UpdateHeartRateHistory() {
+  unsigned int fresh = frame_end - heart_rate_end;
+  if ((0 == heart_rate_count) or (fresh > analysis.size)) {
+    //First frame, or frames were dropped or the stream changed: only this frame's samples are consecutive
+    heart_rate_count = 0;
+    fresh = analysis.size;
+  }
+  if (fresh > HEART_RATE_SAMPLES) {
+    fresh = HEART_RATE_SAMPLES;
+  }
+  memmove(HEART_RATE_HISTORY, HEART_RATE_HISTORY + fresh, (HEART_RATE_SAMPLES - fresh) * sizeof(float));
+  memcpy(HEART_RATE_HISTORY + HEART_RATE_SAMPLES - fresh, frame_data + analysis.size - fresh, fresh * sizeof(float));
+  heart_rate_count = min(heart_rate_count + fresh, (unsigned int)HEART_RATE_SAMPLES);
+  heart_rate_end = frame_end;
+}
+void EstimateHeartRate() {
+  if (heart_rate_count < HEART_RATE_SAMPLES) {
+    return; //Fills within 5.1s; the longest beat searched needs most of it
+  }
+  //Autocorrelation of the history, zero-padded to BUFFER_SIZE, lags 0 to HEART_RATE_SAMPLES
+  memcpy(DATA_BUFFER, HEART_RATE_HISTORY, HEART_RATE_SAMPLES * sizeof(float));
+  FFT.autocorrelate(DATA_BUFFER, 2 * HEART_RATE_SAMPLES);
+  if (heart_rate.estimate(DATA_BUFFER, HEART_RATE_SAMPLES + 1, HEART_RATE_SAMPLES, analysis.rate)) {
+    Serial.printf("Heart Rate: %.1f BPM (confidence %.2f)\n", 60 * heart_rate.frequency(), heart_rate.confidence());
+  }
+  else if (heart_rate.confidence() > 0) {
+    //A peak too weak to trust, e.g. from electrode movement
+    Serial.printf("Heart Rate: no clear beat (confidence %.2f)\n", heart_rate.confidence());
+  }
+  else {
+    Serial.printf("Heart Rate: no beat found\n");
+  }
+}
+void RunCrossSpectrum() {
+  const int bins = analysis.size / 4 + 1;
+  //Both channels of the size / 2 pairs through one complex FFT, averaged like the Welch spectrum
+  cross.add(reinterpret_cast<FFTComplex<float> *>(frame_data), analysis.window);
+  //The strongest reference bin is the stimulus of a network measurement
+  cross.referenceSpectrum(frame_data, FFTScale::Power);
+  int stimulus = 1;
+  for (int i = 2; i < bins; i++) {
+    if (frame_data[i] > frame_data[stimulus]) {
+      stimulus = i;
+    }
+  }
+  //Transfer function gain for the graph, phase and coherence behind it
+  float *phase = frame_data + bins;
+  float *coherence = frame_data + 2 * bins;
+  cross.transfer(frame_data, phase, FFTScale::Decibel);
+  cross.coherence(coherence);
+  Serial.printf("Dropped Samples: %u\n", (unsigned int)stft.overruns());
+  Serial.printf("Dropped Frames: %u of %u\n", (unsigned int)frames.dropped(), (unsigned int)frames.published());
+  Serial.printf("Transfer at %.2fHz: %.1fdB %.1fdeg (coherence %.2f, %d frames)\n", stimulus * analysis.rate / (analysis.size / 2.0),
+                frame_data[stimulus], phase[stimulus] * 180 / PI, coherence[stimulus], (int)cross.frames());
+  PlotFrequencyGraph();
+}
+
+/* MEMORY LOGIC*/
+//Blocks of the heap for everything built after startup, so the heap never fragments; PSRAM behind them if present
+void ReserveTableMemory() {
+  if (memory.failures() > 0) {
+    Serial.println("Memory: BUFFER_ARENA_SIZE Too Small for the Buffers");
+    ReportMemory();
+    while (true) {
+      delay(1000);
+    }
+  }
+  if (false == memory.addPool(malloc(TABLE_ARENA_SIZE), TABLE_ARENA_SIZE, ArenaPlacement::Internal)) {
+    Serial.println("Memory: Table Arena Not Reserved, Tables on the Heap");
+    return;
+  }
+  for (int i = 1; i < TABLE_ARENA_BLOCKS; i++) {
+    memory.addPool(malloc(TABLE_ARENA_SIZE), TABLE_ARENA_SIZE, ArenaPlacement::Internal);
+  }
+#if defined(BOARD_HAS_PSRAM)
+  if (psramFound()) {
+    memory.addPool(ps_malloc(PSRAM_ARENA_SIZE), PSRAM_ARENA_SIZE, ArenaPlacement::External);
+  }
+#endif
+  fftSetAllocator(AllocateTable, ReleaseTable);
+  TFT_eSprite::setMemoryHooks(AllocateSprite, ReleaseTable);
+}
+//The arena is not safe on both cores at once, so every hook holds memory_lock (only for the first-fit scan, a few microseconds)
+void *AllocateTable(size_t bytes, const char *name) {
+  portENTER_CRITICAL(&memory_lock);
+  void *pointer = memory.allocate(bytes, name, ArenaPlacement::PreferInternal);
+  portEXIT_CRITICAL(&memory_lock);
+  return pointer;
+}
+void *AllocateSprite(size_t bytes, bool psram) {
+  portENTER_CRITICAL(&memory_lock);
+  void *pointer = memory.allocate(bytes, "Sprite", psram ? ArenaPlacement::PreferExternal : ArenaPlacement::Internal);
+  portEXIT_CRITICAL(&memory_lock);
+  return pointer;
+}
+//Blocks allocated before the hooks were set came from the heap
+void ReleaseTable(void *pointer) {
+  portENTER_CRITICAL(&memory_lock);
+  bool released = memory.release(pointer);
+  portEXIT_CRITICAL(&memory_lock);
+  if (false == released) {
+    free(pointer);
+  }
+}
+void ReportMemory() {
+  for (int i = 0; i < memory.pools(); i++) {
+    Serial.printf("Memory Pool %d (%s): %u of %u bytes used, high-water %u\n", i,
+                  (ArenaPlacement::External == memory.placement(i)) ? "PSRAM" : "Internal",
+                  (unsigned int)memory.used(i), (unsigned int)memory.capacity(i), (unsigned int)memory.highWater(i));
+  }
+  for (int i = 0; i < memory.regions(); i++) {
+    const ArenaRegion &region = memory.region(i);
+    Serial.printf("  %-18s %6u bytes in pool %d\n", region.name, (unsigned int)region.bytes, region.pool);
+  }
+  Serial.printf("Memory Failures: %u\n", (unsigned int)memory.failures());
 }
 
 /* LED LOGIC*/
@@ -0,0 +1,76 @@
+/*
+ * Project: ESP32 Low-Frequency Spectrum Analyzer
+ * Description: Host check of the plan kernels of the FFT library against the recurrence kernel, on every frame of the
+ * sine and EKG test captures. Build and run it with make check in this folder.
+ */
+
+#include "arduinoFFT.h"
+#include <math.h>
+#include <stdio.h>
+#include <test_data_1.h>
+#include <test_data_2.h>
+
+#define FRAME_SIZE 2048 //Frame size of the analyzer
+#define HOP_SIZE 512
+#define DATA_LENGTH 10000
+//Largest difference of a bin, relative to the largest magnitude of the frame. The float recurrence drifts by a few
+//1e-4 over 2048 points; in double precision it is exact to float rounding.
+#define FLOAT_TOLERANCE 1e-3
+#define DOUBLE_TOLERANCE 1e-5
+
+float frame_real[FRAME_SIZE];
+float frame_imag[FRAME_SIZE];
+float float_real[FRAME_SIZE];
+float float_imag[FRAME_SIZE];
+double double_real[FRAME_SIZE];
+double double_imag[FRAME_SIZE];
+
+//Worst relative difference between the kernel and the float and double recurrence over the frames of a capture
+void CompareKernel(const float *data, FFTKernel kernel, float *float_worst, float *double_worst) {
+  ArduinoFFT<float> fft;
+  fft.setKernel(kernel);
+  ArduinoFFT<float> float_reference;
+  float_reference.setKernel(FFTKernel::Recurrence);
+  ArduinoFFT<double> double_reference;
+  double_reference.setKernel(FFTKernel::Recurrence);
+  *float_worst = 0;
+  *double_worst = 0;
+  for (int offset = 0; offset + FRAME_SIZE <= DATA_LENGTH; offset += HOP_SIZE) {
+    for (int i = 0; i < FRAME_SIZE; i++) {
+      frame_real[i] = float_real[i] = double_real[i] = data[offset + i];
+      frame_imag[i] = float_imag[i] = double_imag[i] = 0.0;
+    }
+    fft.compute(frame_real, frame_imag, FRAME_SIZE, FFTDirection::Forward);
+    float_reference.compute(float_real, float_imag, FRAME_SIZE, FFTDirection::Forward);
+    double_reference.compute(double_real, double_imag, FRAME_SIZE, FFTDirection::Forward);
+    double largest = 0;
+    double float_difference = 0;
+    double double_difference = 0;
+    for (int i = 0; i < FRAME_SIZE; i++) {
+      largest = fmax(largest, hypot(double_real[i], double_imag[i]));
+      float_difference = fmax(float_difference, hypot(frame_real[i] - float_real[i], frame_imag[i] - float_imag[i]));
+      double_difference = fmax(double_difference, hypot(frame_real[i] - double_real[i], frame_imag[i] - double_imag[i]));
+    }
+    *float_worst = fmax(*float_worst, float_difference / largest);
+    *double_worst = fmax(*double_worst, double_difference / largest);
+  }
+}
+
+int main() {
+  const char *capture_names[] = {"Sine", "EKG"};
+  const float *captures[] = {set_one, set_two};
+  const char *kernel_names[] = {"Radix2", "Radix4"};
+  const FFTKernel kernels[] = {FFTKernel::Radix2, FFTKernel::Radix4};
+  int failures = 0;
+  for (int c = 0; c < 2; c++) {
+    for (int k = 0; k < 2; k++) {
+      float float_worst, double_worst;
+      CompareKernel(captures[c], kernels[k], &float_worst, &double_worst);
+      bool pass = (float_worst <= FLOAT_TOLERANCE) and (double_worst <= DOUBLE_TOLERANCE);
+      printf("%s test data: %s vs Recurrence, relative difference %.2e (float), %.2e (double) %s\n", capture_names[c],
+             kernel_names[k], float_worst, double_worst, pass ? "PASS" : "FAIL");
+      failures += pass ? 0 : 1;
+    }
+  }
+  return (failures > 0) ? 1 : 0;
+}